@@ -23,6 +23,7 @@
 #include <pthread.h>
 
 #include "lib_exprs.h"
+#include "lib_hashtbl.h"
 #include "exprs_test.h"
 
 typedef struct
@@ -41,6 +42,10 @@ static const TestExprs_t TestExprs[] =
 {
 	{ "\"plainString\"", EXPRS_TERM_STRING, 0, 0, "plainString", EXPR_TERM_GOOD }, /* Text string (text delimited with quotes) */
 	{ "\"plain\\\"S\\\"tring\"", EXPRS_TERM_STRING, 0, 0, "plain\"S\"tring", EXPR_TERM_GOOD }, /* Text string (text delimited with quotes) */
+	{ "\"A string long enough to need more than one 32 byte block\"", EXPRS_TERM_STRING, 0, 0, "A string long enough to need more than one 32 byte block", EXPR_TERM_GOOD }, /* long text string */
+	{ "'Escapes \\t and \\\\ after the first 16 bytes, then `backquotes` and \"quotes\"'", EXPRS_TERM_STRING, 0, 0, "Escapes \t and \\ after the first 16 bytes, then `backquotes` and \"quotes\"", EXPR_TERM_GOOD }, /* single quoted string */
+	{ "\"No terminator on this string even though it is a long one", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_NO_STRING_TERM }, /* missing quote */
+	{ "            1                                        +       \t\t\t   2          ", EXPRS_TERM_INTEGER, 3, 0, NULL, EXPR_TERM_GOOD }, /* padded operands */
 	{ "'plainString'", EXPRS_TERM_STRING, 0, 0, "plainString", EXPR_TERM_GOOD }, /* Text string (text delimited with quotes) */
 	{ "3.14159", EXPRS_TERM_FLOAT, 0, 3.14159, NULL, EXPR_TERM_GOOD },	/* floating point number */
 	{ "100", EXPRS_TERM_INTEGER, 100, 0, NULL, EXPR_TERM_GOOD },	/* integer number */
@@ -81,6 +86,8 @@ static const TestExprs_t TestExprs[] =
 	{ "1.2+2.3", EXPRS_TERM_FLOAT, 0, 3.5, NULL, EXPR_TERM_GOOD },	// EXPRS_TERM_ADD,	/* + (binary term in this case) */
 	{ "1.2+\"2.3\"", EXPRS_TERM_STRING, 0, 0, "1.22.3", EXPR_TERM_GOOD },	// EXPRS_TERM_PLUS,	/* + (binary term in this case) */
 	{ "\"2.3\"+1.2", EXPRS_TERM_STRING, 0, 0, "2.31.2", EXPR_TERM_GOOD },	// EXPRS_TERM_PLUS,	/* + (binary term in this case) */
+	{ "\"x\"+-1234567890+\"y\"", EXPRS_TERM_STRING, 0, 0, "x-1234567890y", EXPR_TERM_GOOD },	// EXPRS_TERM_PLUS,	/* + (binary term in this case) */
+	{ "\"f\"+0.000125+\",\"+1.5e20", EXPRS_TERM_STRING, 0, 0, "f0.000125,1.5e+20", EXPR_TERM_GOOD },	// EXPRS_TERM_PLUS,	/* + (binary term in this case) */
 	{ "2-1", EXPRS_TERM_INTEGER, 1, 0, NULL, EXPR_TERM_GOOD }, // EXPRS_TERM_SUB,	/* - (unary term in this case) */
 	{ "2.0-1", EXPRS_TERM_FLOAT, 0, 1.0, NULL, EXPR_TERM_GOOD }, // EXPRS_TERM_SUB,	/* - (unary term in this case) */
 	{ "2-1.0", EXPRS_TERM_FLOAT, 0, 1.0, NULL, EXPR_TERM_GOOD }, // EXPRS_TERM_SUB,	/* - (unary term in this case) */
@@ -203,6 +210,16 @@ static const TestExprs_t TestExprs[] =
 	{ "0.0||1", EXPRS_TERM_INTEGER, 1, 0, NULL, EXPR_TERM_GOOD }, // EXPRS_TERM_LOR,	/* || */
 	{ "0||1.9", EXPRS_TERM_INTEGER, 1, 0, NULL, EXPR_TERM_GOOD }, // EXPRS_TERM_LOR,	/* || */
 	{ "0.0||1.9", EXPRS_TERM_INTEGER, 1, 0, NULL, EXPR_TERM_GOOD }, // EXPRS_TERM_LOR,	/* || */
+	{ "0&&1/0", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },		/* right side of && is skipped */
+	{ "2.5||1/0", EXPRS_TERM_INTEGER, 1, 0, NULL, EXPR_TERM_GOOD },		/* right side of || is skipped */
+	{ "1&&0||3&&(0||4)", EXPRS_TERM_INTEGER, 1, 0, NULL, EXPR_TERM_GOOD },
+	{ "1&&1/0", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_DIV_BY_0 },
+	{ "1||2 3", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_TOO_FEW_TERMS },	/* a right side that isn't one operand is never skipped */
+	{ "0&&2 3", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_TOO_FEW_TERMS },
+	{ "1||(2 3)", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_TOO_FEW_TERMS },
+	
+	{ "1.5e +2", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_NO_SYMBOLS },	/* 'e' is a symbol. The space must not be squeezed out by the cache */
+	{ "1e -1", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_NO_SYMBOLS },
 	
 	{ "1+(2+3)*4", EXPRS_TERM_INTEGER, 1+(2+3)*4, 0, NULL, EXPR_TERM_GOOD },	/* Test parenthesis */
 	{ "1+2*3/4-6", EXPRS_TERM_INTEGER, 1+2*3/4-6, 0, NULL, EXPR_TERM_GOOD },	/* Test precedence */
@@ -238,6 +255,19 @@ static const TestExprs_t TestExprs[] =
 	{ "456O", EXPRS_TERM_INTEGER, 0456, 0, NULL, EXPR_TERM_GOOD, EXPRS_FLG_O_OCTAL },			/* integer number */
 	{ "123q", EXPRS_TERM_INTEGER, 0123, 0, NULL, EXPR_TERM_GOOD, EXPRS_FLG_Q_OCTAL },			/* integer number */
 	{ "456Q", EXPRS_TERM_INTEGER, 0456, 0, NULL, EXPR_TERM_GOOD, EXPRS_FLG_Q_OCTAL },			/* integer number */
+	{ "0O+1", EXPRS_TERM_INTEGER, 1, 0, NULL, EXPR_TERM_GOOD, EXPRS_FLG_O_OCTAL },			/* octal 0, not a 0o prefix */
+	{ "0x", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_NUMBER },								/* prefix without digits */
+	{ "0xg", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_NUMBER },
+	{ "0o", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_NUMBER },
+	{ "0o8", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_NUMBER },
+	{ "1+0o8", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_NUMBER },
+	{ "0o8", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_NUMBER, EXPRS_FLG_O_OCTAL },
+	{ "0o17", EXPRS_TERM_INTEGER, 017, 0, NULL, EXPR_TERM_GOOD },
+	{ "17O+1", EXPRS_TERM_INTEGER, 16, 0, NULL, EXPR_TERM_GOOD, EXPRS_FLG_H_HEX|EXPRS_FLG_O_OCTAL|EXPRS_FLG_USE_RADIX, 16 },
+	{ "1AH+10O", EXPRS_TERM_INTEGER, 34, 0, NULL, EXPR_TERM_GOOD, EXPRS_FLG_H_HEX|EXPRS_FLG_O_OCTAL },
+	{ "0xFFFFFFFFFFFFFFFF", EXPRS_TERM_INTEGER, -1, 0, NULL, EXPR_TERM_GOOD },					/* same as FFFFFFFFFFFFFFFFh */
+	{ "(-9223372036854775807-1)/0xFFFFFFFFFFFFFFFF", EXPRS_TERM_INTEGER, -9223372036854775807L-1, 0, NULL, EXPR_TERM_GOOD },	/* wraps rather than trapping */
+	{ "(-9223372036854775807-1)%0xFFFFFFFFFFFFFFFF", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },
 	{ "456.", EXPRS_TERM_INTEGER, 456, 0, NULL, EXPR_TERM_GOOD, EXPRS_FLG_DOT_DECIMAL },		/* integer number */
 	{ "456.123", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_TOO_FEW_TERMS, EXPRS_FLG_DOT_DECIMAL },     /* integer number */
 	{ "2**3", EXPRS_TERM_NULL, 8, 0, NULL, EXPR_TERM_BAD_SYNTAX, EXPRS_FLG_NO_POWER },
@@ -259,6 +289,424 @@ static const TestExprs_t TestSymbols[] =
 	{ "123$", EXPRS_TERM_SYMBOL, EXPRS_TERM_FLAG_LOCAL_SYMBOL, 0, "123$", EXPR_TERM_END, EXPRS_FLG_LOCAL_SYMBOLS },   /* local symbol */
 };
 
+/* Expressions run with a small symbol table that starts out empty for each entry */
+static const TestExprs_t TestSymExprs[] =
+{
+	{ "a=5;b=7;a+b", EXPRS_TERM_INTEGER, 12, 0, NULL, EXPR_TERM_GOOD },
+	{ "b=7;a=5;c=a-b;c", EXPRS_TERM_INTEGER, -2, 0, NULL, EXPR_TERM_GOOD },
+	{ "a=6;a&3", EXPRS_TERM_INTEGER, 2, 0, NULL, EXPR_TERM_GOOD },
+	{ "a=6;b=a<<2|a", EXPRS_TERM_INTEGER, 30, 0, NULL, EXPR_TERM_GOOD },
+	{ "x=1.5;y=x*2;y", EXPRS_TERM_FLOAT, 0, 3.0, NULL, EXPR_TERM_GOOD },
+	{ "s=\"foo\";s+\"bar\"", EXPRS_TERM_STRING, 0, 0, "foobar", EXPR_TERM_GOOD },
+	{ "a=(b=3);a*b", EXPRS_TERM_INTEGER, 9, 0, NULL, EXPR_TERM_GOOD },
+	{ "a=1;-a+~a", EXPRS_TERM_INTEGER, -3, 0, NULL, EXPR_TERM_GOOD },
+	{ "a_rather_long_symbol_name_for_the_lexer$1=5;  a_rather_long_symbol_name_for_the_lexer$2 = 7;a_rather_long_symbol_name_for_the_lexer$1*a_rather_long_symbol_name_for_the_lexer$2", EXPRS_TERM_INTEGER, 35, 0, NULL, EXPR_TERM_GOOD },
+	{ "undefinedSym+1", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_UNDEFINED_SYMBOL },
+	{ "a=0;10/a", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_DIV_BY_0 },
+	{ "3=4", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_LVALUE },
+	{ "a=1;0&&(a=5);a", EXPRS_TERM_INTEGER, 1, 0, NULL, EXPR_TERM_GOOD },
+	{ "a=0;a||(a=5);a", EXPRS_TERM_INTEGER, 5, 0, NULL, EXPR_TERM_GOOD },
+	{ "a=0;a&&10/a", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "1||undefinedSym", EXPRS_TERM_INTEGER, 1, 0, NULL, EXPR_TERM_GOOD },
+	{ "c=0;u&255%c", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_DIV_BY_0 },	/* an empty slot is only an error once it is used */
+	{ "0b101", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_TOO_FEW_TERMS },
+	{ "c=1;big=2;neg=0-1;b101=3;c=c&&16||big*neg|c||0b101&&(neg)", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_LVALUE },	/* 0b101 is 0 b101 so the last && can't be skipped */
+};
+
+/* Expressions computed over columns of x (integer), y (float) and z (integer) */
+static const TestExprs_t TestBatchExprs[] =
+{
+	{ "x+z", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "x*y-z", EXPRS_TERM_FLOAT, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "x/(z|1)", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "x%(z|1)", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "y/(z|1)", EXPRS_TERM_FLOAT, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "y%3", EXPRS_TERM_FLOAT, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "x<<3>>1", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "~x^z&255", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "x>y", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "x<=z", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "y>=z+0.5", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "x!=z*100", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "!x||z&&y", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "x**2", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "-x+ +y", EXPRS_TERM_FLOAT, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "x<<(z&7)", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "(x-z>=0)+(x<z)+(x==z)+(x>z)", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "x&&z||(x|z)^7", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "z&&x/z", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },	/* computed a row at a time */
+	{ "(y*y-y/3)+(y<=-1.5)+(y==0.5)+(y!=y*2)", EXPRS_TERM_FLOAT, 0, 0, NULL, EXPR_TERM_GOOD },
+	{ "x/z", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_BAD_DIV_BY_0 },
+	{ "y%z", EXPRS_TERM_FLOAT, 0, 0, NULL, EXPR_TERM_BAD_DIV_BY_0 },
+	{ "a=x;a*2", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },	/* computed a row at a time */
+	{ "y*2;z", EXPRS_TERM_INTEGER, 0, 0, NULL, EXPR_TERM_GOOD },	/* computed a row at a time */
+};
+
+#define TEST_BATCH_ROWS (1000)
+
+/* Number of RPN terms expected after parsing with EXPRS_FLG_FOLD_CONSTANTS */
+typedef struct
+{
+	const char *expr;
+	int numTerms;
+} TestFold_t;
+
+static const TestFold_t TestFoldExprs[] =
+{
+	{ "base+(4*8)+(1<<3)", 5 },		/* base 32 + 8 + */
+	{ "1+2*3-4", 1 },
+	{ "-5+~0", 1 },
+	{ "\"ab\"+\"cd\"", 1 },
+	{ "2.5*2+x", 3 },
+	{ "x+1+2", 5 },					/* (x+1)+2 is not a constant subexpression */
+	{ "10/0+1", 5 },				/* left for the run to report divide by 0 */
+	{ "3=4", 3 },					/* never fold an assignment */
+	{ "0&&x", 1 },					/* left side decides it */
+	{ "1||x", 1 },
+	{ "1&&x", 3 },					/* skip term dropped */
+	{ "x||2*3", 4 },
+};
+
+/* Formulas handed to libExprsDepsAdd() in order. Each is accepted or not. */
+typedef struct
+{
+	const char *formula;
+	ExprsErrs_t status;
+} TestDepsFormula_t;
+
+static const TestDepsFormula_t TestDepsFormulas[] =
+{
+	{ "c=a+b", EXPR_TERM_GOOD },
+	{ "d=c*2", EXPR_TERM_GOOD },
+	{ "e=d-a", EXPR_TERM_GOOD },
+	{ "f=b+1", EXPR_TERM_GOOD },
+	{ "d2=t+1;t=a*3", EXPR_TERM_GOOD },		/* t is read before it is assigned */
+	{ "a=e+1", EXPR_TERM_BAD_CYCLE },		/* e is computed from a */
+	{ "g=f;b=g", EXPR_TERM_BAD_CYCLE },		/* f is computed from b */
+};
+
+/* Then each of these is evaluated, the symbol noted as changed and the formulas updated */
+typedef struct
+{
+	const char *change;
+	const char *changed;
+	int numRun;								/* number of formulas that should have been run */
+	const char *sym;						/* symbol to check afterwards */
+	long value;
+	ExprsErrs_t status;						/* expected from libExprsDepsUpdate() */
+} TestDepsStep_t;
+
+static const TestDepsStep_t TestDepsSteps[] =
+{
+	{ "a=1;b=2;t=0", NULL, 5, "e", 5 },		/* all are new so all are run */
+	{ "a=5", "a", 4, "e", 9 },
+	{ "b=10", "b", 4, "f", 11 },
+	{ "z=1", "z", 0, "d", 30 },				/* nothing reads z */
+	{ "t=50", "t", 1, "d2", 51 },
+};
+
+/* A formula that fails must not hold back the ones that don't depend on it */
+static const TestDepsFormula_t TestDepsFailFormulas[] =
+{
+	{ "b=a+1", EXPR_TERM_GOOD },
+	{ "c=b*2", EXPR_TERM_GOOD },
+	{ "k=100/g", EXPR_TERM_GOOD },
+};
+
+static const TestDepsStep_t TestDepsFailSteps[] =
+{
+	{ "a=1;g=4", NULL, 3, "c", 4 },
+	{ "g=0", "g", 0, "k", 25, EXPR_TERM_BAD_DIV_BY_0 },
+	{ "a=5", "a", 2, "c", 12, EXPR_TERM_BAD_DIV_BY_0 },	/* k is still failing */
+	{ "g=5", "g", 1, "k", 20 },
+	{ "z=1", "z", 0, "c", 12 },
+};
+
+/* Scripts run in turn and then a wave at a time over several threads. Errors, results and symbols have to match. */
+static const struct
+{
+	const char *script;
+	const char *syms;						/* symbols expected afterwards (NULL to only compare the two runs) */
+} TestWaveScripts[] =
+{
+	{ "a=1;b=2;c=a+b;d=a*b;e=c+d;f=7;g=f*2;a=10;h=a+e;e", NULL },
+	{ "s=\"foo\";t=s+\"bar\";u=\"x\";v=u+t;w=1.5;w*2;v", NULL },
+	{ "a=5;b=a;a=b+1;b=a*2;c=b+a;c", NULL },
+	{ "p=1;q=2;r=3;s=4;t=5;u=p+q;v=r+s;w=t+u;x=v+w;y=x*2;z=y-1;z", NULL },
+	{ "x=(y=2)*y;z=x+1;w=(v=\"a\")+v;z", "v=\"a\" w=\"aa\" x=4 y=2 z=5 " },
+	{ "a=1;b=a/0;c=2;d=c+1", "a=1 " },
+	{ "x=1/0;y=5;z=6;w=7", "" },			/* nothing after the failure is assigned */
+};
+
+/* Only the first 'len' characters are given to libExprsEvalN() and libExprsCompileN(). What follows must not change the answer. */
+static const struct
+{
+	int len;
+	TestExprs_t exp;
+} TestSpanExprs[] =
+{
+	{ 5, { "1+2*3;9999", EXPRS_TERM_INTEGER, 7, 0, NULL, EXPR_TERM_GOOD } },
+	{ 3, { "123456", EXPRS_TERM_INTEGER, 123, 0, NULL, EXPR_TERM_GOOD } },
+	{ 4, { "0x1fff", EXPRS_TERM_INTEGER, 31, 0, NULL, EXPR_TERM_GOOD } },
+	{ 3, { "1.25e3", EXPRS_TERM_FLOAT, 0, 1.2, NULL, EXPR_TERM_GOOD } },
+	{ 11, { "\"abc\"+\"def\"+\"ghi\"", EXPRS_TERM_STRING, 0, 0, "abcdef", EXPR_TERM_GOOD } },
+	{ 8, { "\"abc\"+\"def\"", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_NO_STRING_TERM } },
+	{ 5, { "\"a\\\"b\"", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_NO_STRING_TERM } },
+	{ 4, { "1<<2", EXPRS_TERM_INTEGER, 4, 0, NULL, EXPR_TERM_GOOD } },
+	{ 3, { "1<<2", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_TOO_FEW_TERMS } },
+	{ 7, { "1+2\0" "4*5", EXPRS_TERM_INTEGER, 20, 0, NULL, EXPR_TERM_GOOD } },	/* a null ends a statement, not the text */
+	{ 5, { "\"a\0b\"", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_NO_STRING_TERM } },
+	{ 6, { "\"\\x41\"+\"B\"", EXPRS_TERM_STRING, 0, 0, "A", EXPR_TERM_GOOD } },
+	{ 4, { "\"\\x41\"", EXPRS_TERM_NULL, 0, 0, NULL, EXPR_TERM_BAD_NO_STRING_TERM } },
+};
+
+#define TEST_MAX_SYMS (16)
+
+typedef struct
+{
+	int numSyms;
+	char *names[TEST_MAX_SYMS];
+	ExprsSymTerm_t values[TEST_MAX_SYMS];
+} TestSymTable_t;
+
+static char *dupString(const char *src)
+{
+	size_t len = strlen(src) + 1;
+	char *ans = (char *)malloc(len);
+	if ( ans )
+		memcpy(ans, src, len);
+	return ans;
+}
+
+static void clearTestSyms(TestSymTable_t *tbl)
+{
+	int ii;
+	for (ii=0; ii < tbl->numSyms; ++ii)
+	{
+		free(tbl->names[ii]);
+		if ( tbl->values[ii].termType == EXPRS_SYM_TERM_STRING )
+			free(tbl->values[ii].value.string);
+	}
+	tbl->numSyms = 0;
+}
+
+static ExprsErrs_t getTestSym(void *symArg, const char *name, ExprsSymTerm_t *value)
+{
+	TestSymTable_t *tbl = (TestSymTable_t *)symArg;
+	int ii;
+	for (ii=0; ii < tbl->numSyms; ++ii)
+	{
+		if ( !strcmp(tbl->names[ii], name) )
+		{
+			*value = tbl->values[ii];
+			return EXPR_TERM_GOOD;
+		}
+	}
+	return EXPR_TERM_BAD_UNDEFINED_SYMBOL;
+}
+
+static ExprsErrs_t setTestSym(void *symArg, const char *name, const ExprsSymTerm_t *value)
+{
+	TestSymTable_t *tbl = (TestSymTable_t *)symArg;
+	int ii;
+	for (ii=0; ii < tbl->numSyms; ++ii)
+	{
+		if ( !strcmp(tbl->names[ii], name) )
+			break;
+	}
+	if ( ii >= TEST_MAX_SYMS )
+		return EXPR_TERM_BAD_SYMBOL_TABLE_FULL;
+	if ( ii == tbl->numSyms )
+	{
+		tbl->names[ii] = dupString(name);
+		++tbl->numSyms;
+	}
+	else if ( tbl->values[ii].termType == EXPRS_SYM_TERM_STRING )
+		free(tbl->values[ii].value.string);
+	tbl->values[ii] = *value;
+	if ( value->termType == EXPRS_SYM_TERM_STRING )
+		tbl->values[ii].value.string = dupString(value->value.string);
+	return EXPR_TERM_GOOD;
+}
+
+/* Bind symbols from the top of the slot array down just to prove the slot numbers are honored */
+static ExprsErrs_t bindTestSlot(void *bindArg, const char *name, int *slotP)
+{
+	*slotP = TEST_MAX_SYMS - 1 - *slotP;
+	return *slotP < 0 ? EXPR_TERM_BAD_SYMBOL_TABLE_FULL : EXPR_TERM_GOOD;
+}
+
+static void quietMsg(void *msgArg, ExprsMsgSeverity_t severity, const char *msg)
+{
+}
+
+/* Bind x, y and z to columns 0, 1 and 2. Leave anything else to the symbol table. */
+static ExprsErrs_t bindTestColumn(void *bindArg, const char *name, int *slotP)
+{
+	static const char *Columns[] = { "x", "y", "z" };
+	int ii;
+
+	*slotP = -1;
+	for (ii=0; ii < n_elts(Columns); ++ii)
+	{
+		if ( !strcmp(name, Columns[ii]) )
+			*slotP = ii;
+	}
+	return EXPR_TERM_GOOD;
+}
+
+/* Check libExprsEvalBatch() gets exactly what running each row through libExprsRunSlots() gets */
+static int batchTest(ExprsDef_t *exprs, ExprsCallbacks_t *symCb, TestSymTable_t *symTbl)
+{
+	static long xVals[TEST_BATCH_ROWS], zVals[TEST_BATCH_ROWS], outVals[TEST_BATCH_ROWS];
+	static double yVals[TEST_BATCH_ROWS];
+	ExprsColumn_t columns[3], out;
+	ExprsSymTerm_t slots[3];
+	ExprsProgram_t *prog;
+	ExprsTerm_t result;
+	ExprsErrs_t err, rowErr;
+	const TestExprs_t *pExp;
+	int ii, row, retV=0;
+
+	for (row=0; row < TEST_BATCH_ROWS; ++row)
+	{
+		xVals[row] = row*37 - 5000;
+		yVals[row] = row*0.25 - 17.5;
+		zVals[row] = (row % 301) - 150;
+	}
+	columns[0].termType = EXPRS_SYM_TERM_INTEGER;
+	columns[0].data.s64 = xVals;
+	columns[1].termType = EXPRS_SYM_TERM_FLOAT;
+	columns[1].data.f64 = yVals;
+	columns[2].termType = EXPRS_SYM_TERM_INTEGER;
+	columns[2].data.s64 = zVals;
+	pExp = TestBatchExprs;
+	for (ii=0; ii < n_elts(TestBatchExprs); ++ii, ++pExp)
+	{
+		symCb->msgOut = (pExp->status != EXPR_TERM_GOOD) ? quietMsg : NULL;
+		libExprsSetCallbacks(exprs, symCb, NULL);
+		libExprsSetFlags(exprs, pExp->flags, NULL);
+		libExprsSetRadix(exprs, pExp->radix, NULL);
+		clearTestSyms(symTbl);
+		err = libExprsCompile(exprs, pExp->expr, &prog, 0);
+		if ( !err )
+			err = libExprsBindSymbols(prog, bindTestColumn, NULL);
+		if ( err )
+		{
+			printf("%3d: Batch expression '%s' failed to compile: %s\n", ii, pExp->expr, libExprsGetErrorStr(err));
+			retV = 1;
+			libExprsFreeProgram(prog);
+			continue;
+		}
+		memset(outVals, 0, sizeof(outVals));
+		out.termType = EXPRS_SYM_TERM_NULL;
+		out.data.s64 = outVals;
+		err = libExprsEvalBatch(exprs, prog, TEST_BATCH_ROWS, columns, n_elts(columns), &out, 0);
+		if ( err != pExp->status || (ExprsTermTypes_t)out.termType != pExp->expectedResultType )
+		{
+			printf("%3d: Batch expression '%s' returned error %d: %s, type %d. Expected %d: %s, type %d\n",
+				   ii, pExp->expr, err, libExprsGetErrorStr(err), out.termType,
+				   pExp->status, libExprsGetErrorStr(pExp->status), pExp->expectedResultType);
+			retV = 1;
+		}
+		for (row=0; row < TEST_BATCH_ROWS && !retV; ++row)
+		{
+			memset(slots, 0, sizeof(slots));
+			slots[0].termType = EXPRS_SYM_TERM_INTEGER;
+			slots[0].value.s64 = xVals[row];
+			slots[1].termType = EXPRS_SYM_TERM_FLOAT;
+			slots[1].value.f64 = yVals[row];
+			slots[2].termType = EXPRS_SYM_TERM_INTEGER;
+			slots[2].value.s64 = zVals[row];
+			rowErr = libExprsRunSlots(exprs, prog, slots, n_elts(slots), &result, 0);
+			if ( rowErr )
+			{
+				if ( rowErr != err )
+				{
+					printf("%3d: Batch expression '%s' row %d failed with %s. Batch returned %s\n",
+						   ii, pExp->expr, row, libExprsGetErrorStr(rowErr), libExprsGetErrorStr(err));
+					retV = 1;
+				}
+				break;
+			}
+			if ( memcmp(&result.term.s64, outVals + row, sizeof(long)) )
+			{
+				printf("%3d: Batch expression '%s' row %d mismatch. Got 0x%lX, expected 0x%lX\n",
+					   ii, pExp->expr, row, outVals[row], result.term.s64);
+				retV = 1;
+			}
+		}
+		libExprsFreeProgram(prog);
+	}
+	clearTestSyms(symTbl);
+	return retV;
+}
+
+/* Check libExprsDepsUpdate() runs only what is downstream of a change and gets the same answers */
+static int depsRun(ExprsDef_t *exprs, TestSymTable_t *symTbl, const TestDepsFormula_t *formulas, int numFormulas, const TestDepsStep_t *steps, int numSteps)
+{
+	ExprsDeps_t *deps;
+	ExprsSymTerm_t value;
+	ExprsTerm_t result;
+	ExprsErrs_t err, updErr;
+	int ii, numRun, retV=0;
+
+	clearTestSyms(symTbl);
+	if ( libExprsDepsCreate(exprs, &deps) )
+	{
+		printf("Deps: Failed to create\n");
+		return 1;
+	}
+	for (ii=0; ii < numFormulas; ++ii)
+	{
+		err = libExprsDepsAdd(deps, formulas[ii].formula, NULL, 0);
+		if ( err != formulas[ii].status )
+		{
+			printf("%3d: Deps formula '%s' returned error %d: %s, expected %d: %s\n",
+				   ii, formulas[ii].formula, err, libExprsGetErrorStr(err),
+				   formulas[ii].status, libExprsGetErrorStr(formulas[ii].status));
+			retV = 1;
+		}
+	}
+	for (ii=0; ii < numSteps && !retV; ++ii)
+	{
+		numRun = -1;
+		updErr = EXPR_TERM_GOOD;
+		memset(&value, 0, sizeof(value));
+		err = libExprsEval(exprs, steps[ii].change, &result, 0);
+		if ( !err && steps[ii].changed )
+			err = libExprsDepsChanged(deps, steps[ii].changed, 0);
+		if ( !err )
+			updErr = libExprsDepsUpdate(deps, &numRun, 0);
+		if ( !err )
+			err = getTestSym(symTbl, steps[ii].sym, &value);
+		if ( err || updErr != steps[ii].status || numRun != steps[ii].numRun || value.value.s64 != steps[ii].value )
+		{
+			printf("%3d: Deps after '%s' returned error %d: %s, update %d: %s, ran %d, %s=%ld. Expected update %d, ran %d, %s=%ld\n",
+				   ii, steps[ii].change, err, libExprsGetErrorStr(err), updErr, libExprsGetErrorStr(updErr), numRun,
+				   steps[ii].sym, value.value.s64,
+				   steps[ii].status, steps[ii].numRun, steps[ii].sym, steps[ii].value);
+			retV = 1;
+		}
+	}
+	libExprsDepsFree(deps);
+	clearTestSyms(symTbl);
+	return retV;
+}
+
+static int depsTest(ExprsDef_t *exprs, ExprsCallbacks_t *symCb, TestSymTable_t *symTbl)
+{
+	int retV;
+
+	symCb->msgOut = quietMsg;
+	libExprsSetCallbacks(exprs, symCb, NULL);
+	libExprsSetFlags(exprs, 0, NULL);
+	libExprsSetRadix(exprs, 0, NULL);
+	retV = depsRun(exprs, symTbl, TestDepsFormulas, n_elts(TestDepsFormulas), TestDepsSteps, n_elts(TestDepsSteps));
+	retV |= depsRun(exprs, symTbl, TestDepsFailFormulas, n_elts(TestDepsFailFormulas), TestDepsFailSteps, n_elts(TestDepsFailSteps));
+	return retV;
+}
+
 static int getValue(ExprsDef_t *exprs, char *buf, int bufLen, const char *title, const ExprsTerm_t *result, const TestExprs_t *tVal)
 {
 	int sLen;
@@ -302,8 +750,573 @@ static int getValue(ExprsDef_t *exprs, char *buf, int bufLen, const char *title,
 	return sLen;
 }
 
-static void quietMsg(void *msgArg, ExprsMsgSeverity_t severity, const char *msg)
+static int checkResult(ExprsDef_t *exprs, int ii, const char *how, const TestExprs_t *pExp, ExprsErrs_t err, const ExprsTerm_t *result, int *fatalP)
+{
+	char buf[256];
+	int sLen;
+
+	if ( err != pExp->status )
+	{
+		printf("%3d: %sExpression '%s' returned error %d: %s, expected %d: %s, flags=0x%lX, radix=%d\n",
+			   ii,
+			   how,
+			   pExp->expr,
+			   err,
+			   libExprsGetErrorStr(err),
+			   pExp->status,
+			   libExprsGetErrorStr(pExp->status),
+			   pExp->flags,
+			   pExp->radix
+			   );
+		return 1;
+	}
+	if ( result->termType != pExp->expectedResultType )
+	{
+		sLen  = snprintf(buf,sizeof(buf),"%3d: %sType mismatch. Expression '%s' ", ii, how, pExp->expr);
+		sLen += getValue(exprs,buf+sLen,sizeof(buf)-sLen, "expected",NULL,pExp);
+		sLen += getValue(exprs,buf+sLen,sizeof(buf)-sLen, ". Got ",result,NULL);
+		printf("%s\n",buf);
+		return 1;
+	}
+	else
+	{
+		int diff=0;
+		switch (pExp->expectedResultType)
+		{
+		case EXPRS_TERM_INTEGER:
+			if ( pExp->expectedInt != result->term.s64 )
+				diff = 1;
+			break;
+		case EXPRS_TERM_FLOAT:
+			if ( pExp->expectedFloat != result->term.f64 )
+				diff = 1;
+			break;
+		case EXPRS_TERM_STRING:
+			if ( strcmp(pExp->expectedString, libExprsStringPoolTop(exprs) + result->term.string) )
+				diff = 1;
+			break;
+		case EXPRS_TERM_NULL:
+			break;
+		default:
+			printf("FATAL: Exprs %d '%s' has undefined expected result type %d\n", ii, pExp->expr, pExp->expectedResultType);
+			*fatalP = 1;
+			return 1;
+		}
+		if ( diff )
+		{
+			sLen = snprintf(buf, sizeof(buf), "%3d: %sValue mismatch. Expression '%s' ", ii, how, pExp->expr);
+			sLen += getValue(exprs,buf+sLen,sizeof(buf)-sLen, "expected",NULL,pExp);
+			sLen += getValue(exprs,buf+sLen,sizeof(buf)-sLen, ". Got ",result,NULL);
+			printf("%s, flags=0x%lX, radix=%d\n", buf, pExp->flags, pExp->radix);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* libExprsSetThreads() needs symbol callbacks that are thread safe */
+static pthread_mutex_t TestSymMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static ExprsErrs_t getTestSymLocked(void *symArg, const char *name, ExprsSymTerm_t *value)
+{
+	ExprsErrs_t err;
+	pthread_mutex_lock(&TestSymMutex);
+	err = getTestSym(symArg, name, value);
+	pthread_mutex_unlock(&TestSymMutex);
+	return err;
+}
+
+static ExprsErrs_t setTestSymLocked(void *symArg, const char *name, const ExprsSymTerm_t *value)
+{
+	ExprsErrs_t err;
+	pthread_mutex_lock(&TestSymMutex);
+	err = setTestSym(symArg, name, value);
+	pthread_mutex_unlock(&TestSymMutex);
+	return err;
+}
+
+/* Print the symbol table sorted by name since threads may have added them in any order */
+static void dumpTestSyms(const TestSymTable_t *tbl, char *buf, int bufLen)
+{
+	const char *prev = "";
+	int ii, best, sLen = 0;
+
+	buf[0] = 0;
+	for (;;)
+	{
+		best = -1;
+		for (ii=0; ii < tbl->numSyms; ++ii)
+		{
+			if ( strcmp(tbl->names[ii], prev) > 0 && (best < 0 || strcmp(tbl->names[ii], tbl->names[best]) < 0) )
+				best = ii;
+		}
+		if ( best < 0 || sLen >= bufLen )
+			break;
+		prev = tbl->names[best];
+		if ( tbl->values[best].termType == EXPRS_SYM_TERM_STRING )
+			sLen += snprintf(buf + sLen, bufLen - sLen, "%s=\"%s\" ", prev, tbl->values[best].value.string);
+		else if ( tbl->values[best].termType == EXPRS_SYM_TERM_FLOAT )
+			sLen += snprintf(buf + sLen, bufLen - sLen, "%s=%g ", prev, tbl->values[best].value.f64);
+		else
+			sLen += snprintf(buf + sLen, bufLen - sLen, "%s=%ld ", prev, tbl->values[best].value.s64);
+	}
+}
+
+#define SCRATCH_THREADS (4)
+
+/* One thread running every compiled TestExprs program with its own scratch */
+typedef struct
+{
+	ExprsScratch_t *scratch;
+	ExprsProgram_t **progs;
+	int badIdx;					/* first program giving a wrong answer (-1 if none) */
+} ScratchThread_t;
+
+static void *scratchThread(void *arg)
+{
+	ScratchThread_t *thr = (ScratchThread_t *)arg;
+	const TestExprs_t *pExp;
+	ExprsTerm_t result;
+	ExprsErrs_t err;
+	int ii, run, diff;
+
+	for (run=0; run < 8 && thr->badIdx < 0; ++run)
+	{
+		for (ii=0, pExp=TestExprs; ii < n_elts(TestExprs); ++ii, ++pExp)
+		{
+			if ( !thr->progs[ii] )
+				continue;
+			memset(&result, 0, sizeof(result));
+			err = libExprsRunScratch(thr->scratch, thr->progs[ii], &result);
+			diff = err != pExp->status || (!err && result.termType != pExp->expectedResultType);
+			if ( !diff && !err )
+			{
+				if ( pExp->expectedResultType == EXPRS_TERM_INTEGER )
+					diff = result.term.s64 != pExp->expectedInt;
+				else if ( pExp->expectedResultType == EXPRS_TERM_FLOAT )
+					diff = result.term.f64 != pExp->expectedFloat;
+				else if ( pExp->expectedResultType == EXPRS_TERM_STRING )
+					diff = strcmp(libExprsScratchStringPoolTop(thr->scratch) + result.term.string, pExp->expectedString) != 0;
+			}
+			if ( diff )
+			{
+				thr->badIdx = ii;
+				break;
+			}
+		}
+	}
+	return NULL;
+}
+
+/* Check several threads can run the same compiled programs at once, each with its own scratch */
+static int scratchTest(ExprsDef_t *exprs, ExprsCallbacks_t *lclCb)
+{
+	ExprsProgram_t *progs[n_elts(TestExprs)];
+	ScratchThread_t thrs[SCRATCH_THREADS];
+	pthread_t threads[SCRATCH_THREADS];
+	const TestExprs_t *pExp;
+	int ii, numStarted, retV=0;
+
+	libExprsSetCallbacks(exprs, lclCb, NULL);
+	for (ii=0, pExp=TestExprs; ii < n_elts(TestExprs); ++ii, ++pExp)
+	{
+		libExprsSetFlags(exprs, pExp->flags | ((ii & 1) ? EXPRS_FLG_JIT : 0), NULL);	/* half of them native code */
+		libExprsSetRadix(exprs, pExp->radix, NULL);
+		if ( libExprsCompile(exprs, pExp->expr, progs + ii, 0) )
+			progs[ii] = NULL;		/* compile errors are checked elsewhere */
+	}
+	for (numStarted=0; numStarted < SCRATCH_THREADS; ++numStarted)
+	{
+		thrs[numStarted].progs = progs;
+		thrs[numStarted].badIdx = -1;
+		if ( libExprsScratchCreate(exprs, &thrs[numStarted].scratch, 0) )
+			break;
+		if ( pthread_create(threads + numStarted, NULL, scratchThread, thrs + numStarted) )
+		{
+			libExprsScratchFree(thrs[numStarted].scratch);
+			break;
+		}
+	}
+	if ( numStarted < SCRATCH_THREADS )
+	{
+		printf("Scratch test only started %d of %d threads\n", numStarted, SCRATCH_THREADS);
+		retV = 1;
+	}
+	for (ii=0; ii < numStarted; ++ii)
+	{
+		pthread_join(threads[ii], NULL);
+		libExprsScratchFree(thrs[ii].scratch);
+		if ( thrs[ii].badIdx >= 0 )
+		{
+			printf("%3d: Scratch thread %d got the wrong answer for expression '%s'\n", thrs[ii].badIdx, ii, TestExprs[thrs[ii].badIdx].expr);
+			retV = 1;
+		}
+	}
+	for (ii=0; ii < n_elts(TestExprs); ++ii)
+		libExprsFreeProgram(progs[ii]);
+	return retV;
+}
+
+#define POOL_THREADS (4)
+
+/* One thread evaluating every TestExprs expression in a context acquired from a shared pool */
+typedef struct
+{
+	ExprsCtxPool_t *pool;
+	ExprsCallbacks_t *lclCb;
+	int badIdx;					/* first expression giving a wrong answer (-1 if none) */
+	int notReused;				/* a context was not the one this thread last released */
+	int notReset;				/* an acquired context still had the last user's settings */
+} PoolThread_t;
+
+static void *poolThread(void *arg)
+{
+	PoolThread_t *thr = (PoolThread_t *)arg;
+	const TestExprs_t *pExp;
+	ExprsDef_t *exprs, *last=NULL;
+	ExprsTerm_t result;
+	ExprsErrs_t err;
+	int ii, run, diff;
+
+	for (run=0; run < 8 && thr->badIdx < 0; ++run)
+	{
+		for (ii=0, pExp=TestExprs; ii < n_elts(TestExprs); ++ii, ++pExp)
+		{
+			if ( libExprsCtxAcquire(thr->pool, &exprs) )
+			{
+				thr->badIdx = ii;
+				break;
+			}
+			if ( last && exprs != last )
+				thr->notReused = 1;
+			if ( exprs->mFlags || exprs->mRadix || exprs->userArg1 )
+				thr->notReset = 1;
+			libExprsSetCallbacks(exprs, (pExp->status != EXPR_TERM_GOOD) ? thr->lclCb : NULL, NULL);
+			libExprsSetFlags(exprs, pExp->flags, NULL);
+			libExprsSetRadix(exprs, pExp->radix, NULL);
+			memset(&result, 0, sizeof(result));
+			err = libExprsEval(exprs, pExp->expr, &result, 0);
+			diff = err != pExp->status || (!err && result.termType != pExp->expectedResultType);
+			if ( !diff && !err )
+			{
+				if ( pExp->expectedResultType == EXPRS_TERM_INTEGER )
+					diff = result.term.s64 != pExp->expectedInt;
+				else if ( pExp->expectedResultType == EXPRS_TERM_FLOAT )
+					diff = result.term.f64 != pExp->expectedFloat;
+				else if ( pExp->expectedResultType == EXPRS_TERM_STRING )
+					diff = strcmp(libExprsStringPoolTop(exprs) + result.term.string, pExp->expectedString) != 0;
+			}
+			exprs->userArg1 = thr;
+			libExprsCtxRelease(thr->pool, exprs);
+			last = exprs;
+			if ( diff )
+			{
+				thr->badIdx = ii;
+				break;
+			}
+		}
+	}
+	return NULL;
+}
+
+/* Check several threads can share a context pool and that each keeps getting back the context it released */
+static int poolTest(ExprsCallbacks_t *lclCb)
+{
+	ExprsCtxPool_t *pool;
+	PoolThread_t thrs[POOL_THREADS];
+	pthread_t threads[POOL_THREADS];
+	int ii, numStarted, retV=0;
+
+	if ( libExprsCtxPoolCreate(NULL, 0, 0, 2, &pool) )
+	{
+		printf("Failed to create a context pool\n");
+		return 1;
+	}
+	for (numStarted=0; numStarted < POOL_THREADS; ++numStarted)
+	{
+		memset(thrs + numStarted, 0, sizeof(PoolThread_t));
+		thrs[numStarted].pool = pool;
+		thrs[numStarted].lclCb = lclCb;
+		thrs[numStarted].badIdx = -1;
+		if ( pthread_create(threads + numStarted, NULL, poolThread, thrs + numStarted) )
+			break;
+	}
+	if ( numStarted < POOL_THREADS )
+	{
+		printf("Pool test only started %d of %d threads\n", numStarted, POOL_THREADS);
+		retV = 1;
+	}
+	for (ii=0; ii < numStarted; ++ii)
+	{
+		pthread_join(threads[ii], NULL);
+		if ( thrs[ii].badIdx >= 0 )
+		{
+			printf("%3d: Pool thread %d got the wrong answer for expression '%s'\n", thrs[ii].badIdx, ii, TestExprs[thrs[ii].badIdx].expr);
+			retV = 1;
+		}
+		if ( thrs[ii].notReused )
+		{
+			printf("Pool thread %d did not get back the context it released\n", ii);
+			retV = 1;
+		}
+		if ( thrs[ii].notReset )
+		{
+			printf("Pool thread %d acquired a context that had not been reset\n", ii);
+			retV = 1;
+		}
+	}
+	libExprsCtxPoolFree(pool);
+	return retV;
+}
+
+#define HASH_TEST_ENTRIES (20000)
+
+static unsigned int hashTestHash(void *symArg, int size, const HashEntry_t entry)
+{
+	return *(const unsigned int *)entry % size;
+}
+
+static int hashTestCmp(void *symArg, const HashEntry_t aa, const HashEntry_t bb)
+{
+	unsigned int av = *(const unsigned int *)aa, bv = *(const unsigned int *)bb;
+	return av < bv ? -1 : av > bv;
+}
+
+static int hashTestCount(const HashEntry_t entry, void *pUserData)
+{
+	++*(int *)pUserData;
+	return 0;
+}
+
+/* Check the hash table (chained or flat) grows and shrinks with the number of entries without losing any */
+static int hashTest(int flags)
+{
+	static unsigned int values[HASH_TEST_ENTRIES];
+	HashCallbacks_t cb;
+	HashRoot_t *pTable;
+	HashEntry_t found;
+	struct HashBlock_t *blocks;
+	int ii, count, blockUsed, retV=0;
+
+	memset(&cb, 0, sizeof(cb));
+	cb.symHash = hashTestHash;
+	cb.symCmp = hashTestCmp;
+	if ( !(pTable = libHashInitEx(7, &cb, flags)) )
+		return 1;
+	for (ii=0; ii < HASH_TEST_ENTRIES; ++ii)
+	{
+		values[ii] = ii*2654435761u;
+		if ( libHashInsert(pTable, (const HashEntry_t)(values + ii)) )
+		{
+			printf("Hash test (flags=0x%X) failed to insert entry %d\n", flags, ii);
+			retV = 1;
+			break;
+		}
+		/* Everything inserted so far must still be found while resizes are in progress */
+		if ( libHashFind(pTable, (const HashEntry_t)(values + ii/2), &found, 0) || found != values + ii/2 )
+		{
+			printf("Hash test (flags=0x%X) lost entry %d after inserting %d\n", flags, ii/2, ii);
+			retV = 1;
+			break;
+		}
+	}
+	count = 0;
+	libHashWalk(pTable, hashTestCount, &count, 0);
+	if ( !retV && (count != HASH_TEST_ENTRIES || pTable->hashTableSize < HASH_TEST_ENTRIES/2) )
+	{
+		printf("Hash test (flags=0x%X) walked %d of %d entries. Table size %d\n", flags, count, HASH_TEST_ENTRIES, pTable->hashTableSize);
+		retV = 1;
+	}
+	if ( !retV && (libHashInsert(pTable, (const HashEntry_t)(values + 5)) != HashDuplicateSymbol
+				   || libHashReplace(pTable, (const HashEntry_t)(values + 5), &found) || found != values + 5) )
+	{
+		printf("Hash test (flags=0x%X) did not see entry 5 was already there\n", flags);
+		retV = 1;
+	}
+	for (ii=10; ii < HASH_TEST_ENTRIES && !retV; ++ii)
+	{
+		if ( libHashDelete(pTable, (const HashEntry_t)(values + ii), NULL) )
+		{
+			printf("Hash test (flags=0x%X) failed to delete entry %d\n", flags, ii);
+			retV = 1;
+		}
+	}
+	for (ii=0; ii < 10 && !retV; ++ii)
+	{
+		if ( libHashFind(pTable, (const HashEntry_t)(values + ii), &found, 0) || found != values + ii )
+		{
+			printf("Hash test (flags=0x%X) lost entry %d after deletes\n", flags, ii);
+			retV = 1;
+		}
+	}
+	while ( pTable->oldTable && !retV )
+		libHashFind(pTable, (const HashEntry_t)values, &found, 0);
+	if ( !retV && pTable->hashTableSize > 127 )
+	{
+		printf("Hash test (flags=0x%X) table did not shrink. Size is %d with %d entries\n", flags, pTable->hashTableSize, pTable->numEntries);
+		retV = 1;
+	}
+	/* Deleted chain nodes are reused before any more are allocated */
+	blocks = pTable->blocks;
+	blockUsed = pTable->blockUsed;
+	for (ii=10; ii < 1010 && !retV; ++ii)
+	{
+		if ( libHashInsert(pTable, (const HashEntry_t)(values + ii)) )
+			blocks = NULL;
+	}
+	if ( !retV && (pTable->blocks != blocks || pTable->blockUsed != blockUsed) )
+	{
+		printf("Hash test (flags=0x%X) did not reuse deleted nodes\n", flags);
+		retV = 1;
+	}
+	libHashDestroy(pTable, NULL, NULL);
+	return retV;
+}
+
+/* Check libHashBytes() spreads typical assembler symbol names evenly. For each
+ * corpus the number of pairs of names sharing a bucket is compared with the
+ * number expected if the hash were truly random, for a prime size table (the
+ * whole hash matters), the low bits (a power of 2 table) and the high bits. */
+static int hashDistTest(void)
 {
+	static const char * const Prefixes[] = { "tx", "rx", "dma", "irq", "uart", "spi", "i2c", "gpio" };
+	static const char * const Fields[] = { "buf", "len", "ptr", "next", "prev", "head", "tail", "count", "flags", "size", "data", "addr" };
+	static const char * const Corpora[] = { "L%d", "%d$", "_kernel_irq_handler_entry_%d", "%s_%s_%d", "%c%c", "loc_%X" };
+	static unsigned int buckets[3][1024];
+	char name[64];
+	uint64_t hh, seed;
+	double pairs[3], expected;
+	int corpus, ii, jj, num, retV=0;
+	const char *tbl[2];
+
+	for (corpus=0; corpus < n_elts(Corpora); ++corpus)
+	{
+		memset(buckets, 0, sizeof(buckets));
+		num = corpus == 4 ? 62*62 : 20000;
+		for (ii=0; ii < num; ++ii)
+		{
+			if ( corpus == 3 )
+				snprintf(name, sizeof(name), Corpora[corpus], Prefixes[ii % n_elts(Prefixes)], Fields[(ii / n_elts(Prefixes)) % n_elts(Fields)], ii / (n_elts(Prefixes)*n_elts(Fields)));
+			else if ( corpus == 4 )
+			{
+				static const char Chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+				snprintf(name, sizeof(name), Corpora[corpus], Chars[ii % 62], Chars[ii / 62]);
+			}
+			else
+				snprintf(name, sizeof(name), Corpora[corpus], ii);
+			hh = libHashBytes(name, strlen(name), 0);
+			++buckets[0][hh % 1021];
+			++buckets[1][hh & 1023];
+			++buckets[2][hh >> 54];
+		}
+		for (jj=0; jj < 3; ++jj)
+		{
+			pairs[jj] = 0;
+			for (ii=0; ii < 1024; ++ii)
+				pairs[jj] += buckets[jj][ii]*(buckets[jj][ii] - 1.0)/2;
+			expected = num*(num - 1.0)/2/(jj ? 1024 : 1021);
+			if ( pairs[jj] > expected*1.2 )
+			{
+				printf("Hash distribution of '%s' names is poor (%s): %.0f colliding pairs, expected %.0f\n",
+					   Corpora[corpus], jj == 0 ? "mod 1021" : (jj == 1 ? "low bits" : "high bits"), pairs[jj], expected);
+				retV = 1;
+			}
+		}
+	}
+	/* The seed must change the hash and the callbacks must use it */
+	seed = 12345;
+	tbl[0] = "some_symbol";
+	tbl[1] = "some_symbol";
+	if (    libHashBytes(tbl[0], strlen(tbl[0]), 0) == libHashBytes(tbl[0], strlen(tbl[0]), seed)
+		 || libHashStrHash(NULL, 0x7FFFFFFF, (const HashEntry_t)tbl) == libHashStrHash(&seed, 0x7FFFFFFF, (const HashEntry_t)tbl)
+		 || libHashStrCmp(NULL, (const HashEntry_t)tbl, (const HashEntry_t)(tbl + 1)) )
+	{
+		printf("Hash seed or string compare is not working\n");
+		retV = 1;
+	}
+	return retV;
+}
+
+/* Check only the given span of text is used by the xxxN() functions */
+static int spanTest(ExprsDef_t *exprs, ExprsCallbacks_t *lclCb, int *fatalP)
+{
+	ExprsProgram_t *prog;
+	ExprsTerm_t result;
+	ExprsErrs_t err;
+	const TestExprs_t *pExp;
+	int ii, retV=0;
+
+	libExprsSetFlags(exprs, 0, NULL);
+	libExprsSetRadix(exprs, 0, NULL);
+	for (ii=0; ii < n_elts(TestSpanExprs) && !*fatalP; ++ii)
+	{
+		pExp = &TestSpanExprs[ii].exp;
+		libExprsSetCallbacks(exprs, (pExp->status != EXPR_TERM_GOOD) ? lclCb : NULL, NULL);
+		err = libExprsEvalN(exprs, pExp->expr, TestSpanExprs[ii].len, &result, 0);
+		retV |= checkResult(exprs, ii, "Span ", pExp, err, &result, fatalP);
+		if ( exprs->mCurrPtr < pExp->expr || exprs->mCurrPtr > pExp->expr + TestSpanExprs[ii].len )
+		{
+			printf("%3d: Span expression '%.*s' stopped at offset %d\n", ii, TestSpanExprs[ii].len, pExp->expr, (int)(exprs->mCurrPtr - pExp->expr));
+			retV = 1;
+		}
+		memset(&result, 0, sizeof(result));
+		err = libExprsCompileN(exprs, pExp->expr, TestSpanExprs[ii].len, &prog, 0);
+		if ( !err )
+		{
+			err = libExprsRun(exprs, prog, &result, 0);
+			libExprsFreeProgram(prog);
+		}
+		retV |= checkResult(exprs, ii, "Compiled span ", pExp, err, &result, fatalP);
+	}
+	return retV;
+}
+
+/* Check running a program a wave at a time over several threads matches running it in turn */
+static int waveTest(ExprsDef_t *exprs, ExprsCallbacks_t *symCb, TestSymTable_t *symTbl)
+{
+	ExprsCallbacks_t lockedCb = *symCb;
+	ExprsProgram_t *prog;
+	ExprsTerm_t result;
+	ExprsErrs_t err[2];
+	char value[2][128], syms[2][512];
+	int ii, pass, retV=0;
+
+	lockedCb.symGet = getTestSymLocked;
+	lockedCb.symSet = setTestSymLocked;
+	lockedCb.msgOut = quietMsg;
+	libExprsSetCallbacks(exprs, &lockedCb, NULL);
+	libExprsSetFlags(exprs, 0, NULL);
+	libExprsSetRadix(exprs, 0, NULL);
+	for (ii=0; ii < n_elts(TestWaveScripts); ++ii)
+	{
+		if ( libExprsCompile(exprs, TestWaveScripts[ii].script, &prog, 0) )
+		{
+			printf("%3d: Wave script '%s' failed to compile\n", ii, TestWaveScripts[ii].script);
+			retV = 1;
+			continue;
+		}
+		for (pass=0; pass < 2; ++pass)
+		{
+			libExprsSetThreads(exprs, pass ? 4 : 0, 0);
+			clearTestSyms(symTbl);
+			memset(&result, 0, sizeof(result));
+			err[pass] = libExprsRun(exprs, prog, &result, 0);
+			getValue(exprs, value[pass], sizeof(value[pass]), "", &result, NULL);
+			dumpTestSyms(symTbl, syms[pass], sizeof(syms[pass]));
+		}
+		if (    err[0] != err[1] || (!err[0] && strcmp(value[0], value[1])) || strcmp(syms[0], syms[1])
+			 || (TestWaveScripts[ii].syms && strcmp(syms[0], TestWaveScripts[ii].syms))
+		   )
+		{
+			printf("%3d: Wave script '%s' returned %d:%s %s. Run in turn returned %d:%s %s\n",
+				   ii, TestWaveScripts[ii].script, err[1], value[1], syms[1], err[0], value[0], syms[0]);
+			retV = 1;
+		}
+		libExprsFreeProgram(prog);
+	}
+	libExprsSetThreads(exprs, 0, 0);
+	clearTestSyms(symTbl);
+	return retV;
 }
 
 int exprsTest(int verbose)
@@ -312,10 +1325,11 @@ int exprsTest(int verbose)
 	ExprsTerm_t result;
 	const TestExprs_t *pExp;
 	ExprsErrs_t err;
-	int ii, retV=0, fatal=0;
+	int ii, jit, isa, retV=0, fatal=0;
 	char buf[256];
 	int sLen;
-	ExprsCallbacks_t lclCb, *cbPtr=NULL;
+	ExprsCallbacks_t lclCb, symCb, *cbPtr=NULL;
+	TestSymTable_t symTbl;
 
 	exprs = libExprsInit(NULL, 0, 0);
 	if ( !exprs )
@@ -325,71 +1339,231 @@ int exprsTest(int verbose)
 	}
 	memset(&lclCb,0,sizeof(lclCb));
 	lclCb.msgOut = quietMsg;
+	/* Parse with each of the vector instruction sets (that the CPU has) the lexer can use and without */
+	for (isa=EXPRS_LEX_ISA_AVX2; isa >= EXPRS_LEX_ISA_SCALAR && !fatal; --isa)
+	{
+		if ( libExprsSetLexIsa(isa) != isa )
+		{
+			printf("Lexer tests skipped for ISA %d. Not supported by this CPU.\n", isa);
+			continue;
+		}
+		pExp = TestExprs;
+		for (ii=0; ii < n_elts(TestExprs) && !fatal; ++ii, ++pExp)
+		{
+			cbPtr = (pExp->status != EXPR_TERM_GOOD) ? &lclCb : NULL;
+			libExprsSetCallbacks(exprs, cbPtr, NULL);
+			libExprsSetFlags(exprs, pExp->flags, NULL);
+			libExprsSetRadix(exprs, pExp->radix, NULL);
+			err = libExprsEval(exprs, pExp->expr, &result, 0);
+			retV |= checkResult(exprs, ii, "", pExp, err, &result, &fatal);
+		}
+	}
+	libExprsSetLexIsa(EXPRS_LEX_ISA_AVX2);
+	/* Same again but parse once and run the compiled program a couple of times. Interpreted then JIT'ed. */
+	for (jit=0; jit < 2 && !fatal; ++jit)
+	{
+		const char *how = jit ? "JIT compiled " : "Compiled ";
+
+		pExp = TestExprs;
+		for (ii=0; ii < n_elts(TestExprs) && !fatal; ++ii, ++pExp)
+		{
+			ExprsProgram_t *prog;
+			int run;
+
+			cbPtr = (pExp->status != EXPR_TERM_GOOD) ? &lclCb : NULL;
+			libExprsSetCallbacks(exprs, cbPtr, NULL);
+			libExprsSetFlags(exprs, pExp->flags | (jit ? EXPRS_FLG_JIT : 0), NULL);
+			libExprsSetRadix(exprs, pExp->radix, NULL);
+			err = libExprsCompile(exprs, pExp->expr, &prog, 0);
+			if ( err )
+			{
+				memset(&result, 0, sizeof(result));
+				retV |= checkResult(exprs, ii, how, pExp, err, &result, &fatal);
+				continue;
+			}
+			for (run=0; run < 2; ++run)
+			{
+				err = libExprsRun(exprs, prog, &result, 0);
+				if ( checkResult(exprs, ii, how, pExp, err, &result, &fatal) )
+				{
+					retV = 1;
+					break;
+				}
+			}
+			libExprsFreeProgram(prog);
+		}
+	}
+	/* And once more with constants folded at compile time. Results and errors must not change. */
 	pExp = TestExprs;
 	for (ii=0; ii < n_elts(TestExprs) && !fatal; ++ii, ++pExp)
 	{
+		ExprsProgram_t *prog;
+
+		cbPtr = (pExp->status != EXPR_TERM_GOOD) ? &lclCb : NULL;
+		libExprsSetCallbacks(exprs, cbPtr, NULL);
+		libExprsSetFlags(exprs, pExp->flags | EXPRS_FLG_FOLD_CONSTANTS, NULL);
+		libExprsSetRadix(exprs, pExp->radix, NULL);
+		memset(&result, 0, sizeof(result));
+		err = libExprsCompile(exprs, pExp->expr, &prog, 0);
+		if ( !err )
+		{
+			err = libExprsRun(exprs, prog, &result, 0);
+			libExprsFreeProgram(prog);
+		}
+		retV |= checkResult(exprs, ii, "Folded ", pExp, err, &result, &fatal);
+	}
+	/* Through libExprsEval() again with a cache too small to hold them all. Each is done twice so the second is found in the cache. */
+	libExprsSetCacheSize(exprs, 16, 0);
+	pExp = TestExprs;
+	for (ii=0; ii < n_elts(TestExprs) && !fatal; ++ii, ++pExp)
+	{
+		int run;
+
 		cbPtr = (pExp->status != EXPR_TERM_GOOD) ? &lclCb : NULL;
 		libExprsSetCallbacks(exprs, cbPtr, NULL);
 		libExprsSetFlags(exprs, pExp->flags, NULL);
 		libExprsSetRadix(exprs, pExp->radix, NULL);
-		err = libExprsEval(exprs, pExp->expr, &result, 0);
-		if ( err != pExp->status )
+		for (run=0; run < 2; ++run)
 		{
-			printf("%3d: Expression '%s' returned error %d: %s, expected %d: %s, flags=0x%lX, radix=%d\n",
-				   ii,
-				   pExp->expr,
-				   err,
-				   libExprsGetErrorStr(err),
-				   pExp->status,
-				   libExprsGetErrorStr(pExp->status),
-				   pExp->flags,
-				   pExp->radix
-				   );
+			err = libExprsEval(exprs, pExp->expr, &result, 0);
+			if ( checkResult(exprs, ii, run ? "Cached " : "Caching ", pExp, err, &result, &fatal) )
+			{
+				retV = 1;
+				break;
+			}
+		}
+	}
+	if ( !fatal )
+	{
+		static const char CacheText[] = "  1 + 2 *3 ";
+		ExprsCacheStats_t stats;
+
+		/* Differences in white space that don't matter are still found. Pointers are into the text given. */
+		libExprsSetCallbacks(exprs, NULL, NULL);
+		libExprsSetFlags(exprs, 0, NULL);
+		libExprsSetRadix(exprs, 0, NULL);
+		libExprsEval(exprs, "  1+2*3 ", &result, 0);
+		libExprsGetCacheStats(exprs, &stats, 0);
+		err = libExprsEval(exprs, CacheText, &result, 0);
+		libExprsGetCacheStats(exprs, &stats, 0);
+		if (    err || result.term.s64 != 7 || exprs->mCurrPtr != CacheText + strlen(CacheText)
+			 || !stats.hits || !stats.evictions || stats.numEntries != 16 || stats.maxEntries != 16 )
+		{
+			printf("Cache: '%s' returned %d, %ld, %d chars left. hits=%lu, misses=%lu, evictions=%lu, entries=%d/%d\n",
+				   CacheText, err, result.term.s64, (int)strlen(exprs->mCurrPtr),
+				   stats.hits, stats.misses, stats.evictions, stats.numEntries, stats.maxEntries);
 			retV = 1;
-			continue;
 		}
-		if ( result.termType != pExp->expectedResultType )
+	}
+	for (ii=0; ii < n_elts(TestFoldExprs) && !fatal; ++ii)
+	{
+		libExprsSetCallbacks(exprs, &lclCb, NULL);
+		libExprsSetFlags(exprs, EXPRS_FLG_FOLD_CONSTANTS, NULL);
+		libExprsSetRadix(exprs, 0, NULL);
+		err = libExprsParseToRPN(exprs, TestFoldExprs[ii].expr, 0);
+		if ( err > EXPR_TERM_END || exprs->mStack.mTermsPool.mNumUsed != TestFoldExprs[ii].numTerms )
 		{
-			sLen  = snprintf(buf,sizeof(buf),"%3d: Type mismatch. Expression '%s' ", ii, pExp->expr);
-			sLen += getValue(exprs,buf+sLen,sizeof(buf)-sLen, "expected",NULL,pExp);
-			sLen += getValue(exprs,buf+sLen,sizeof(buf)-sLen, ". Got ",&result,NULL);
-			printf("%s\n",buf);
+			printf("%3d: Folded expression '%s' returned error %d: %s with %d terms. Expected %d terms\n",
+				   ii, TestFoldExprs[ii].expr, err, libExprsGetErrorStr(err),
+				   exprs->mStack.mTermsPool.mNumUsed, TestFoldExprs[ii].numTerms);
+			retV = 1;
 		}
-		else
+	}
+	memset(&symCb,0,sizeof(symCb));
+	symCb.symGet = getTestSym;
+	symCb.symSet = setTestSym;
+	symCb.symArg = &symTbl;
+	memset(&symTbl,0,sizeof(symTbl));
+	pExp = TestSymExprs;
+	for (ii=0; ii < n_elts(TestSymExprs) && !fatal; ++ii, ++pExp)
+	{
+		ExprsProgram_t *prog;
+
+		symCb.msgOut = (pExp->status != EXPR_TERM_GOOD) ? quietMsg : NULL;
+		libExprsSetCallbacks(exprs, &symCb, NULL);
+		libExprsSetFlags(exprs, pExp->flags, NULL);
+		libExprsSetRadix(exprs, pExp->radix, NULL);
+		clearTestSyms(&symTbl);
+		err = libExprsEval(exprs, pExp->expr, &result, 0);
+		retV |= checkResult(exprs, ii, "Symbol ", pExp, err, &result, &fatal);
+		clearTestSyms(&symTbl);
+		memset(&result, 0, sizeof(result));
+		err = libExprsCompile(exprs, pExp->expr, &prog, 0);
+		if ( !err )
 		{
-			int diff=0;
-			switch (pExp->expectedResultType)
+			err = libExprsRun(exprs, prog, &result, 0);
+			libExprsFreeProgram(prog);
+		}
+		retV |= checkResult(exprs, ii, "Compiled symbol ", pExp, err, &result, &fatal);
+		/* The cache has to see the symbols as they are at each run */
+		clearTestSyms(&symTbl);
+		err = libExprsEval(exprs, pExp->expr, &result, 0);
+		retV |= checkResult(exprs, ii, "Caching symbol ", pExp, err, &result, &fatal);
+		clearTestSyms(&symTbl);
+		err = libExprsEval(exprs, pExp->expr, &result, 0);
+		retV |= checkResult(exprs, ii, "Cached symbol ", pExp, err, &result, &fatal);
+	}
+	libExprsSetCacheSize(exprs, 0, 0);
+	/* Same again with the symbols bound to slots. The symbol table must not be touched. Interpreted then JIT'ed. */
+	for (jit=0; jit < 2 && !fatal; ++jit)
+	{
+		const char *how = jit ? "JIT slot symbol " : "Slot symbol ";
+
+		pExp = TestSymExprs;
+		for (ii=0; ii < n_elts(TestSymExprs) && !fatal; ++ii, ++pExp)
+		{
+			ExprsProgram_t *prog;
+			ExprsSymTerm_t slots[TEST_MAX_SYMS];
+
+			symCb.msgOut = (pExp->status != EXPR_TERM_GOOD) ? quietMsg : NULL;
+			libExprsSetCallbacks(exprs, &symCb, NULL);
+			libExprsSetFlags(exprs, pExp->flags | (jit ? EXPRS_FLG_JIT : 0), NULL);
+			libExprsSetRadix(exprs, pExp->radix, NULL);
+			clearTestSyms(&symTbl);
+			memset(slots, 0, sizeof(slots));
+			memset(&result, 0, sizeof(result));
+			err = libExprsCompile(exprs, pExp->expr, &prog, 0);
+			if ( !err )
 			{
-			case EXPRS_TERM_INTEGER:
-				if ( pExp->expectedInt != result.term.s64 )
-					diff = 1;
-				break;
-			case EXPRS_TERM_FLOAT:
-				if ( pExp->expectedFloat != result.term.f64 )
-					diff = 1;
-				break;
-			case EXPRS_TERM_STRING:
-				if ( strcmp(pExp->expectedString, libExprsStringPoolTop(exprs) + result.term.string) )
-					diff = 1;
-				break;
-			case EXPRS_TERM_NULL:
-				break;
-			default:
-				printf("FATAL: Exprs %d '%s' has undefined expected result type %d\n", ii, pExp->expr, pExp->expectedResultType);
-				fatal = 1;
-				retV = 1;
-				break;
+				err = libExprsBindSymbols(prog, bindTestSlot, NULL);
+				if ( !err )
+					err = libExprsRunSlots(exprs, prog, slots, n_elts(slots), &result, 0);
+				libExprsFreeProgram(prog);
 			}
-			if ( diff )
+			retV |= checkResult(exprs, ii, how, pExp, err, &result, &fatal);
+			if ( symTbl.numSyms )
 			{
-				sLen = snprintf(buf, sizeof(buf), "%3d: Value mismatch. Expression '%s' ", ii, pExp->expr);
-				sLen += getValue(exprs,buf+sLen,sizeof(buf)-sLen, "expected",NULL,pExp);
-				sLen += getValue(exprs,buf+sLen,sizeof(buf)-sLen, ". Got ",&result,NULL);
-				printf("%s, flags=0x%lX, radix=%d\n", buf, pExp->flags, pExp->radix);
+				printf("%3d: %sexpression '%s' assigned %d symbols through symSet. Expected none.\n", ii, how, pExp->expr, symTbl.numSyms);
 				retV = 1;
 			}
 		}
 	}
+	clearTestSyms(&symTbl);
+	/* Do the batches with each of the vector instruction sets (that the CPU has) and without */
+	for (ii=EXPRS_BATCH_ISA_AVX2; ii >= EXPRS_BATCH_ISA_SCALAR && !fatal; --ii)
+	{
+		if ( libExprsSetBatchIsa(ii) == ii )
+			retV |= batchTest(exprs, &symCb, &symTbl);
+		else
+			printf("Batch tests skipped for ISA %d. Not supported by this CPU.\n", ii);
+	}
+	libExprsSetBatchIsa(EXPRS_BATCH_ISA_AVX2);
+	if ( !fatal )
+		retV |= depsTest(exprs, &symCb, &symTbl);
+	if ( !fatal )
+		retV |= waveTest(exprs, &symCb, &symTbl);
+	if ( !fatal )
+		retV |= spanTest(exprs, &lclCb, &fatal);
+	if ( !fatal )
+		retV |= scratchTest(exprs, &lclCb);
+	if ( !fatal )
+		retV |= poolTest(&lclCb);
+	if ( !fatal )
+		retV |= hashTest(0);
+	if ( !fatal )
+		retV |= hashTest(HASHTBL_FLG_FLAT);
+	if ( !fatal )
+		retV |= hashDistTest();
 	pExp = TestSymbols;
 	for (ii=0; ii < n_elts(TestSymbols) && !fatal; ++ii, ++pExp)
 	{
@@ -467,7 +1641,7 @@ int exprsTest(int verbose)
 	}
 	libExprsDestroy(exprs);
 	if ( !retV )
-		printf("Passed all of the %d tests.\n", n_elts(TestExprs)+n_elts(TestSymbols));
+		printf("Passed all of the %d tests.\n", 8*n_elts(TestExprs)+n_elts(TestFoldExprs)+6*n_elts(TestSymExprs)+3*n_elts(TestBatchExprs)+n_elts(TestDepsFormulas)+n_elts(TestDepsSteps)+n_elts(TestDepsFailFormulas)+n_elts(TestDepsFailSteps)+n_elts(TestWaveScripts)+2*n_elts(TestSpanExprs)+2*n_elts(TestExprs)+n_elts(TestSymbols));
 	return retV;
 }
 
@@ -0,0 +1,646 @@
+/*
+    exprs_test_file.c - evaluate a file of expressions with lib_exprs.[ch].
+    Copyright (C) 2022 David Shepperd
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "lib_hashtbl.h"
+#include "lib_btree.h"
+#include "lib_exprs.h"
+#include "exprs_test_file.h"
+
+/**
+ *  This example shows how one might use the expression parser
+ *  in a batch job. The input file is mapped into memory and
+ *  each line of it is handed to libExprsEvalN() right where it
+ *  sits, so no line is ever copied just to give it a
+ *  terminator. All the lines share one symbol table (in either
+ *  a hash table or a btree) so a symbol assigned on one line
+ *  can be used on any that follow. Results go into a large
+ *  output buffer that is written only when it fills.
+ *
+ *  Each line may hold several statements separated by ';'. They
+ *  are run in order and the result of the last one is output.
+ *  Empty lines are skipped.
+ *
+ *  When every line stands on its own (no assignments), the file
+ *  can instead be cut into newline aligned chunks and given to
+ *  several threads, each with its own ExprsDef_t. The results
+ *  of each chunk are kept until all the ones before it have
+ *  been written so the output is in the same order as the
+ *  input.
+ **/
+
+/**
+ * Our private definition of a symbol table entry. Same as the
+ * ones in exprs_test_ht.c and exprs_test_bt.c.
+ **/
+typedef struct
+{
+	const char *name;
+	ExprsSymTerm_t value;
+} SymbolTableEntry_t;
+
+/** FileSyms_t - the symbol table in use. Only one of pHash
+ *  or pBtree is set.
+ **/
+typedef struct
+{
+	HashRoot_t *pHash;
+	BtreeControl_t *pBtree;
+} FileSyms_t;
+
+#define OUTPUT_BUFFER_SIZE (1024*1024)	/* results are written this much at a time */
+#define OUTPUT_LINE_MAX (512)			/* room to leave for one result line */
+#define CHUNK_SIZE (256*1024)			/* bytes of input given to a thread at a time */
+#define CHUNK_OUTPUT_SIZE (64*1024)		/* starting size of a chunk's results */
+
+/** FileOutput_t - buffered output. With fp set the buffer is
+ *  written out whenever it fills. Without, it grows instead so
+ *  the results can be written later.
+ **/
+typedef struct
+{
+	FILE *fp;
+	char *buf;
+	size_t used;
+	size_t size;
+} FileOutput_t;
+
+/** FileChunk_t - a newline aligned piece of the input given to
+ *  one thread and the results it produced.
+ **/
+typedef struct
+{
+	const char *start;
+	const char *end;
+	int firstLine;				/* line number of first line in chunk */
+	int numLines;				/* non-empty lines evaluated */
+	int numErrs;				/* lines that failed */
+	int failed;					/* couldn't do the chunk at all */
+	int done;					/* results are ready to be written */
+	FileOutput_t out;
+} FileChunk_t;
+
+/** FileJob_t - what the threads share. Chunks are handed out in
+ *  order and written in order. A thread waits rather than run
+ *  more than 'window' chunks ahead of the one being written.
+ **/
+typedef struct
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	FileChunk_t *chunks;
+	int numChunks;
+	int nextChunk;				/* next chunk to hand out */
+	int nextWrite;				/* next chunk to write */
+	int window;
+	int incs;
+	unsigned long flags;
+	int radix;
+	int verbose;
+} FileJob_t;
+
+static int symCompare(void *symArg, const HashEntry_t aa, const HashEntry_t bb)
+{
+	return strcmp(((const SymbolTableEntry_t *)aa)->name, ((const SymbolTableEntry_t *)bb)->name);
+}
+
+static void freeEntry(void *freeArg, void *entry)
+{
+	SymbolTableEntry_t *ent = (SymbolTableEntry_t *)entry;
+
+	free((void *)ent->name);
+	if ( ent->value.termType == EXPRS_SYM_TERM_STRING )
+		free(ent->value.value.string);
+	free(ent);
+}
+
+static SymbolTableEntry_t *findEntry(FileSyms_t *syms, const char *name)
+{
+	SymbolTableEntry_t tEnt, *found = NULL;
+
+	tEnt.name = name;
+	if ( syms->pHash )
+	{
+		if ( libHashFind(syms->pHash, (const HashEntry_t)&tEnt, (HashEntry_t *)&found, 0) )
+			return NULL;
+	}
+	else if ( libBtreeFind(syms->pBtree, (const BtreeEntry_t)&tEnt, (BtreeEntry_t *)&found, 0) )
+		return NULL;
+	return found;
+}
+
+/** getFileSym - fetch a symbol's value from the symbol table.
+ *
+ *  At entry:
+ *  @param symArg - pointer to FileSyms_t
+ *  @param name - null terminated symbol name string
+ *  @param value - pointer of place into which to deposit
+ *  			 result.
+ *
+ *  At exit:
+ *  @return 0 on success, non-zero on error (as in no such
+ *  		symbol).
+ **/
+static ExprsErrs_t getFileSym(void *symArg, const char *name, ExprsSymTerm_t *value)
+{
+	SymbolTableEntry_t *found = findEntry((FileSyms_t *)symArg, name);
+
+	if ( !found )
+		return EXPR_TERM_BAD_UNDEFINED_SYMBOL;
+	*value = found->value;
+	return EXPR_TERM_GOOD;
+}
+
+/** setFileSym - insert or replace a symbol in the symbol
+ *  table.
+ *
+ *  At entry:
+ *  @param symArg - pointer to FileSyms_t
+ *  @param name   - null terminated symbol name string
+ *  @param value  - pointer to value to install.
+ *
+ *  At exit:
+ *  @return 0 on success, non-zero if error.
+ **/
+static ExprsErrs_t setFileSym(void *symArg, const char *name, const ExprsSymTerm_t *value)
+{
+	FileSyms_t *syms = (FileSyms_t *)symArg;
+	SymbolTableEntry_t *ent;
+	char *newStr = NULL;
+	int err;
+
+	if (    value->termType != EXPRS_SYM_TERM_INTEGER
+		 && value->termType != EXPRS_SYM_TERM_FLOAT
+		 && value->termType != EXPRS_SYM_TERM_STRING )
+		return EXPR_TERM_BAD_UNSUPPORTED;
+	if ( value->termType == EXPRS_SYM_TERM_STRING && !(newStr = strdup(value->value.string)) )
+		return EXPR_TERM_BAD_OUT_OF_MEMORY;
+	if ( (ent = findEntry(syms, name)) )
+	{
+		/* Just replace the value of the existing one */
+		if ( ent->value.termType == EXPRS_SYM_TERM_STRING )
+			free(ent->value.value.string);
+		ent->value = *value;
+		if ( newStr )
+			ent->value.value.string = newStr;
+		return EXPR_TERM_GOOD;
+	}
+	if ( !(ent = (SymbolTableEntry_t *)calloc(1, sizeof(SymbolTableEntry_t))) || !(ent->name = strdup(name)) )
+	{
+		free(ent);
+		free(newStr);
+		return EXPR_TERM_BAD_OUT_OF_MEMORY;
+	}
+	ent->value = *value;
+	if ( newStr )
+		ent->value.value.string = newStr;
+	if ( syms->pHash )
+		err = libHashInsert(syms->pHash, (const HashEntry_t)ent);
+	else
+		err = libBtreeInsert(syms->pBtree, (const BtreeEntry_t)ent);
+	if ( err )
+	{
+		freeEntry(NULL, ent);
+		return EXPR_TERM_BAD_OUT_OF_MEMORY;
+	}
+	return EXPR_TERM_GOOD;
+}
+
+/* Only fatal messages are shown unless verbose. Errors are reported in the output. */
+static void fileMsg(void *msgArg, ExprsMsgSeverity_t severity, const char *msg)
+{
+	static const char *Banners[] = { "INFO", "WARN", "ERROR", "FATAL" };
+
+	if ( *(int *)msgArg || severity >= EXPRS_SEVERITY_FATAL )
+		fprintf(severity > EXPRS_SEVERITY_INFO ? stderr : stdout, "%s-file: %s", Banners[severity], msg);
+}
+
+static int flushOutput(FileOutput_t *out)
+{
+	char *newBuf;
+
+	if ( !out->fp )
+	{
+		/* Nowhere to write it yet. Make room instead. */
+		newBuf = (char *)realloc(out->buf, out->size * 2);
+		if ( !newBuf )
+		{
+			fprintf(stderr, "Out of memory growing results to %zu bytes\n", out->size * 2);
+			return 1;
+		}
+		out->buf = newBuf;
+		out->size *= 2;
+		return 0;
+	}
+	if ( out->used && fwrite(out->buf, 1, out->used, out->fp) != out->used )
+	{
+		fprintf(stderr, "Failed to write results: %s\n", strerror(errno));
+		return 1;
+	}
+	out->used = 0;
+	return 0;
+}
+
+/** putResult - add one result line to the output buffer.
+ *
+ *  At entry:
+ *  @param out - pointer to output buffer
+ *  @param exprs - pointer to parser (for its string pool)
+ *  @param result - the result to show
+ *
+ *  At exit:
+ *  @return 0 on success, non-zero if the output could not be
+ *  		written.
+ **/
+static int putResult(FileOutput_t *out, ExprsDef_t *exprs, const ExprsTerm_t *result)
+{
+	char *dst;
+	const char *cp;
+	unsigned char cc;
+	size_t room;
+
+	if ( out->size - out->used < OUTPUT_LINE_MAX && flushOutput(out) )
+		return 1;
+	dst = out->buf + out->used;
+	room = out->size - out->used;
+	switch (result->termType)
+	{
+	case EXPRS_TERM_INTEGER:
+		out->used += snprintf(dst, room, "%ld\n", result->term.s64);
+		break;
+	case EXPRS_TERM_FLOAT:
+		out->used += snprintf(dst, room, "%g\n", result->term.f64);
+		break;
+	case EXPRS_TERM_STRING:
+		cp = libExprsStringPoolTop(exprs) + result->term.string;
+		*dst++ = '"';
+		while ( (cc = *cp++) )
+		{
+			if ( dst >= out->buf + out->size - 8 )
+			{
+				/* A long string. Make room and keep going. */
+				out->used = dst - out->buf;
+				if ( flushOutput(out) )
+					return 1;
+				dst = out->buf + out->used;
+			}
+			if ( isprint(cc) && cc != '"' && cc != '\\' )
+				*dst++ = cc;
+			else
+				dst += snprintf(dst, 8, "\\x%02X", cc);
+		}
+		*dst++ = '"';
+		*dst++ = '\n';
+		out->used = dst - out->buf;
+		break;
+	default:
+		out->used += snprintf(dst, room, "(not integer, float or string)\n");
+		break;
+	}
+	return 0;
+}
+
+/** evalLines - evaluate each line of some text.
+ *
+ *  At entry:
+ *  @param exprs - pointer to parser to use
+ *  @param line - first line of text
+ *  @param eof - end of text
+ *  @param lineNum - line number of first line
+ *  @param out - where to put results
+ *  @param numLinesP - incremented for each non-empty line
+ *  @param numErrsP - incremented for each line that failed
+ *
+ *  At exit:
+ *  @return 0 on success, non-zero if the results could not be
+ *  		written.
+ **/
+static int evalLines(ExprsDef_t *exprs, const char *line, const char *eof, int lineNum, FileOutput_t *out, int *numLinesP, int *numErrsP)
+{
+	ExprsTerm_t result;
+	ExprsErrs_t err;
+	const char *eol;
+	size_t len;
+
+	for ( ; line < eof; line = eol + 1, ++lineNum )
+	{
+		eol = (const char *)memchr(line, '\n', eof - line);
+		if ( !eol )
+			eol = eof;
+		len = eol - line;
+		if ( len && line[len - 1] == '\r' )
+			--len;
+		if ( !len )
+			continue;
+		++*numLinesP;
+		err = libExprsEvalN(exprs, line, len, &result, 0);
+		if ( err )
+		{
+			++*numErrsP;
+			if ( out->size - out->used < OUTPUT_LINE_MAX && flushOutput(out) )
+				return 1;
+			out->used += snprintf(out->buf + out->used, out->size - out->used, "line %d: error: %s\n", lineNum, libExprsGetErrorStr(err));
+			continue;
+		}
+		if ( putResult(out, exprs, &result) )
+			return 1;
+	}
+	return 0;
+}
+
+/** chunkWorker - thread evaluating chunks of the input with its
+ *  own parser.
+ *
+ *  At entry:
+ *  @param arg - pointer to FileJob_t
+ *
+ *  At exit:
+ *  @return NULL. Each chunk taken has been marked done.
+ **/
+static void *chunkWorker(void *arg)
+{
+	FileJob_t *job = (FileJob_t *)arg;
+	ExprsCallbacks_t exprsCallbacks;
+	ExprsDef_t *exprs;
+	FileChunk_t *chunk;
+
+	memset(&exprsCallbacks, 0, sizeof(exprsCallbacks));
+	exprsCallbacks.msgOut = fileMsg;
+	exprsCallbacks.msgArg = &job->verbose;
+	exprs = libExprsInit(&exprsCallbacks, job->incs, job->incs);
+	if ( exprs )
+	{
+		libExprsSetVerbose(exprs, job->verbose, NULL);
+		libExprsSetFlags(exprs, job->flags, NULL);
+		libExprsSetRadix(exprs, job->radix, NULL);
+	}
+	pthread_mutex_lock(&job->mutex);
+	while ( 1 )
+	{
+		while ( job->nextChunk < job->numChunks && job->nextChunk >= job->nextWrite + job->window )
+			pthread_cond_wait(&job->cond, &job->mutex);
+		if ( job->nextChunk >= job->numChunks )
+			break;
+		chunk = job->chunks + job->nextChunk++;
+		pthread_mutex_unlock(&job->mutex);
+		chunk->out.size = CHUNK_OUTPUT_SIZE;
+		chunk->out.buf = (char *)malloc(chunk->out.size);
+		if (    !exprs || !chunk->out.buf
+			 || evalLines(exprs, chunk->start, chunk->end, chunk->firstLine, &chunk->out, &chunk->numLines, &chunk->numErrs) )
+			chunk->failed = 1;
+		pthread_mutex_lock(&job->mutex);
+		chunk->done = 1;
+		pthread_cond_broadcast(&job->cond);
+	}
+	pthread_mutex_unlock(&job->mutex);
+	if ( exprs )
+		libExprsDestroy(exprs);
+	return NULL;
+}
+
+/** evalChunks - evaluate the lines of some text over several
+ *  threads, writing the results in input order.
+ *
+ *  At entry:
+ *  @param text - the text
+ *  @param textLen - its length
+ *  @param numThreads - number of threads to use
+ *  @param job - the flags, radix, etc. to use
+ *  @param out - where to write the results
+ *  @param numLinesP - set to number of non-empty lines
+ *  @param numErrsP - set to number of lines that failed
+ *
+ *  At exit:
+ *  @return 0 on success, non-zero if something other than an
+ *  		expression failed.
+ **/
+static int evalChunks(const char *text, size_t textLen, int numThreads, FileJob_t *job, FileOutput_t *out, int *numLinesP, int *numErrsP)
+{
+	pthread_t *threads;
+	FileChunk_t *chunk;
+	const char *cp, *end, *eof = text + textLen;
+	int ii, lineNum, numStarted, retV = 0;
+
+	job->numChunks = (textLen + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	job->chunks = (FileChunk_t *)calloc(job->numChunks ? job->numChunks : 1, sizeof(FileChunk_t));
+	threads = (pthread_t *)calloc(numThreads, sizeof(pthread_t));
+	if ( !job->chunks || !threads )
+	{
+		fprintf(stderr, "Out of memory\n");
+		free(job->chunks);
+		free(threads);
+		return 1;
+	}
+	/* Cut the text into newline aligned chunks noting the line number each starts on */
+	for ( ii = 0, cp = text, lineNum = 1; cp < eof; ++ii )
+	{
+		chunk = job->chunks + ii;
+		end = cp + CHUNK_SIZE < eof ? (const char *)memchr(cp + CHUNK_SIZE, '\n', eof - cp - CHUNK_SIZE) : NULL;
+		end = end ? end + 1 : eof;
+		chunk->start = cp;
+		chunk->end = end;
+		chunk->firstLine = lineNum;
+		for ( ; (cp = (const char *)memchr(cp, '\n', end - cp)); ++cp )
+			++lineNum;
+		cp = end;
+	}
+	job->numChunks = ii;
+	job->nextChunk = job->nextWrite = 0;
+	job->window = numThreads * 2;
+	pthread_mutex_init(&job->mutex, NULL);
+	pthread_cond_init(&job->cond, NULL);
+	for ( numStarted = 0; numStarted < numThreads; ++numStarted )
+	{
+		if ( pthread_create(threads + numStarted, NULL, chunkWorker, job) )
+			break;
+	}
+	if ( !numStarted )
+	{
+		fprintf(stderr, "Failed to start any threads: %s\n", strerror(errno));
+		retV = 1;
+	}
+	/* Write the results in order as they become available */
+	for ( ii = 0; ii < job->numChunks && numStarted; ++ii )
+	{
+		chunk = job->chunks + ii;
+		pthread_mutex_lock(&job->mutex);
+		while ( !chunk->done )
+			pthread_cond_wait(&job->cond, &job->mutex);
+		pthread_mutex_unlock(&job->mutex);
+		*numLinesP += chunk->numLines;
+		*numErrsP += chunk->numErrs;
+		if ( chunk->failed )
+			retV = 1;
+		else if ( !retV && chunk->out.used && fwrite(chunk->out.buf, 1, chunk->out.used, out->fp) != chunk->out.used )
+		{
+			fprintf(stderr, "Failed to write results: %s\n", strerror(errno));
+			retV = 1;
+		}
+		free(chunk->out.buf);
+		chunk->out.buf = NULL;
+		pthread_mutex_lock(&job->mutex);
+		job->nextWrite = ii + 1;
+		pthread_cond_broadcast(&job->cond);
+		pthread_mutex_unlock(&job->mutex);
+	}
+	for ( ii = 0; ii < numStarted; ++ii )
+		pthread_join(threads[ii], NULL);
+	pthread_cond_destroy(&job->cond);
+	pthread_mutex_destroy(&job->mutex);
+	free(job->chunks);
+	free(threads);
+	return retV;
+}
+
+/**
+ * exprsTestFile - evaluate every line of a file.
+ *
+ * At entry:
+ * @param incs - pool increments
+ * @param btreeSize - if non-zero, keep symbols in a btree
+ * @param hashTblSize - else keep them in a hash table of this
+ *  				  size (0 uses the hash lib's default).
+ * @param hashFlags - HASHTBL_FLG_xxx bits for the hash table
+ * @param numThreads - if more than 1, the lines are taken to be
+ *  				 independent of one another and evaluated
+ *  				 over this many threads. There is no symbol
+ *  				 table and assignments are not allowed.
+ * @param fileName - name of file of expressions, one per line
+ * @param flags - parser flags
+ * @param radix - default radix
+ * @param verbose - verbose flags
+ *
+ * At exit:
+ * @return 0 if every line evaluated, non-zero if any failed.
+ *  	   Results are written to stdout one per line in the
+ *  	   order of the input. The number of lines per second is
+ *  	   reported on stderr.
+ **/
+int exprsTestFile(int incs, int btreeSize, int hashTblSize, int hashFlags, int numThreads, const char *fileName, unsigned long flags, int radix, int verbose)
+{
+	ExprsCallbacks_t exprsCallbacks;
+	HashCallbacks_t hashCallbacks;
+	BtreeCallbacks_t btCallbacks;
+	FileSyms_t syms;
+	FileOutput_t out;
+	FileJob_t job;
+	ExprsDef_t *exprs = NULL;
+	struct stat st;
+	struct timespec start, end;
+	const char *text = NULL;
+	double secs;
+	int fd, numLines = 0, numErrs = 0, retV = 1;
+
+	memset(&syms, 0, sizeof(syms));
+	memset(&out, 0, sizeof(out));
+	fd = open(fileName, O_RDONLY);
+	if ( fd < 0 || fstat(fd, &st) )
+	{
+		fprintf(stderr, "Failed to open '%s': %s\n", fileName, strerror(errno));
+		if ( fd >= 0 )
+			close(fd);
+		return 1;
+	}
+	if ( st.st_size )
+	{
+		text = (const char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if ( text == (const char *)MAP_FAILED )
+		{
+			fprintf(stderr, "Failed to map '%s': %s\n", fileName, strerror(errno));
+			close(fd);
+			return 1;
+		}
+	}
+	close(fd);
+	out.fp = stdout;
+	if ( numThreads > 1 )
+	{
+		memset(&job, 0, sizeof(job));
+		job.incs = incs;
+		job.flags = flags | EXPRS_FLG_NO_ASSIGNMENT;
+		job.radix = radix;
+		job.verbose = verbose;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		retV = evalChunks(text, st.st_size, numThreads, &job, &out, &numLines, &numErrs);
+	}
+	else
+	{
+		if ( btreeSize )
+		{
+			memset(&btCallbacks, 0, sizeof(btCallbacks));
+			btCallbacks.symCmp = symCompare;
+			syms.pBtree = libBtreeInit(&btCallbacks);
+		}
+		else
+		{
+			memset(&hashCallbacks, 0, sizeof(hashCallbacks));
+			hashCallbacks.symCmp = libHashStrCmp;
+			hashCallbacks.symHash = libHashStrHash;
+			syms.pHash = libHashInitEx(hashTblSize, &hashCallbacks, hashFlags);
+		}
+		memset(&exprsCallbacks, 0, sizeof(exprsCallbacks));
+		exprsCallbacks.symGet = getFileSym;
+		exprsCallbacks.symSet = setFileSym;
+		exprsCallbacks.symArg = &syms;
+		exprsCallbacks.msgOut = fileMsg;
+		exprsCallbacks.msgArg = &verbose;
+		out.size = OUTPUT_BUFFER_SIZE;
+		out.buf = (char *)malloc(out.size);
+		if ( (syms.pHash || syms.pBtree) && out.buf )
+			exprs = libExprsInit(&exprsCallbacks, incs, incs);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if ( !exprs )
+			fprintf(stderr, "Out of memory\n");
+		else
+		{
+			libExprsSetVerbose(exprs, verbose, NULL);
+			libExprsSetFlags(exprs, flags, NULL);
+			libExprsSetRadix(exprs, radix, NULL);
+			retV = evalLines(exprs, text, text + st.st_size, 1, &out, &numLines, &numErrs);
+			if ( flushOutput(&out) )
+				retV = 1;
+			libExprsDestroy(exprs);
+		}
+		if ( syms.pHash )
+			libHashDestroy(syms.pHash, freeEntry, NULL);
+		if ( syms.pBtree )
+			libBtreeDestroy(syms.pBtree, freeEntry, NULL);
+		free(out.buf);
+	}
+	fflush(out.fp);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	fprintf(stderr, "Evaluated %d lines (%d errors) in %.3f seconds. %.0f lines/sec\n",
+			numLines, numErrs, secs, secs > 0 ? numLines / secs : 0.0);
+	if ( numErrs )
+		retV = 1;
+	if ( text )
+		munmap((void *)text, st.st_size);
+	return retV;
+}
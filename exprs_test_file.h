@@ -0,0 +1,24 @@
+/*
+    exprs_test_file.h - evaluate a file of expressions with lib_exprs.[ch].
+    Copyright (C) 2022 David Shepperd
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _EXPRS_TEST_FILE_H_
+#define _EXPRS_TEST_FILE_H_ (1)
+
+extern int exprsTestFile(int incs, int btreeSize, int hashTblSize, int hashFlags, int numThreads, const char *fileName, unsigned long flags, int radix, int verbose);
+
+#endif	/* _EXPRS_TEST_FILE_H_ */
+
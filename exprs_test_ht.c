@@ -44,7 +44,10 @@
  * We make our own private definition of what constitues a
  * symbol table entry. The value member does need to be one
  * specified by the expression parser. Hence the member
- * ExprsSymTerm_t.
+ * ExprsSymTerm_t. The name is the first member so the hash
+ * lib's own string key callbacks, libHashStrHash() and
+ * libHashStrCmp(), can be used rather than our having to
+ * write a hash and compare function of our own.
  **/
 typedef struct
 {
@@ -52,65 +55,6 @@ typedef struct
 	ExprsSymTerm_t value;
 } SymbolTableEntry_t;
 
-/**
- * hashIt - defines our custom hash function
- *
- * At entry:
- * @param symArg - pointer to symbol table root.
- * @param size - size of the hash table as specified at init.
- * @param entry - pointer to symbol table entry
- *
- * At exit:
- * @return integer with hash
- *
- * @note The hash lib requires we provide a Hash function. This
- *  	 since the hash table library has no specification of
- *  	 what is in a symbol table entry, what it is that needs
- *  	 hashing nor how to do it.
- **/
-#ifndef HASH_STRING_SEED
-#define HASH_STRING_SEED (11)
-#endif
-static unsigned int hashIt(void *symArg, int size, const HashEntry_t entry)
-{
-	const SymbolTableEntry_t *pData = (const SymbolTableEntry_t *)entry;
-	int hashv=HASH_STRING_SEED;
-	unsigned char cc;
-	const char *key;
-
-	/* This simple hash algorithm just accumulates the value of each character of the key times the hash table size plus the initial seed */
-	key = pData->name;
-	while ( (cc= *key++) )
-	{
-		hashv = hashv * size + cc;
-	}
-	/* Then returns that sum modulo the size of the hash table. */
-	return hashv % size;
-}
-
-/**
- * hashCompare - defines our custom compare function
- *
- * At entry:
- * @param symArg - pointer to symbol table root
- * @param aa - pointer to symbol table entry
- * @param bb - pointer to symbol table entry
- *
- * At exit:
- * @return minus if aa < bb, 0 if aa==bb, plus if aa > bb.
- *
- * @note The hash lib requires we provide a compare function.
- *  This since the hash table library has no specification of
- *  what is in a symbol table entry or how to compare the two
- *  entries with one another.
- **/
-static int hashCompare(void *symArg, const HashEntry_t aa, const HashEntry_t bb)
-{
-	const SymbolTableEntry_t *pAa = (const SymbolTableEntry_t *)aa;
-	const SymbolTableEntry_t *pBb = (const SymbolTableEntry_t *)bb;
-	return strcmp(pAa->name, pBb->name);
-}
-
 /** getHashSym - define our function to fetch an entry from
  *  the symbol table.
  *
@@ -361,6 +305,8 @@ static void tblDump(void* pArg, int hashIndex, const HashPrimitive_t *pHashEntry
  *
  * At entry:
  * @param hashTblSize - number of top level hash entries
+ * @param hashFlags - HASHTBL_FLG_xxx bits (HASHTBL_FLG_FLAT for the
+ *  				flat table)
  * @param expression  - pointer to null terminated string
  *  				  containing expression to test.
  * @param verbose 	  - verbose flags
@@ -368,7 +314,7 @@ static void tblDump(void* pArg, int hashIndex, const HashPrimitive_t *pHashEntry
  * @return 0 on success, non-zero on error.
  **/
 
-int exprsTestHashTbl(int incs, int hashTblSize, const char *expression, unsigned long flags, int radix, int verbose)
+int exprsTestHashTbl(int incs, int hashTblSize, int hashFlags, const char *expression, unsigned long flags, int radix, int verbose)
 {
 	ExprsCallbacks_t exprsCallbacks;
 	HashCallbacks_t hashCallbacks;
@@ -382,10 +328,10 @@ int exprsTestHashTbl(int incs, int hashTblSize, const char *expression, unsigned
 	/* Clear the callbacks struct in preparation to use it to pass our function pointers */
 	memset(&exprsCallbacks,0,sizeof(ExprsCallbacks_t));
 	memset(&hashCallbacks,0,sizeof(HashCallbacks_t));
-	hashCallbacks.symCmp = hashCompare;
-	hashCallbacks.symHash = hashIt;
+	hashCallbacks.symCmp = libHashStrCmp;
+	hashCallbacks.symHash = libHashStrHash;
 	/* Create the hash table using all its default configurations */
-	pHashTable = libHashInit(hashTblSize, &hashCallbacks);
+	pHashTable = libHashInitEx(hashTblSize, &hashCallbacks, hashFlags);
 	if ( !pHashTable )
 		return 1;
 	exprsCallbacks.symGet = getHashSym;
@@ -126,6 +126,10 @@ static ExprsErrs_t showTerm(ExprsDef_t *exprs, const ExprsTerm_t *term)
 	case EXPRS_TERM_ASSIGN:	/* = */
 		printf("Operator: %s\n", term->term.oper);
 		break;
+	case EXPRS_TERM_SKIP_FALSE:	/* left side of && */
+	case EXPRS_TERM_SKIP_TRUE:	/* left side of || */
+		printf("Skip %d terms if %s\n", term->term.link, term->termType == EXPRS_TERM_SKIP_FALSE ? "false" : "true");
+		break;
 	default:
 		printf("%d is not integer, float, string or symbol\n", term->termType);
 	}
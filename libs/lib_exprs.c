@@ -31,6 +31,18 @@
 #include <inttypes.h>
 
 #include "lib_exprs.h"
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define EXPRS_BATCH_SIMD 1
+#include <immintrin.h>
+#else
+#define EXPRS_BATCH_SIMD 0
+#endif
+#if defined(__x86_64__) && defined(__linux__) && defined(__GNUC__)
+#define EXPRS_JIT 1
+#include <sys/mman.h>
+#else
+#define EXPRS_JIT 0
+#endif
 #define OPERSTUFF_GET_OTHERS 1
 #include "lib_operstuff.h"
 
@@ -239,7 +251,7 @@ ExprsTerm_t* libExprsTermPoolTop(ExprsDef_t *exprs, ExprsStack_t *stack)
 	return (ExprsTerm_t *)stack->mTermsPool.mPoolTop;
 }
 
-static char* showTermType(ExprsDef_t *exprs, ExprsStack_t *sPtr, ExprsTerm_t *term, char *dst, int dstLen)
+static char* showTermType(ExprsDef_t *exprs, ExprsStack_t *sPtr, const ExprsTerm_t *term, char *dst, int dstLen)
 {
 	int len;
 
@@ -306,6 +318,10 @@ static char* showTermType(ExprsDef_t *exprs, ExprsStack_t *sPtr, ExprsTerm_t *te
 	case EXPRS_TERM_ASSIGN:
 		snprintf(dst, dstLen, "Assignment: %s", term->term.oper);
 		break;
+	case EXPRS_TERM_SKIP_FALSE:
+	case EXPRS_TERM_SKIP_TRUE:
+		snprintf(dst, dstLen, "Skip %d terms if %s", term->term.link, term->termType == EXPRS_TERM_SKIP_FALSE ? "false" : "true");
+		break;
 	}
 	return dst;
 }
@@ -384,18 +400,14 @@ ExprsErrs_t libExprsSetCloseDelimiter(ExprsDef_t *exprs, char newVal, char *oldV
 	return EXPR_TERM_GOOD;
 }
 
-static void dumpStack(ExprsDef_t *exprs, ExprsTerm_t *opers, int numOpers)
+static void dumpTerms(ExprsDef_t *exprs, const ExprsTerm_t *term, int numTerms, ExprsTerm_t *opers, int numOpers)
 {
 	int ii;
-	ExprsStack_t *sPtr;
-	ExprsTerm_t *term;
 	char eBuf[512];
 	int len;
 
-	sPtr = &exprs->mStack;
-	len = snprintf(eBuf, sizeof(eBuf), "Term stack has %3d %s ", sPtr->mTermsPool.mNumUsed, sPtr->mTermsPool.mNumUsed == 1 ? "term: " : "terms:");
-	term = (ExprsTerm_t *)sPtr->mTermsPool.mPoolTop;
-	for ( ii = 0; ii < sPtr->mTermsPool.mNumUsed; ++ii, ++term )
+	len = snprintf(eBuf, sizeof(eBuf), "Term stack has %3d %s ", numTerms, numTerms == 1 ? "term: " : "terms:");
+	for ( ii = 0; ii < numTerms; ++ii, ++term )
 	{
 		switch (term->termType)
 		{
@@ -477,6 +489,10 @@ static void dumpStack(ExprsDef_t *exprs, ExprsTerm_t *opers, int numOpers)
 		case EXPRS_TERM_ASSIGN: /* = */
 			len += snprintf(eBuf + len, sizeof(eBuf) - len, " %s", OperDescriptions[term->termType]);
 			break;
+		case EXPRS_TERM_SKIP_FALSE:
+		case EXPRS_TERM_SKIP_TRUE:
+			len += snprintf(eBuf + len, sizeof(eBuf) - len, " %s(+%d)", OperDescriptions[term->termType], term->term.link);
+			break;
 		}
 	}
 	len += snprintf(eBuf + len, sizeof(eBuf) - len, "\n");
@@ -499,6 +515,12 @@ static void dumpStack(ExprsDef_t *exprs, ExprsTerm_t *opers, int numOpers)
 	showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
 }
 
+static void dumpStack(ExprsDef_t *exprs, ExprsTerm_t *opers, int numOpers)
+{
+	ExprsStack_t *sPtr = &exprs->mStack;
+	dumpTerms(exprs, (ExprsTerm_t *)sPtr->mTermsPool.mPoolTop, sPtr->mTermsPool.mNumUsed, opers, numOpers);
+}
+
 static ExprsErrs_t badSyntax(ExprsDef_t *exprs, uint16_t chMask, char cc, ExprsErrs_t retErr)
 {
 	char eBuf[256];
@@ -508,12 +530,18 @@ static ExprsErrs_t badSyntax(ExprsDef_t *exprs, uint16_t chMask, char cc, ExprsE
 	return retErr;
 }
 
-static char* handleLengthQualifiers(ExprsDef_t *exprs, ExprsTerm_t *term, char *sEndp, bool *eatSuffixP)
+/* The char at ptr or a null if ptr is at or past the end of the text being parsed */
+static char lexPeek(const ExprsDef_t *exprs, const char *ptr)
+{
+	return ptr < exprs->mEndPtr ? *ptr : 0;
+}
+
+static const char* handleLengthQualifiers(ExprsDef_t *exprs, ExprsTerm_t *term, const char *sEndp, bool *eatSuffixP)
 {
 	char cc;
 	uint16_t chMask;
-	cc = toupper(sEndp[1]);
-	chMask = exprs->chMaskPtr[(int)sEndp[2]];
+	cc = toupper(lexPeek(exprs, sEndp + 1));
+	chMask = exprs->chMaskPtr[(int)lexPeek(exprs, sEndp + 2)];
 	if ( !(chMask & (CT_ALP | CT_XALP | CT_HEX)) )
 	{
 		if ( cc == 'B' )
@@ -532,31 +560,352 @@ static char* handleLengthQualifiers(ExprsDef_t *exprs, ExprsTerm_t *term, char *
 	return sEndp;
 }
 
+/* Each char's value plus one as a digit (0 if it isn't a hex digit) */
+static const unsigned char DigitValues[256] =
+{
+	['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5,
+	['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+	['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+	['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16
+};
+
+/* The radices a number is scanned in. Each one's digits are a subset of the next one's. */
+#define NUM_RADIX_2		0
+#define NUM_RADIX_8		1
+#define NUM_RADIX_10	2
+#define NUM_RADIX_16	3
+#define NUM_RADICES		4
+
+static const unsigned int NumRadices[NUM_RADICES] = { 2, 8, 10, 16 };
+
+/* What one pass over the digits of a number found in each radix */
+typedef struct
+{
+	uint64_t mValue[NUM_RADICES];	/* value of the digits (all ones if too big) */
+	const char *mEnd[NUM_RADICES];	/* first char that isn't a digit in the radix */
+} ExprsNumScan_t;
+
+static int numRadixIdx(int radix)
+{
+	switch (radix)
+	{
+	case 2:
+		return NUM_RADIX_2;
+	case 8:
+		return NUM_RADIX_8;
+	case 10:
+		return NUM_RADIX_10;
+	default:
+		return NUM_RADIX_16;
+	}
+}
+
+/** scanNumber - scan the digits of a number once getting its
+ *  value in every radix it might turn out to be in.
+ *
+ *  At entry:
+ *  @param startP - pointer to first digit
+ *  @param end - end of the text. Nothing at or past it is read
+ *  @param scan - pointer to place to deposit results
+ *
+ *  At exit:
+ *  @return nothing. The value and end of each radix are what
+ *  		strtoul() would have returned given that radix.
+ **/
+static void scanNumber(const char *startP, const char *end, ExprsNumScan_t *scan)
+{
+	const unsigned char *cp = (const unsigned char *)startP, *ep = (const unsigned char *)end;
+	unsigned int dig;
+	int ii, lo = 0;
+
+	for ( ii = 0; ii < NUM_RADICES; ++ii )
+		scan->mValue[ii] = 0;
+	for ( ; cp < ep && (dig = DigitValues[*cp]); ++cp )
+	{
+		--dig;
+		/* A digit too big for one radix is too big for all those below it, so they are done */
+		while ( dig >= NumRadices[lo] )
+			scan->mEnd[lo++] = (const char *)cp;
+		if ( cp - (const unsigned char *)startP < 15 )
+		{
+			/* Can't overflow yet even in hex */
+			for ( ii = lo; ii < NUM_RADICES; ++ii )
+				scan->mValue[ii] = scan->mValue[ii] * NumRadices[ii] + dig;
+			continue;
+		}
+		for ( ii = lo; ii < NUM_RADICES; ++ii )
+		{
+			if ( scan->mValue[ii] > (UINT64_MAX - dig) / NumRadices[ii] )
+				scan->mValue[ii] = UINT64_MAX;
+			else
+				scan->mValue[ii] = scan->mValue[ii] * NumRadices[ii] + dig;
+		}
+	}
+	while ( lo < NUM_RADICES )
+		scan->mEnd[lo++] = (const char *)cp;
+}
+
+/* Every power of ten a double holds exactly */
+static const double PowersOf10[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/** scanFloat - convert the text of a decimal floating point
+ *  number.
+ *
+ *  At entry:
+ *  @param exprs - pointer to ExprsDef_t. Nothing at or past its
+ *  			 mEndPtr is read.
+ *  @param startP - pointer to first digit
+ *  @param valueP - pointer to place to deposit the value
+ *  @param endPP - pointer to place to deposit pointer to the
+ *  			 first char past the number
+ *
+ *  At exit:
+ *  @return 0 on success, else no memory. The value is exactly
+ *  		as strtod() would have it.
+ *
+ *  @note When there are no more than 19 significant digits,
+ *  	  they fit in 53 bits and the power of ten is no more
+ *  	  than 22 (i.e. nearly every literal ever written) the
+ *  	  mantissa and the power of ten are both exact doubles so
+ *  	  a single multiply or divide is correctly rounded
+ *  	  (Clinger's fast path). Anything else goes to strtod()
+ *  	  by way of a null terminated copy of the number.
+ **/
+static ExprsErrs_t scanFloat(ExprsDef_t *exprs, const char *startP, double *valueP, const char **endPP)
+{
+	const char *cp = startP, *expP, *end = exprs->mEndPtr;
+	uint64_t mantissa = 0;
+	int numDigits = 0, exp10 = 0, expVal = 0;
+	bool expNeg = false;
+	char numBuf[128], *numText, *sEndp, eBuf[256];
+	size_t numLen;
+	double value;
+
+	for ( ; cp < end && *cp >= '0' && *cp <= '9'; ++cp )
+	{
+		if ( numDigits < 19 )
+			mantissa = mantissa * 10 + (*cp - '0');
+		else
+			++exp10;
+		numDigits += (mantissa != 0);
+	}
+	if ( cp < end && *cp == '.' )
+	{
+		for ( ++cp; cp < end && *cp >= '0' && *cp <= '9'; ++cp )
+		{
+			if ( numDigits < 19 )
+			{
+				mantissa = mantissa * 10 + (*cp - '0');
+				--exp10;
+			}
+			numDigits += (mantissa != 0);
+		}
+	}
+	if ( cp < end && (*cp == 'e' || *cp == 'E') )
+	{
+		/* Only an exponent if there are digits in it */
+		expP = cp + 1;
+		if ( expP < end && (*expP == '+' || *expP == '-') )
+			expNeg = (*expP++ == '-');
+		if ( expP < end && *expP >= '0' && *expP <= '9' )
+		{
+			for ( cp = expP; cp < end && *cp >= '0' && *cp <= '9'; ++cp )
+			{
+				if ( expVal < 10000 )
+					expVal = expVal * 10 + (*cp - '0');
+			}
+			exp10 += expNeg ? -expVal : expVal;
+		}
+	}
+	*endPP = cp;
+	*valueP = 0.0;
+	if ( !mantissa )
+		return EXPR_TERM_GOOD;
+	if ( numDigits <= 19 && mantissa <= ((uint64_t)1 << 53) && exp10 >= -22 && exp10 <= 22 )
+	{
+		value = (double)mantissa;
+		*valueP = exp10 < 0 ? value / PowersOf10[-exp10] : value * PowersOf10[exp10];
+		return EXPR_TERM_GOOD;
+	}
+	numLen = cp - startP;
+	numText = numBuf;
+	if ( numLen >= sizeof(numBuf) )
+	{
+		numText = (char *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, numLen + 1);
+		if ( !numText )
+		{
+			snprintf(eBuf, sizeof(eBuf), "scanFloat(): Failed to allocate " FMT_SZ " bytes: %s\n", numLen + 1, strerror(errno));
+			showMsg(exprs, EXPRS_SEVERITY_FATAL, eBuf);
+			return EXPR_TERM_BAD_OUT_OF_MEMORY;
+		}
+	}
+	memcpy(numText, startP, numLen);
+	numText[numLen] = 0;
+	*valueP = strtod(numText, &sEndp);
+	*endPP = startP + (sEndp - numText);
+	if ( numText != numBuf )
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, numText);
+	return EXPR_TERM_GOOD;
+}
+
+/** fmtInteger - format an integer as "%ld" would.
+ *
+ *  At entry:
+ *  @param dst - pointer to place to deposit text. Must have
+ *  		   room for at least 21 chars.
+ *  @param value - value to format
+ *
+ *  At exit:
+ *  @return number of chars deposited not counting the
+ *  		terminating nul.
+ **/
+static int fmtInteger(char *dst, int64_t value)
+{
+	static const char DigitPairs[] =
+		"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+		"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+		"8081828384858687888990919293949596979899";
+	char tmp[24], *cp = tmp + sizeof(tmp);
+	uint64_t mag = value < 0 ? -(uint64_t)value : (uint64_t)value;
+	int len;
+
+	while ( mag >= 100 )
+	{
+		cp -= 2;
+		memcpy(cp, DigitPairs + (mag % 100) * 2, 2);
+		mag /= 100;
+	}
+	if ( mag >= 10 )
+	{
+		cp -= 2;
+		memcpy(cp, DigitPairs + mag * 2, 2);
+	}
+	else
+		*--cp = (char)('0' + mag);
+	if ( value < 0 )
+		*--cp = '-';
+	len = (int)(tmp + sizeof(tmp) - cp);
+	memcpy(dst, cp, len);
+	dst[len] = 0;
+	return len;
+}
+
+/** fmtFloat - format a double as "%g" would.
+ *
+ *  At entry:
+ *  @param dst - pointer to place to deposit text. Must have
+ *  		   room for at least 32 chars.
+ *  @param value - value to format
+ *
+ *  At exit:
+ *  @return number of chars deposited not counting the
+ *  		terminating nul.
+ *
+ *  @note A value from 0.0001 up to 999999 with no more than 6
+ *  	  significant digits is found to be one when scaling it
+ *  	  by a power of ten gives a whole number. %g would print
+ *  	  exactly those digits so they are formatted here. Other
+ *  	  values are left to snprintf().
+ **/
+static int fmtFloat(char *dst, double value)
+{
+	double mag = fabs(value), scaled;
+	int64_t whole, frac;
+	int ii, kk, len = 0;
+
+	if ( value == 0.0 )
+	{
+		if ( signbit(value) )
+			dst[len++] = '-';
+		dst[len++] = '0';
+		dst[len] = 0;
+		return len;
+	}
+	if ( mag >= 1e-4 && mag < 1e6 )
+	{
+		for ( kk = 0; kk <= 10; ++kk )
+		{
+			scaled = mag * PowersOf10[kk];
+			if ( scaled >= 1e6 )
+				break;
+			if ( scaled != floor(scaled) )
+				continue;
+			if ( value < 0 )
+				dst[len++] = '-';
+			whole = (int64_t)scaled / (int64_t)PowersOf10[kk];
+			frac = (int64_t)scaled % (int64_t)PowersOf10[kk];
+			len += fmtInteger(dst + len, whole);
+			if ( frac )
+			{
+				/* %g drops trailing zeros */
+				while ( !(frac % 10) )
+				{
+					frac /= 10;
+					--kk;
+				}
+				dst[len++] = '.';
+				for ( ii = kk - 1; ii >= 0; --ii, frac /= 10 )
+					dst[len + ii] = (char)('0' + frac % 10);
+				len += kk;
+				dst[len] = 0;
+			}
+			return len;
+		}
+	}
+	return snprintf(dst, 32, "%g", value);
+}
+
+/** storeInteger - push an integer term.
+ *
+ *  At entry:
+ *  @param exprs - pointer to ExprsDef_t
+ *  @param sPtr - stack to push onto
+ *  @param term - term to fill in
+ *  @param startP - pointer to first digit
+ *  @param scan - results of scanNumber(startP). May be NULL in
+ *  			which case it is done here.
+ *  @param suffix - char that has to follow the digits
+ *  @param eatSuffix - true if there is a suffix
+ *  @param radix - radix of the number
+ *  @param rdxName - name of radix for verbose messages
+ *
+ *  At exit:
+ *  @return 0 on success, else error. mCurrPtr is advanced past
+ *  		the number and its suffix.
+ **/
 static ExprsErrs_t storeInteger(ExprsDef_t *exprs,
 								ExprsStack_t *sPtr,
 								ExprsTerm_t *term,
 								const char *startP,
+								const ExprsNumScan_t *scan,
 								char suffix,
 								bool eatSuffix,
 								int radix,
-								const char *rdxName,
-								bool skipStrtol)
+								const char *rdxName)
 {
-	char *sEndp;
+	ExprsNumScan_t lclScan;
+	const char *sEndp;
 	char eBuf[512];
+	int idx = numRadixIdx(radix);
 
-	if ( !skipStrtol )
+	if ( !scan )
 	{
-		sEndp = NULL;
-		term->term.s64 = strtoll(startP, &sEndp, radix);
-		if ( !sEndp || sEndp == startP || (eatSuffix && toupper(*sEndp) != suffix) )
-			return EXPR_TERM_BAD_NUMBER;
-		if ( (exprs->mFlags & EXPRS_FLG_LEN_QUALIFIERS) && *sEndp == '.' )
-			sEndp = handleLengthQualifiers(exprs, term, sEndp, &eatSuffix);
-		if ( eatSuffix )
-			++sEndp;
-		exprs->mCurrPtr = sEndp;
+		scanNumber(startP, exprs->mEndPtr, &lclScan);
+		scan = &lclScan;
 	}
+	sEndp = scan->mEnd[idx];
+	term->term.u64 = scan->mValue[idx];
+	if ( sEndp == startP || (eatSuffix && toupper(lexPeek(exprs, sEndp)) != suffix) )
+		return EXPR_TERM_BAD_NUMBER;
+	if ( (exprs->mFlags & EXPRS_FLG_LEN_QUALIFIERS) && lexPeek(exprs, sEndp) == '.' )
+		sEndp = handleLengthQualifiers(exprs, term, sEndp, &eatSuffix);
+	if ( eatSuffix )
+		++sEndp;
+	exprs->mCurrPtr = sEndp;
 	term->termType = EXPRS_TERM_INTEGER;
 	if ( exprs->mVerbose )
 	{
@@ -568,11 +917,188 @@ static ExprsErrs_t storeInteger(ExprsDef_t *exprs,
 	return EXPR_TERM_GOOD;
 }
 
+/* Character class runs for the lexer. Each run is described by a 16 byte
+ * table built from CttblNormal/CttblSpecial: bit N of entry L is set if the
+ * character (N<<4)|L is in the run. That is the layout pshufb wants, so the
+ * vector scanners test 16 or 32 characters with a couple of shuffles. Bytes
+ * with the top bit set are never in a run and are left to the callers. */
+typedef enum
+{
+	LexIdent,		/* symbol name: A-Z, a-z, $, _, 0-9 and . */
+	LexIdentCol,	/* same plus : (EXPRS_FLG_LEN_QUALIFIERS) */
+	LexWhite,		/* space and tab */
+	LexStrDq,		/* inside "": anything but EOL, \ and " */
+	LexStrSq,		/* inside '': anything but EOL, \ and ' */
+	LexStrBq,		/* inside ``: anything but EOL, \ and ` */
+	LexNumRuns
+} LexRun_t;
+
+typedef const char *(*LexScan_t)(const uint8_t *run, const char *ptr, const char *end);
+
+static struct
+{
+	int isa;								/* EXPRS_LEX_ISA_xxx in use */
+	LexScan_t scan;							/* finds the end of a run */
+	uint8_t runs[2][LexNumRuns][16];		/* [0]=CttblNormal, [1]=CttblSpecial */
+} LexScanner;
+
+static pthread_once_t LexScannerOnce = PTHREAD_ONCE_INIT;
+static int LexMaxIsa = EXPRS_LEX_ISA_AVX2;
+
+static const char *lexScanScalar(const uint8_t *run, const char *ptr, const char *end)
+{
+	uint8_t cc;
+
+	while ( ptr < end && (cc = *ptr) < 0x80 && (run[cc & 15] & (1 << (cc >> 4))) )
+		++ptr;
+	return ptr;
+}
+
+#if EXPRS_BATCH_SIMD
+/* The loads are aligned so they never cross into a page the text doesn't
+ * reach. Bits before ptr in the first block and at or past end in the last
+ * one are masked off, so the scan stops at end at the latest. */
+__attribute__((target("ssse3"), no_sanitize_address))
+static const char *lexScanSsse3(const uint8_t *run, const char *ptr, const char *end)
+{
+	const __m128i table = _mm_loadu_si128((const __m128i *)run);
+	const __m128i hiBits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)0x80, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i nibble = _mm_set1_epi8(0x0F), zero = _mm_setzero_si128();
+	const char *base = (const char *)((uintptr_t)ptr & ~(uintptr_t)15);
+	unsigned int misses = 0xFFFFu << (ptr - base);
+
+	if ( ptr >= end )
+		return ptr;
+	while ( 1 )
+	{
+		__m128i blk = _mm_load_si128((const __m128i *)base);
+		__m128i row = _mm_shuffle_epi8(table, _mm_and_si128(blk, nibble));
+		__m128i bit = _mm_shuffle_epi8(hiBits, _mm_and_si128(_mm_srli_epi16(blk, 4), nibble));
+
+		misses &= _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(row, bit), zero));
+		if ( end - base < 16 )
+			misses |= 0xFFFFu << (end - base);
+		if ( misses )
+			return base + __builtin_ctz(misses);
+		base += 16;
+		if ( base >= end )
+			return end;
+		misses = 0xFFFFu;
+	}
+}
+
+__attribute__((target("avx2"), no_sanitize_address))
+static const char *lexScanAvx2(const uint8_t *run, const char *ptr, const char *end)
+{
+	const __m256i table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)run));
+	const __m256i hiBits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)0x80, 0, 0, 0, 0, 0, 0, 0, 0,
+											1, 2, 4, 8, 16, 32, 64, (char)0x80, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i nibble = _mm256_set1_epi8(0x0F), zero = _mm256_setzero_si256();
+	const char *base = (const char *)((uintptr_t)ptr & ~(uintptr_t)31);
+	uint32_t misses = 0xFFFFFFFFu << (ptr - base);
+
+	if ( ptr >= end )
+		return ptr;
+	while ( 1 )
+	{
+		__m256i blk = _mm256_load_si256((const __m256i *)base);
+		__m256i row = _mm256_shuffle_epi8(table, _mm256_and_si256(blk, nibble));
+		__m256i bit = _mm256_shuffle_epi8(hiBits, _mm256_and_si256(_mm256_srli_epi16(blk, 4), nibble));
+
+		misses &= (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(row, bit), zero));
+		if ( end - base < 32 )
+			misses |= 0xFFFFFFFFu << (end - base);
+		if ( misses )
+			return base + __builtin_ctz(misses);
+		base += 32;
+		if ( base >= end )
+			return end;
+		misses = 0xFFFFFFFFu;
+	}
+}
+#endif	/* EXPRS_BATCH_SIMD */
+
+static void lexBuildRuns(uint8_t runs[LexNumRuns][16], const uint16_t *chTbl)
+{
+	static const char Quotes[] = { '"', '\'', '`' };
+	int cc, qq;
+
+	memset(runs, 0, LexNumRuns * 16);
+	for ( cc = 1; cc < 0x80; ++cc )
+	{
+		uint16_t chMask = chTbl[cc];
+		uint8_t bit = 1 << (cc >> 4);
+
+		if ( (chMask & (CT_EALP | CT_NUM | CT_DOT)) )
+		{
+			runs[LexIdent][cc & 15] |= bit;
+			runs[LexIdentCol][cc & 15] |= bit;
+		}
+		if ( (chMask & CT_COL) )
+			runs[LexIdentCol][cc & 15] |= bit;
+		if ( (chMask & CT_WS) )
+			runs[LexWhite][cc & 15] |= bit;
+		if ( (chMask & CT_EOL) || cc == '\\' )
+			continue;
+		for ( qq = 0; qq < (int)n_elts(Quotes); ++qq )
+		{
+			if ( cc != Quotes[qq] )
+				runs[LexStrDq + qq][cc & 15] |= bit;
+		}
+	}
+}
+
+static void lexPickScanner(void)
+{
+	lexBuildRuns(LexScanner.runs[0], CttblNormal);
+	lexBuildRuns(LexScanner.runs[1], CttblSpecial);
+	LexScanner.isa = EXPRS_LEX_ISA_SCALAR;
+	LexScanner.scan = lexScanScalar;
+#if EXPRS_BATCH_SIMD
+	__builtin_cpu_init();
+	if ( LexMaxIsa >= EXPRS_LEX_ISA_AVX2 && __builtin_cpu_supports("avx2") )
+	{
+		LexScanner.isa = EXPRS_LEX_ISA_AVX2;
+		LexScanner.scan = lexScanAvx2;
+	}
+	else if ( LexMaxIsa >= EXPRS_LEX_ISA_SSSE3 && __builtin_cpu_supports("ssse3") )
+	{
+		LexScanner.isa = EXPRS_LEX_ISA_SSSE3;
+		LexScanner.scan = lexScanSsse3;
+	}
+#endif
+}
+
+int libExprsSetLexIsa(int maxIsa)
+{
+	pthread_once(&LexScannerOnce, lexPickScanner);
+	LexMaxIsa = maxIsa;
+	lexPickScanner();
+	return LexScanner.isa;
+}
+
+/** lexSkip - skip over a run of characters of one class.
+ *
+ *  At entry:
+ *  @param exprs - pointer to expression definition (for its character table)
+ *  @param run - which run to skip
+ *  @param ptr - where to start
+ *
+ *  At exit:
+ *  @return pointer to the first character not in the run (may be ptr)
+ *  		or exprs->mEndPtr if the run reaches it.
+ **/
+static const char *lexSkip(const ExprsDef_t *exprs, LexRun_t run, const char *ptr)
+{
+	return LexScanner.scan(LexScanner.runs[exprs->chMaskPtr == CttblSpecial][run], ptr, exprs->mEndPtr);
+}
+
 static ExprsErrs_t handleString(ExprsDef_t *exprs, ExprsStack_t *sPtr, ExprsTerm_t *term, char cc)
 {
-	int strLen;
-	const char *endP;
-	char *newPtr, *sEndP, quoteChar = cc, *dst;
+	int strLen, runLen;
+	const char *endP, *runEnd;
+	char *newPtr, quoteChar = cc, *dst;
+	LexRun_t strRun;
 	uint16_t chMask;
 	char eBuf[512];
 
@@ -581,9 +1107,11 @@ static ExprsErrs_t handleString(ExprsDef_t *exprs, ExprsStack_t *sPtr, ExprsTerm
 		if ( quoteChar != '"' && (exprs->mFlags & EXPRS_FLG_SINGLE_QUOTE) )
 		{
 			endP = exprs->mCurrPtr + 1;       /* Skip starting quote char */
-			cc = *endP++;
+			cc = lexPeek(exprs, endP);
+			if ( endP < exprs->mEndPtr )
+				++endP;
 			/* optionally eat a trailing quote */
-			if ( *endP == '\'' )
+			if ( lexPeek(exprs, endP) == '\'' )
 				++endP;
 			term->term.s64 = cc;
 			term->termType = EXPRS_TERM_INTEGER;
@@ -601,18 +1129,21 @@ static ExprsErrs_t handleString(ExprsDef_t *exprs, ExprsStack_t *sPtr, ExprsTerm
 	}
 	else
 	{
+		strRun = (quoteChar == '"') ? LexStrDq : (quoteChar == '\'') ? LexStrSq : LexStrBq;
 		endP = exprs->mCurrPtr + 1;       /* Skip starting quote char */
 		/* find end of string */
-		while ( (cc = *endP) )
+		while ( (endP = lexSkip(exprs, strRun, endP)) < exprs->mEndPtr )
 		{
+			cc = *endP;
 			chMask = exprs->chMaskPtr[(int)cc];
 			if ( (chMask & CT_EOL) )
 				return EXPR_TERM_BAD_NO_STRING_TERM;
 			++endP;	/* advance over the char */
 			if ( cc == '\\' )
 			{
-				/* skip over whatever char is following the backslash */
-				++endP;
+				/* skip over whatever char is following the backslash (but not the end of the text) */
+				if ( endP < exprs->mEndPtr )
+					++endP;
 				continue;
 			}
 			if ( cc == quoteChar )
@@ -628,25 +1159,39 @@ static ExprsErrs_t handleString(ExprsDef_t *exprs, ExprsStack_t *sPtr, ExprsTerm
 	dst = newPtr;
 	term->term.string = newPtr - libExprsStringPoolTop(exprs);
 	*newPtr = 0;
-	while ( (cc = *endP) && dst < newPtr + strLen )
+	while ( (cc = lexPeek(exprs, endP)) && dst < newPtr + strLen )
 	{
+		runEnd = lexSkip(exprs, strRun, endP);
+		if ( runEnd != endP )
+		{
+			/* copy plain characters a run at a time */
+			runLen = runEnd - endP;
+			if ( runLen > newPtr + strLen - dst )
+				runLen = newPtr + strLen - dst;
+			memcpy(dst, endP, runLen);
+			dst += runLen;
+			endP += runLen;
+			continue;
+		}
 		chMask = exprs->chMaskPtr[(int)cc];
 		if ( (chMask & CT_EOL) )
 			break;
 		if ( cc == '\\' )
 		{
 			unsigned char cvt;
-			cc = endP[1];
+			cc = lexPeek(exprs, endP + 1);
+			if ( !cc )
+				break;
 			cvt = cc;
 			if ( cc >= '0' && cc <= '7' )
 			{
 				cvt = cc - '0';
-				cc = endP[2];
+				cc = lexPeek(exprs, endP + 2);
 				if ( cc >= '0' && cc <= '7' )
 				{
 					cvt <<= 3;
 					cvt |= cc - '0';
-					cc = endP[3];
+					cc = lexPeek(exprs, endP + 3);
 					if ( cc >= '0' && cc <= '7' )
 					{
 						cvt <<= 3;
@@ -658,12 +1203,17 @@ static ExprsErrs_t handleString(ExprsDef_t *exprs, ExprsStack_t *sPtr, ExprsTerm
 			}
 			else if ( cc == 'x' )
 			{
-				sEndP = NULL;
-				cvt = strtol(endP + 1, &sEndP, 16);
-				if ( sEndP )
+				const char *hexP;
+				unsigned int dig;
+
+				/* One or two hex digits. Without any it is just an 'x' */
+				cvt = 0;
+				for ( hexP = endP + 2; hexP < endP + 4 && (dig = DigitValues[(unsigned char)lexPeek(exprs, hexP)]); ++hexP )
+					cvt = (cvt << 4) | (dig - 1);
+				if ( hexP > endP + 2 )
 				{
 					*dst++ = cvt;
-					endP = sEndP;
+					endP = hexP;
 					continue;
 				}
 				cvt = cc;
@@ -724,21 +1274,10 @@ static ExprsErrs_t handleSymbol(ExprsDef_t *exprs, ExprsTerm_t *term, ExprsStack
 {
 	size_t symLen;
 	const char *endP;
-	char cc, *strPtr;
-	uint16_t chMask, chChk;
+	char *strPtr;
 
 	/* symbol */
-	endP = exprs->mCurrPtr;
-	chChk = (CT_EALP | CT_NUM | CT_DOT);
-	if ( (exprs->mFlags & EXPRS_FLG_LEN_QUALIFIERS) )
-		chChk |= CT_COL;
-	while ( (cc = *endP) )
-	{
-		chMask = exprs->chMaskPtr[(int)cc];
-		if ( !(chMask & chChk) )
-			break;
-		++endP;
-	}
+	endP = lexSkip(exprs, (exprs->mFlags & EXPRS_FLG_LEN_QUALIFIERS) ? LexIdentCol : LexIdent, exprs->mCurrPtr);
 	symLen = endP - exprs->mCurrPtr;
 	if ( !symLen )
 		return EXPR_TERM_BAD_SYMBOL_SYNTAX;
@@ -797,11 +1336,100 @@ static ExprsTerm_t* getAnotherTerm(ExprsDef_t *exprs, ExprsStack_t *sPtr, int op
 	return term;
 }
 
-static void removeCrLf(char *dst, int dstLen, const char *src)
+/** patchSkip - set how many terms a skip term skips now that
+ *  the && or || it belongs to is about to be pushed to the term
+ *  stack.
+ *
+ *  At entry:
+ *  @param exprs - pointer to ExprsDef_t
+ *  @param sPtr - term stack. The && or || is at the slot just
+ *  			past the last one used.
+ *  @param skipIdx - index of the skip term
+ *
+ *  At exit:
+ *  @return nothing.
+ *
+ *  @note Skipping is only safe when the right side is exactly
+ *  	  one well formed operand. When it isn't (e.g. "1||2 3")
+ *  	  the skip term is removed so the && or || is evaluated
+ *  	  in full and reports whatever error it would without
+ *  	  short-circuiting.
+ **/
+static void patchSkip(ExprsDef_t *exprs, ExprsStack_t *sPtr, int skipIdx)
+{
+	ExprsTerm_t *terms = libExprsTermPoolTop(exprs, sPtr);
+	int ii, numUsed = sPtr->mTermsPool.mNumUsed, depth = 0, nOpers;
+
+	for ( ii = skipIdx + 1; ii < numUsed; ++ii )
+	{
+		switch (terms[ii].termType)
+		{
+		case EXPRS_TERM_NULL:
+			continue;
+		case EXPRS_TERM_SYMBOL:
+		case EXPRS_TERM_SYMBOL_COMPLEX:
+		case EXPRS_TERM_FUNCTION:
+		case EXPRS_TERM_STRING:
+		case EXPRS_TERM_FLOAT:
+		case EXPRS_TERM_INTEGER:
+			++depth;
+			continue;
+		case EXPRS_TERM_POS:
+		case EXPRS_TERM_NEG:
+		case EXPRS_TERM_COM:
+		case EXPRS_TERM_NOT:
+		case EXPRS_TERM_HIGH_BYTE:
+		case EXPRS_TERM_LOW_BYTE:
+		case EXPRS_TERM_SWAP:
+		case EXPRS_TERM_SKIP_FALSE:
+		case EXPRS_TERM_SKIP_TRUE:
+			nOpers = 1;
+			break;
+		case EXPRS_TERM_POW:
+		case EXPRS_TERM_MUL:
+		case EXPRS_TERM_DIV:
+		case EXPRS_TERM_MOD:
+		case EXPRS_TERM_ADD:
+		case EXPRS_TERM_SUB:
+		case EXPRS_TERM_SHL:
+		case EXPRS_TERM_SHR:
+		case EXPRS_TERM_GT:
+		case EXPRS_TERM_GE:
+		case EXPRS_TERM_LT:
+		case EXPRS_TERM_LE:
+		case EXPRS_TERM_EQ:
+		case EXPRS_TERM_NE:
+		case EXPRS_TERM_AND:
+		case EXPRS_TERM_XOR:
+		case EXPRS_TERM_OR:
+		case EXPRS_TERM_LAND:
+		case EXPRS_TERM_LOR:
+		case EXPRS_TERM_ASSIGN:
+			nOpers = 2;
+			break;
+		default:
+			nOpers = numUsed;	/* Unknown. Never safe to skip */
+			break;
+		}
+		if ( depth < nOpers )
+			break;
+		depth -= nOpers - 1;
+	}
+	if ( ii >= numUsed && depth == 1 )
+	{
+		terms[skipIdx].term.link = numUsed - skipIdx;
+		return;
+	}
+	/* Slide the right side and the && or || itself down over the skip term */
+	memmove(terms + skipIdx, terms + skipIdx + 1, (numUsed - skipIdx) * sizeof(ExprsTerm_t));
+	--sPtr->mTermsPool.mNumUsed;
+}
+
+static void removeCrLf(char *dst, int dstLen, const char *src, const char *end)
 {
 	if ( dst && dstLen > 1 )
 	{
-		while ( dstLen > 1 && *src )
+		while ( dstLen > 1 && src < end && *src )
 		{
 			if ( (*dst = *src++) == '\n' )
 				break;
@@ -841,9 +1469,10 @@ static void removeCrLf(char *dst, int dstLen, const char *src)
 static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastTermType)
 {
 	uint16_t chMask = CT_EOL;
-	char cc, *operPtr, *sEndp;
+	char cc, *operPtr;
 	const char *startP, *endP;
 	ExprsTerm_t * term, operStack[8];
+	int skipIdx[n_elts(operStack)];	/* index of the skip term emitted for a && or || in operStack[] */
 	ExprsErrs_t err, peRetV;
 	bool exitOut = false;
 	char eBuf[512];
@@ -856,7 +1485,7 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 	if ( exprs->mVerbose )
 	{
 		char noLf[128 + 64];
-		removeCrLf(noLf, sizeof(noLf), exprs->mCurrPtr);
+		removeCrLf(noLf, sizeof(noLf), exprs->mCurrPtr, exprs->mEndPtr);
 		snprintf(eBuf, sizeof(eBuf), "parseExpression(): Entry. nest=%d, lastTermType=%d, numTerms=%d, expr='%s'\n",
 				 nest,
 				 lastTermType,
@@ -881,7 +1510,7 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 	{
 		int tMask;
 
-		cc = *exprs->mCurrPtr;
+		cc = lexPeek(exprs, exprs->mCurrPtr);
 		chMask = exprs->chMaskPtr[(int)cc];
 		if ( (chMask & (CT_EOL | CT_COM | CT_SMC)) )
 		{
@@ -896,7 +1525,7 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 				break;
 			}
 			/* Eat whitespace */
-			++exprs->mCurrPtr;
+			exprs->mCurrPtr = lexSkip(exprs, LexWhite, exprs->mCurrPtr);
 			continue;
 		}
 		if ( (exprs->mOpenDelimiter != '(' && cc == '(') || (exprs->mCloseDelimiter != ')' && cc == ')') )
@@ -912,7 +1541,7 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 		if ( exprs->mVerbose )
 		{
 			char noLf[128 + 64];
-			removeCrLf(noLf, sizeof(noLf), exprs->mCurrPtr);
+			removeCrLf(noLf, sizeof(noLf), exprs->mCurrPtr, exprs->mEndPtr);
 			snprintf(eBuf, sizeof(eBuf), "parseExpression(): Processing term[%d], cc=%c, chMask=0x%04X, flags=0x%X, operUsed=%d, lastTermType=%d: '%s'\n",
 					 sPtr->mTermsPool.mNumUsed,
 					 isprint(cc) ? cc : '.',
@@ -972,7 +1601,7 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 			}
 			startP = exprs->mCurrPtr + 1;
 			lastTermType = TermIsPlain;
-			retV = storeInteger(exprs, sPtr, term, startP, 0, false, 16, "HEX", 0);
+			retV = storeInteger(exprs, sPtr, term, startP, NULL, 0, false, 16, "HEX");
 			if ( retV )
 				return badSyntax(exprs, chMask, cc, retV);
 			continue;
@@ -995,7 +1624,8 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 		}
 		if ( (chMask & CT_NUM) )
 		{
-			int lRadix;
+			ExprsNumScan_t numScan;
+			int lRadix, idx;
 			/* number */
 
 			if ( (exprs->mFlags & EXPRS_FLG_NO_DOUBLE_PLAIN) && lastTermType == TermIsPlain )
@@ -1006,21 +1636,24 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 			startP = exprs->mCurrPtr;
 			if ( cc == '0' )
 			{
-				char ucc = toupper(exprs->mCurrPtr[1]);
+				char ucc = toupper(lexPeek(exprs, exprs->mCurrPtr + 1));
+				unsigned int nextDig = ucc ? DigitValues[(unsigned char)lexPeek(exprs, exprs->mCurrPtr + 2)] : 0;
+
 				if ( ucc == 'X' )
 				{
 					startP += 2;
 					lastTermType = TermIsPlain;
-					retV = storeInteger(exprs, sPtr, term, startP, 0, false, 16, "HEX", 0);
+					retV = storeInteger(exprs, sPtr, term, startP, NULL, 0, false, 16, "HEX");
 					if ( retV )
 						return badSyntax(exprs, chMask, cc, retV);
 					continue;
 				}
-				if ( ucc == 'O' )
+				/* With EXPRS_FLG_O_OCTAL and no decimal digit after it "0O" is an octal 0, not a prefix */
+				if ( ucc == 'O' && ((nextDig && nextDig <= 10) || !(exprs->mFlags & EXPRS_FLG_O_OCTAL)) )
 				{
 					startP += 2;
 					lastTermType = TermIsPlain;
-					retV = storeInteger(exprs, sPtr, term, startP, 0, false, 8, "Octal", 0);
+					retV = storeInteger(exprs, sPtr, term, startP, NULL, 0, false, 8, "Octal");
 					if ( retV )
 						return badSyntax(exprs, chMask, cc, retV);
 					continue;
@@ -1030,7 +1663,7 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 				{
 					startP += 2;
 					lastTermType = TermIsPlain;
-					retV = storeInteger(exprs,sPtr,term,startP,0,false,10,"Decimal",0);
+					retV = storeInteger(exprs, sPtr, term, startP, NULL, 0, false, 10, "Decimal");
 					if ( retV )
 					return badSyntax(exprs,chMask,cc,retV);
 					continue;
@@ -1039,55 +1672,40 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 				{
 					startP += 2;
 					lastTermType = TermIsPlain;
-					retV = storeInteger(exprs,sPtr,term,startP,0,false,2,"Binary",0);
+					retV = storeInteger(exprs, sPtr, term, startP, NULL, 0, false, 2, "Binary");
 					if ( retV )
 					return badSyntax(exprs,chMask,cc,retV);
 					continue;
 				}
 #endif
 			}
-			sEndp = NULL;
-			term->term.s64 = strtoul(startP, &sEndp, 16);
-			if ( !sEndp )
-				return badSyntax(exprs, chMask, cc, EXPR_TERM_BAD_NUMBER);
-			cc = toupper(*sEndp);
-			if ( (exprs->mFlags & EXPRS_FLG_POST_DOLLAR_HEX) && cc == '$' )
-			{
-				lastTermType = TermIsPlain;
-				retV = storeInteger(exprs, sPtr, term, startP, 0, false, 16, "HEX", true);
-				if ( retV )
-					return badSyntax(exprs, chMask, cc, retV);
-				exprs->mCurrPtr = sEndp + 1;
-				continue;
-			}
-			if ( (exprs->mFlags & EXPRS_FLG_H_HEX) && cc == 'H' )
+			/* One pass over the digits gets the value in every radix. The suffix (if any) picks which. */
+			scanNumber(startP, exprs->mEndPtr, &numScan);
+			cc = toupper(lexPeek(exprs, numScan.mEnd[NUM_RADIX_16]));
+			if (    ((exprs->mFlags & EXPRS_FLG_POST_DOLLAR_HEX) && cc == '$')
+				 || ((exprs->mFlags & EXPRS_FLG_H_HEX) && cc == 'H')
+			   )
 			{
 				lastTermType = TermIsPlain;
-				retV = storeInteger(exprs, sPtr, term, startP, 0, false, 16, "HEX", true);
+				retV = storeInteger(exprs, sPtr, term, startP, &numScan, cc, true, 16, "HEX");
 				if ( retV )
 					return badSyntax(exprs, chMask, cc, retV);
-				exprs->mCurrPtr = sEndp + 1;
 				continue;
 			}
 			if (    ((exprs->mFlags & EXPRS_FLG_O_OCTAL) && (cc == 'O'))
 				 || ((exprs->mFlags & EXPRS_FLG_Q_OCTAL) && (cc == 'Q'))
 			   )
 			{
-				/* try the number using octal to see if a 'O' or 'Q' follows */
-				term->term.s64 = strtoul(startP, &sEndp, 8);
-				if ( !sEndp )
-					return badSyntax(exprs, chMask, cc, EXPR_TERM_BAD_NUMBER);
-				cc = toupper(*sEndp);
+				/* Legit only if all the digits are octal */
+				cc = toupper(lexPeek(exprs, numScan.mEnd[NUM_RADIX_8]));
 				if (    ((exprs->mFlags & EXPRS_FLG_O_OCTAL) && cc == 'O')
 					 || ((exprs->mFlags & EXPRS_FLG_Q_OCTAL) && cc == 'Q')
 				   )
 				{
-					/* yep, legit */
 					lastTermType = TermIsPlain;
-					retV = storeInteger(exprs, sPtr, term, startP, 0, false, 8, "Octal", true);
+					retV = storeInteger(exprs, sPtr, term, startP, &numScan, cc, true, 8, "Octal");
 					if ( retV )
 						return badSyntax(exprs, chMask, cc, retV);
-					exprs->mCurrPtr = sEndp + 1;
 					continue;
 				}
 			}
@@ -1104,47 +1722,31 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 			if ( (exprs->mFlags & EXPRS_FLG_NO_FLOAT) && cc == '.' )
 			{
 				lastTermType = TermIsPlain;
-				retV = storeInteger(exprs, sPtr, term, startP, '.', true, 10, "Decimal", 0);
+				retV = storeInteger(exprs, sPtr, term, startP, &numScan, '.', true, 10, "Decimal");
 				if ( retV )
 					return badSyntax(exprs, chMask, cc, retV);
 				continue;
 			}
 			if ( !(exprs->mFlags & EXPRS_FLG_NO_FLOAT) && (lRadix == 10) && (cc == '.' || cc == 'E') )
 			{
-				sEndp = NULL;
-				term->term.f64 = strtod(startP, &sEndp);
-				if ( sEndp )
+				if ( (err = scanFloat(exprs, startP, &term->term.f64, &endP)) )
+					return err;
+				if ( exprs->mVerbose )
 				{
-					endP = sEndp;
-					if ( exprs->mVerbose )
-					{
-						snprintf(eBuf, sizeof(eBuf), "parseExpression(): Pushed to terms[%d] a FLOAT %g. operUsed=%d.\n",
-								 sPtr->mTermsPool.mNumUsed, term->term.f64, operUsed);
-						showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
-					}
-					exprs->mCurrPtr = endP;
-					term->termType = EXPRS_TERM_FLOAT;
-					++sPtr->mTermsPool.mNumUsed;
-					lastTermType = TermIsPlain;
-					continue;
+					snprintf(eBuf, sizeof(eBuf), "parseExpression(): Pushed to terms[%d] a FLOAT %g. operUsed=%d.\n",
+							 sPtr->mTermsPool.mNumUsed, term->term.f64, operUsed);
+					showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
 				}
-			}
-			/* not a number with a 'H' or '$' or 'O' or 'Q' or '.' or 'E' suffix */
-			if ( lRadix == 16 )
-			{
-				/* already converted text to hex */
+				exprs->mCurrPtr = endP;
+				term->termType = EXPRS_TERM_FLOAT;
+				++sPtr->mTermsPool.mNumUsed;
 				lastTermType = TermIsPlain;
-				retV = storeInteger(exprs, sPtr, term, startP, 0, false, 16, "HEX", true);
-				if ( retV )
-					return badSyntax(exprs, chMask, *startP, retV);
-				exprs->mCurrPtr = sEndp;
 				continue;
 			}
-			/* re-convert according to desired radix */
-			term->term.s64 = strtoul(startP, &sEndp, lRadix);
-			if ( !sEndp )
-				return badSyntax(exprs, chMask, cc, EXPR_TERM_BAD_NUMBER);
-			endP = sEndp;
+			/* not a number with a 'H' or '$' or 'O' or 'Q' or '.' or 'E' suffix */
+			idx = numRadixIdx(lRadix);
+			term->term.u64 = numScan.mValue[idx];
+			endP = numScan.mEnd[idx];
 			if ( exprs->mVerbose )
 			{
 				snprintf(eBuf, sizeof(eBuf), "parseExpression(): Pushed to terms[%d] a plain Integer %ld. operUsed=%d. flags=0x%X, mRadix=%d\n",
@@ -1229,7 +1831,7 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 			break;
 		case '*':
 			*operPtr++ = cc;
-			if ( exprs->mCurrPtr[1] == '*' )
+			if ( lexPeek(exprs, exprs->mCurrPtr + 1) == '*' )
 			{
 				if ( (exprs->mFlags & EXPRS_FLG_NO_POWER) )
 					return badSyntax(exprs, chMask, cc, EXPR_TERM_BAD_SYNTAX);
@@ -1253,7 +1855,7 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 			break;
 		case '|':
 			*operPtr++ = cc;
-			if ( exprs->mCurrPtr[1] == '|' )
+			if ( lexPeek(exprs, exprs->mCurrPtr + 1) == '|' )
 			{
 				term->termType = EXPRS_TERM_LOR;
 				*operPtr++ = cc;
@@ -1265,7 +1867,7 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 			break;
 		case '&':
 			*operPtr++ = cc;
-			if ( exprs->mCurrPtr[1] == '&' )
+			if ( lexPeek(exprs, exprs->mCurrPtr + 1) == '&' )
 			{
 				term->termType = EXPRS_TERM_LAND;
 				*operPtr++ = cc;
@@ -1279,13 +1881,13 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 			if ( lastTermType != TermIsPlain )
 			{
 				++exprs->mCurrPtr;  /* eat the up arrow*/
-				cc = *exprs->mCurrPtr;
+				cc = lexPeek(exprs, exprs->mCurrPtr);
 				cc = toupper(cc);   /* Expecting one of B, C, D, H, O, V, X, ~ or ^ */
 				startP = exprs->mCurrPtr + 1;
 				switch (cc)
 				{
 				case 'B':
-					retV = storeInteger(exprs, sPtr, term, startP, 0, false, 2, "Binary", 0);
+					retV = storeInteger(exprs, sPtr, term, startP, NULL, 0, false, 2, "Binary");
 					if ( retV )
 						return badSyntax(exprs, chMask, cc, retV);
 					lastTermType = TermIsPlain;
@@ -1296,20 +1898,20 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 					currTermType = TermIsUnary;
 					break;
 				case 'D':
-					retV = storeInteger(exprs, sPtr, term, startP, 0, false, 10, "Decimal", 0);
+					retV = storeInteger(exprs, sPtr, term, startP, NULL, 0, false, 10, "Decimal");
 					if ( retV )
 						return badSyntax(exprs, chMask, cc, retV);
 					lastTermType = TermIsPlain;
 					continue;
 				case 'X':
 				case 'H':
-					retV = storeInteger(exprs, sPtr, term, startP, 0, false, 16, "Hex", 0);
+					retV = storeInteger(exprs, sPtr, term, startP, NULL, 0, false, 16, "Hex");
 					if ( retV )
 						return badSyntax(exprs, chMask, cc, retV);
 					lastTermType = TermIsPlain;
 					continue;
 				case 'O':
-					retV = storeInteger(exprs, sPtr, term, startP, 0, false, 8, "Octal", 0);
+					retV = storeInteger(exprs, sPtr, term, startP, NULL, 0, false, 8, "Octal");
 					if ( retV )
 						return badSyntax(exprs, chMask, cc, retV);
 					lastTermType = TermIsPlain;
@@ -1364,7 +1966,7 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 			else
 			{
 				*operPtr++ = cc;
-				if ( exprs->mCurrPtr[1] == '=' )
+				if ( lexPeek(exprs, exprs->mCurrPtr + 1) == '=' )
 				{
 					term->termType = EXPRS_TERM_NE;
 					*operPtr++ = '=';
@@ -1377,7 +1979,7 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 			break;
 		case '=':
 			*operPtr++ = cc;
-			if ( exprs->mCurrPtr[1] == '=' )
+			if ( lexPeek(exprs, exprs->mCurrPtr + 1) == '=' )
 			{
 				if ( (exprs->mFlags & EXPRS_FLG_NO_LOGICALS) )
 					return EXPR_TERM_BAD_SYNTAX;
@@ -1396,13 +1998,13 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 			if ( (exprs->mFlags & EXPRS_FLG_NO_LOGICALS) )
 				return EXPR_TERM_BAD_SYNTAX;
 			*operPtr++ = cc;
-			if ( exprs->mCurrPtr[1] == '<' )
+			if ( lexPeek(exprs, exprs->mCurrPtr + 1) == '<' )
 			{
 				term->termType = EXPRS_TERM_SHL;
 				*operPtr++ = cc;
 				++exprs->mCurrPtr;
 			}
-			else if ( exprs->mCurrPtr[1] == '=' )
+			else if ( lexPeek(exprs, exprs->mCurrPtr + 1) == '=' )
 			{
 				term->termType = EXPRS_TERM_LE;
 				*operPtr++ = '=';
@@ -1430,13 +2032,13 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 			*operPtr++ = cc;
 			if ( (exprs->mFlags & EXPRS_FLG_NO_LOGICALS) )
 				return badSyntax(exprs, chMask, cc, EXPR_TERM_BAD_SYNTAX);
-			if ( exprs->mCurrPtr[1] == '>' )
+			if ( lexPeek(exprs, exprs->mCurrPtr + 1) == '>' )
 			{
 				term->termType = EXPRS_TERM_SHR;
 				*operPtr++ = cc;
 				++exprs->mCurrPtr;
 			}
-			else if ( exprs->mCurrPtr[1] == '=' )
+			else if ( lexPeek(exprs, exprs->mCurrPtr + 1) == '=' )
 			{
 				term->termType = EXPRS_TERM_GE;
 				*operPtr++ = '=';
@@ -1500,6 +2102,8 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 				if ( (oldPrecedence = exprs->precedencePtr[operTop->termType]) < currPrecedence )
 					break;
 				*term = *operTop;
+				if ( term->termType == EXPRS_TERM_LAND || term->termType == EXPRS_TERM_LOR )
+					patchSkip(exprs, sPtr, skipIdx[operTop - operStack]);
 				if ( exprs->mVerbose )
 				{
 					snprintf(eBuf, sizeof(eBuf), "parseExpression(): Precedence popped from operators[%d] a '%s'(%d) and pushed it to terms[%d]. Precedence: curr=%d, new=%d\n",
@@ -1526,13 +2130,26 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 			}
 			++operUsed;
 			lastTermType = currTermType;
+			if ( saveTerm.termType == EXPRS_TERM_LAND || saveTerm.termType == EXPRS_TERM_LOR )
+			{
+				/* Follow the left operand with a term that skips the right one if the left one decides the answer.
+				 * How far to skip is filled in by patchSkip() when the operator comes back off the operator stack. */
+				skipIdx[operUsed - 1] = sPtr->mTermsPool.mNumUsed;
+				term = pointToNextTerm(exprs, sPtr);
+				if ( !term )
+					return EXPR_TERM_BAD_OUT_OF_MEMORY;
+				memset(term, 0, sizeof(ExprsTerm_t));
+				term->termType = saveTerm.termType == EXPRS_TERM_LAND ? EXPRS_TERM_SKIP_FALSE : EXPRS_TERM_SKIP_TRUE;
+				term->chrPtr = saveTerm.chrPtr;
+				++sPtr->mTermsPool.mNumUsed;
+			}
 		}
 		else
 		{
 			lastTermType = TermIsPlain;
 			++sPtr->mTermsPool.mNumUsed;
 		}
-		if ( *exprs->mCurrPtr )
+		if ( exprs->mCurrPtr < exprs->mEndPtr )
 			++exprs->mCurrPtr;
 	}
 	/* reached end of expression string */
@@ -1544,6 +2161,8 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 		oper = operStack + operUsed;
 		term = pointToNextTerm(exprs, sPtr);
 		*term = *oper;
+		if ( term->termType == EXPRS_TERM_LAND || term->termType == EXPRS_TERM_LOR )
+			patchSkip(exprs, sPtr, skipIdx[operUsed]);
 		if ( exprs->mVerbose )
 		{
 			snprintf(eBuf, sizeof(eBuf), "parseExpression(): Popped '%s'(%d) from operStack[%d] and pushed it to terms[%d]\n",
@@ -1565,53 +2184,70 @@ static ExprsErrs_t parseExpression(ExprsDef_t *exprs, int nest, TermType_t lastT
 	return peRetV;
 }
 
+/* Load dst with the value of a symbol as stored in an external symbol table (or slot) */
+static ExprsErrs_t symValueToTerm(ExprsDef_t *exprs, const char *name, const ExprsSymTerm_t *ans, ExprsTerm_t *dst)
+{
+	char *toPtr, eBuf[512];
+	int strLen;
+
+	switch (ans->termType)
+	{
+	default:
+		snprintf(eBuf, sizeof(eBuf), "lookupSymbol(): Found symbol '%s' with illegal term type %d.\n",
+				 name, ans->termType);
+		showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
+		return EXPR_TERM_BAD_UNSUPPORTED;
+	case EXPRS_SYM_TERM_COMPLEX:
+		dst->user1 = ans->user1;
+		dst->term.s64 = ans->value.s64;
+		dst->flags |= EXPRS_TERM_FLAG_COMPLEX;
+		break;
+	case EXPRS_SYM_TERM_STRING:
+		strLen = strlen(ans->value.string) + 1;
+		if ( !(toPtr = getFromStringPool(exprs, strLen)) )
+			return EXPR_TERM_BAD_OUT_OF_MEMORY;
+		strncpy(toPtr, ans->value.string, strLen);
+		dst->term.string = toPtr - libExprsStringPoolTop(exprs);
+		break;
+	case EXPRS_SYM_TERM_FLOAT:
+		dst->term.f64 = ans->value.f64;
+		break;
+	case EXPRS_SYM_TERM_INTEGER:
+		dst->term.s64 = ans->value.s64;
+		break;
+	}
+	dst->termType = (ExprsTermTypes_t)ans->termType;
+	dst->flags = ans->flags;
+	return EXPR_TERM_GOOD;
+}
+
+/* Private term flag: symbol is bound to a slot that holds no value (see loadSlot()) */
+#define EXPRS_TERM_FLAG_EMPTY_SLOT	(0x1000)
+
 static ExprsErrs_t lookupSymbol(ExprsDef_t *exprs, const ExprsTerm_t *src, ExprsTerm_t *dst)
 {
 	ExprsSymTerm_t ans;
 	ExprsErrs_t err;
-	char *fromPtr, *toPtr, eBuf[512];
-	int strLen;
+	char *fromPtr;
 
-	dst->chrPtr = NULL;
+	if ( (src->flags & EXPRS_TERM_FLAG_EMPTY_SLOT) )
+	{
+		dst->chrPtr = src->chrPtr;
+		dst->flags = 0;
+		dst->user1 = NULL;
+		return EXPR_TERM_BAD_UNDEFINED_SYMBOL;
+	}
+	/* Get the name first since src and dst may be the same term */
+	fromPtr = libExprsStringPoolTop(exprs) + src->term.string;
+	dst->chrPtr = src->chrPtr;
 	dst->flags = 0;
 	dst->term.f64 = 0;
 	dst->user1 = NULL;
 	if ( !exprs->mCallbacks.symGet )
 		return EXPR_TERM_BAD_NO_SYMBOLS;
-	fromPtr = libExprsStringPoolTop(exprs) + src->term.string;
 	err = exprs->mCallbacks.symGet(exprs->mCallbacks.symArg, fromPtr, &ans);
 	if ( !err )
-	{
-		switch (ans.termType)
-		{
-		default:
-			snprintf(eBuf, sizeof(eBuf), "lookupSymbol(): Found symbol '%s' with illegal term type %d.\n",
-					 fromPtr, ans.termType);
-			showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
-			return EXPR_TERM_BAD_UNSUPPORTED;
-		case EXPRS_SYM_TERM_COMPLEX:
-			dst->user1 = ans.user1;
-			dst->term.s64 = ans.value.s64;
-			dst->flags |= EXPRS_TERM_FLAG_COMPLEX;
-			break;
-		case EXPRS_SYM_TERM_STRING:
-			strLen = strlen(ans.value.string) + 1;
-			if ( !(toPtr = getFromStringPool(exprs, strLen)) )
-				return EXPR_TERM_BAD_OUT_OF_MEMORY;
-			strncpy(toPtr, ans.value.string, strLen);
-			dst->term.string = toPtr - libExprsStringPoolTop(exprs);
-			break;
-		case EXPRS_SYM_TERM_FLOAT:
-			dst->term.f64 = ans.value.f64;
-			break;
-		case EXPRS_SYM_TERM_INTEGER:
-			dst->term.s64 = ans.value.s64;
-			break;
-		}
-		dst->termType = (ExprsTermTypes_t)ans.termType;
-		dst->flags = ans.flags;
-		return EXPR_TERM_GOOD;
-	}
+		return symValueToTerm(exprs, fromPtr, &ans, dst);
 	return EXPR_TERM_BAD_UNDEFINED_SYMBOL;
 }
 
@@ -1640,7 +2276,7 @@ static ExprsErrs_t procSymbols(ExprsDef_t *exprs, ExprsTerm_t *aa, ExprsTerm_t *
 static ExprsErrs_t doAdd(ExprsDef_t *exprs, ExprsTerm_t *dst, ExprsTerm_t *aa, ExprsTerm_t *bb)
 {
 	ExprsErrs_t err;
-	int sLen;
+	int sLen, len;
 	char *newStr;
 	char eBuf[512];
 
@@ -1676,7 +2312,8 @@ static ExprsErrs_t doAdd(ExprsDef_t *exprs, ExprsTerm_t *dst, ExprsTerm_t *aa, E
 				err = EXPR_TERM_BAD_OUT_OF_MEMORY;
 				break;
 			}
-			snprintf(newStr, sLen, "%g%s", aa->term.f64, libExprsStringPoolTop(exprs) + bb->term.string);
+			len = fmtFloat(newStr, aa->term.f64);
+			strcpy(newStr + len, libExprsStringPoolTop(exprs) + bb->term.string);
 			dst->termType = EXPRS_TERM_STRING;
 			dst->term.string = newStr - libExprsStringPoolTop(exprs);
 			err = EXPR_TERM_GOOD;
@@ -1706,7 +2343,8 @@ static ExprsErrs_t doAdd(ExprsDef_t *exprs, ExprsTerm_t *dst, ExprsTerm_t *aa, E
 				err = EXPR_TERM_BAD_OUT_OF_MEMORY;
 				break;
 			}
-			snprintf(newStr, sLen, "%ld%s", aa->term.s64, libExprsStringPoolTop(exprs) + bb->term.string);
+			len = fmtInteger(newStr, aa->term.s64);
+			strcpy(newStr + len, libExprsStringPoolTop(exprs) + bb->term.string);
 			dst->termType = EXPRS_TERM_STRING;
 			dst->term.string = newStr - libExprsStringPoolTop(exprs);
 			err = EXPR_TERM_GOOD;
@@ -1716,7 +2354,7 @@ static ExprsErrs_t doAdd(ExprsDef_t *exprs, ExprsTerm_t *dst, ExprsTerm_t *aa, E
 		}
 		break;
 	case EXPRS_TERM_STRING:
-		sLen = strlen(libExprsStringPoolTop(exprs) + aa->term.string);
+		sLen = len = strlen(libExprsStringPoolTop(exprs) + aa->term.string);
 		switch (bb->termType)
 		{
 		case EXPRS_TERM_FLOAT:
@@ -1728,10 +2366,11 @@ static ExprsErrs_t doAdd(ExprsDef_t *exprs, ExprsTerm_t *dst, ExprsTerm_t *aa, E
 				err = EXPR_TERM_BAD_OUT_OF_MEMORY;
 				break;
 			}
+			memcpy(newStr, libExprsStringPoolTop(exprs) + aa->term.string, len);
 			if ( bb->termType == EXPRS_TERM_FLOAT )
-				snprintf(newStr, sLen, "%s%g", libExprsStringPoolTop(exprs) + aa->term.string, bb->term.f64);
+				fmtFloat(newStr + len, bb->term.f64);
 			else
-				snprintf(newStr, sLen, "%s%ld", libExprsStringPoolTop(exprs) + aa->term.string, bb->term.s64);
+				fmtInteger(newStr + len, bb->term.s64);
 			dst->term.string = newStr - libExprsStringPoolTop(exprs);
 			err = EXPR_TERM_GOOD;
 			break;
@@ -1743,9 +2382,8 @@ static ExprsErrs_t doAdd(ExprsDef_t *exprs, ExprsTerm_t *dst, ExprsTerm_t *aa, E
 				err = EXPR_TERM_BAD_OUT_OF_MEMORY;
 				break;
 			}
-			snprintf(newStr, sLen, "%s%s",
-					 libExprsStringPoolTop(exprs) + aa->term.string,
-					 libExprsStringPoolTop(exprs) + bb->term.string);
+			memcpy(newStr, libExprsStringPoolTop(exprs) + aa->term.string, len);
+			strcpy(newStr + len, libExprsStringPoolTop(exprs) + bb->term.string);
 			dst->term.string = newStr - libExprsStringPoolTop(exprs);
 			err = EXPR_TERM_GOOD;
 			break;
@@ -2041,7 +2679,8 @@ static ExprsErrs_t doDiv(ExprsDef_t *exprs, ExprsTerm_t *dst, ExprsTerm_t *aa, E
 			err = EXPR_TERM_GOOD;
 			break;
 		case EXPRS_TERM_INTEGER:
-			dst->term.s64 = aa->term.s64 / bb->term.s64;
+			/* Same as runIntCode() and the JIT: no trap on LONG_MIN/-1 */
+			dst->term.s64 = bb->term.s64 == -1 ? -(unsigned long)aa->term.s64 : aa->term.s64 / bb->term.s64;
 			err = EXPR_TERM_GOOD;
 			break;
 		default:
@@ -2128,7 +2767,7 @@ static ExprsErrs_t doMod(ExprsDef_t *exprs, ExprsTerm_t *dst, ExprsTerm_t *aa, E
 #endif
 			break;
 		case EXPRS_TERM_INTEGER:
-			dst->term.s64 = aa->term.s64 % bb->term.s64;
+			dst->term.s64 = bb->term.s64 == -1 ? 0 : aa->term.s64 % bb->term.s64;
 			err = EXPR_TERM_GOOD;
 			break;
 		default:
@@ -2151,16 +2790,77 @@ static ExprsErrs_t doMod(ExprsDef_t *exprs, ExprsTerm_t *dst, ExprsTerm_t *aa, E
 	}
 }
 
+/* What the compiler learned about each term of a program */
+typedef struct
+{
+	int mSym;						/* index into program's mSyms if term is a symbol, else -1 */
+	int mLvalue;					/* non-zero if the symbol is the target of an assignment */
+} ExprsTermInfo_t;
+
+/* Each distinct symbol name found in a program */
+typedef struct
+{
+	size_t mName;					/* offset into program's mStrings of the name */
+	int mSlot;						/* slot to which it is bound (-1 if not bound) */
+} ExprsSymbol_t;
+
+#define SLOT_NOT_IN_POOL ((size_t)-1)
+
+/* Where computeViaRPN() gets values of symbols bound to slots */
+typedef struct
+{
+	const ExprsTermInfo_t *mInfo;	/* parallel to the terms being computed */
+	const ExprsSymbol_t *mSyms;		/* program's list of symbols */
+	ExprsSymTerm_t *mSlots;			/* caller's array of values */
+	size_t *mPoolStrings;			/* per slot offset into string pool of assigned strings */
+} ExprsSlotRun_t;
+
 typedef struct
 {
 	ExprsDef_t *exprs;
 	ExprsTerm_t results[EXPRS_TERM_ASSIGN+1];
+	int srcIdx[EXPRS_TERM_ASSIGN+1];	/* index of term that pushed each of results[] */
 	ExprsStack_t *sPtr;
-	ExprsTerm_t *term, *aa, *bb;
+	const ExprsTerm_t *term;
+	ExprsTerm_t *aa, *bb;
 	int ii, rTop;
 	char tmpBuf0[32],tmpBuf1[32],tmpBuf2[32];
 } TermParams_t;
 
+static int termSlot(const ExprsSlotRun_t *slotRun, int termIdx)
+{
+	int sym;
+	if ( !slotRun || (sym = slotRun->mInfo[termIdx].mSym) < 0 )
+		return -1;
+	return slotRun->mSyms[sym].mSlot;
+}
+
+/* Load dst (a copy of a symbol term) with the value held in a slot. An empty
+ * slot leaves dst a symbol flagged EXPRS_TERM_FLAG_EMPTY_SLOT so, just as with
+ * lookupSymbol(), it is only reported as undefined if its value gets used. */
+static ExprsErrs_t loadSlot(ExprsDef_t *exprs, const ExprsSlotRun_t *slotRun, int slot, ExprsTerm_t *dst)
+{
+	const ExprsSymTerm_t *value = slotRun->mSlots + slot;
+	const char *name = libExprsStringPoolTop(exprs) + dst->term.string;
+
+	if ( value->termType == EXPRS_SYM_TERM_NULL )
+	{
+		dst->flags |= EXPRS_TERM_FLAG_EMPTY_SLOT;
+		return EXPR_TERM_GOOD;
+	}
+	dst->flags = 0;
+	dst->user1 = NULL;
+	if ( value->termType == EXPRS_SYM_TERM_STRING && slotRun->mPoolStrings[slot] != SLOT_NOT_IN_POOL )
+	{
+		/* Assigned earlier in this run so it is already in the pool (which may have moved since) */
+		dst->termType = EXPRS_TERM_STRING;
+		dst->term.string = slotRun->mPoolStrings[slot];
+		return EXPR_TERM_GOOD;
+	}
+	dst->term.f64 = 0;
+	return symValueToTerm(exprs, name, value, dst);
+}
+
 static ExprsErrs_t prepUnaryTerm(TermParams_t *params, bool toInteger)
 {
 	ExprsErrs_t err;
@@ -2208,6 +2908,10 @@ static ExprsErrs_t prepBinaryTerms(TermParams_t *params, bool toInteger)
 	}
 	if ( toInteger )
 	{
+		ExprsErrs_t err;
+		/* The integer-only operators don't go through doXxx() so resolve any symbols here */
+		if ( (err = procSymbols(params->exprs, params->aa, params->bb)) )
+			return err;
 		if ( params->aa->termType == EXPRS_TERM_FLOAT )
 		{
 			params->aa->termType = EXPRS_TERM_INTEGER;
@@ -2222,32 +2926,32 @@ static ExprsErrs_t prepBinaryTerms(TermParams_t *params, bool toInteger)
 	return EXPR_TERM_GOOD;
 }
 
-static ExprsErrs_t computeViaRPN(ExprsDef_t *exprs, int nest, ExprsTerm_t *returnResult)
+static ExprsErrs_t computeViaRPN(ExprsDef_t *exprs, const ExprsTerm_t *terms, int numTerms, const ExprsSlotRun_t *slotRun, ExprsTerm_t *returnResult)
 {
 	TermParams_t params;
-	ExprsTerm_t * term,*dst;
+	const ExprsTerm_t *term;
+	ExprsTerm_t *dst;
 	ExprsErrs_t err;
 	ExprsTermTypes_t tType;
 	ExprsSymTerm_t ans;
 	ExprsStack_t *sPtr = &exprs->mStack;
-	int ii;
+	int ii, slot;
 	char eBuf[512];
 
 	if ( exprs->mVerbose )
 	{
-		snprintf(eBuf, sizeof(eBuf), "Into computeViaRPN(): nest=%d. Terms=%d\n",
-				 nest, sPtr->mTermsPool.mNumUsed);
+		snprintf(eBuf, sizeof(eBuf), "Into computeViaRPN(): Terms=%d\n", numTerms);
 		showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
 	}
 	returnResult->termType = EXPRS_TERM_NULL;
-	if ( !sPtr->mTermsPool.mNumUsed )
+	if ( !numTerms )
 		return EXPR_TERM_BAD_TOO_FEW_TERMS;
 	params.exprs = exprs;
 	params.sPtr = sPtr;
 	params.rTop = -1;
-	for ( ii = 0; ii < sPtr->mTermsPool.mNumUsed; ++ii )
+	for ( ii = 0; ii < numTerms; ++ii )
 	{
-		params.term = term = libExprsTermPoolTop(exprs, sPtr) + ii;
+		params.term = term = terms + ii;
 		params.ii = ii;
 		returnResult->chrPtr = term->chrPtr;
 		tType =  term->termType;
@@ -2267,6 +2971,26 @@ static ExprsErrs_t computeViaRPN(ExprsDef_t *exprs, int nest, ExprsTerm_t *retur
 			continue;
 		case EXPRS_TERM_SYMBOL_COMPLEX:
 		case EXPRS_TERM_SYMBOL:
+			if ( (slot = termSlot(slotRun, ii)) >= 0 )
+			{
+				if ( params.rTop >= n_elts(params.results) - 1 )
+					return EXPR_TERM_BAD_TOO_MANY_TERMS;
+				if ( exprs->mVerbose )
+				{
+					snprintf(eBuf, sizeof(eBuf), "computeViaRPN(): Item %d: %s (slot %d)\n",
+							 ii,
+							 showTermType(exprs, sPtr, term, params.tmpBuf0, sizeof(params.tmpBuf0) - 1),
+							 slot);
+					showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
+				}
+				dst = params.results + ++params.rTop;
+				*dst = *term;
+				params.srcIdx[params.rTop] = ii;
+				/* Fetch the value now unless it is to be assigned to */
+				if ( !slotRun->mInfo[ii].mLvalue && (err = loadSlot(exprs, slotRun, slot, dst)) )
+					return err;
+				continue;
+			}
 			if ( !exprs->mCallbacks.symGet )
 			{
 				snprintf(eBuf, sizeof(eBuf), "computeViaRPN(): No symbol table established. Cannot handle symbols at or near %s.\n", term->chrPtr);
@@ -2288,6 +3012,7 @@ static ExprsErrs_t computeViaRPN(ExprsDef_t *exprs, int nest, ExprsTerm_t *retur
 				showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
 			}
 			params.results[++params.rTop] = *term;
+			params.srcIdx[params.rTop] = ii;
 			continue;
 		case EXPRS_TERM_POS:   /* + */
 			if ( (err = prepUnaryTerm(&params, false)) )
@@ -2601,12 +3326,35 @@ static ExprsErrs_t computeViaRPN(ExprsDef_t *exprs, int nest, ExprsTerm_t *retur
 				return EXPR_TERM_BAD_SYNTAX;
 			params.aa->term.s64 = (params.aa->term.s64 || params.bb->term.s64) ? 1 : 0;
 			continue;
+		case EXPRS_TERM_SKIP_FALSE:	/* left side of && */
+		case EXPRS_TERM_SKIP_TRUE:	/* left side of || */
+			if ( (err = prepUnaryTerm(&params, true)) )
+				return err;
+			if ( term->term.link < 1 || ii + term->term.link >= numTerms )
+				return EXPR_TERM_BAD_SYNTAX;
+			if (    params.aa->termType == EXPRS_TERM_INTEGER
+				 && (params.aa->term.s64 != 0) == (tType == EXPRS_TERM_SKIP_TRUE) )
+			{
+				/* The left side decides the answer so skip the right side and its && or || */
+				params.aa->term.s64 = (tType == EXPRS_TERM_SKIP_TRUE) ? 1 : 0;
+				if ( exprs->mVerbose )
+				{
+					snprintf(eBuf, sizeof(eBuf), "computeViaRPN(): Item %d: %s. Skipped to item %d\n",
+							 ii,
+							 showTermType(exprs, sPtr, term, params.tmpBuf0, sizeof(params.tmpBuf0) - 1),
+							 ii + term->term.link + 1);
+					showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
+				}
+				ii += term->term.link;
+			}
+			continue;
 		case EXPRS_TERM_ASSIGN: /* = */
 			if ( (err = prepBinaryTerms(&params, false)) )
 				return err;
 			/* bb is the value to assign to it */
 			/* aa is the symbol to assign to */
-			if ( !exprs->mCallbacks.symGet )
+			slot = params.aa->termType == EXPRS_TERM_SYMBOL ? termSlot(slotRun, params.srcIdx[params.rTop]) : -1;
+			if ( slot < 0 && !exprs->mCallbacks.symGet )
 			{
 				snprintf(eBuf, sizeof(eBuf), "computeViaRPN(): No symbol table. Assignment not possible: at or near %s\n", params.aa->chrPtr);
 				showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
@@ -2632,8 +3380,21 @@ static ExprsErrs_t computeViaRPN(ExprsDef_t *exprs, int nest, ExprsTerm_t *retur
 				return EXPR_TERM_BAD_LVALUE;
 			}
 			ans.termType = (ExprsSymTermTypes_t)params.bb->termType;
-			ans.value.f64 = params.bb->term.f64;
-			err = exprs->mCallbacks.symSet(exprs->mCallbacks.symArg, libExprsStringPoolTop(exprs) + params.aa->term.string, &ans);
+			if ( params.bb->termType == EXPRS_TERM_STRING )
+				ans.value.string = libExprsStringPoolTop(exprs) + params.bb->term.string;
+			else
+				ans.value.f64 = params.bb->term.f64;
+			if ( slot >= 0 )
+			{
+				ans.flags = 0;
+				ans.user1 = NULL;
+				ans.user2 = NULL;
+				slotRun->mSlots[slot] = ans;
+				slotRun->mPoolStrings[slot] = params.bb->termType == EXPRS_TERM_STRING ? params.bb->term.string : SLOT_NOT_IN_POOL;
+				err = EXPR_TERM_GOOD;
+			}
+			else
+				err = exprs->mCallbacks.symSet(exprs->mCallbacks.symArg, libExprsStringPoolTop(exprs) + params.aa->term.string, &ans);
 			if ( err )
 			{
 				snprintf(eBuf, sizeof(eBuf), "computeViaRPN(): Failed ('%s') to assign symbol '%s' at or near %s\n",
@@ -2661,8 +3422,8 @@ static ExprsErrs_t computeViaRPN(ExprsDef_t *exprs, int nest, ExprsTerm_t *retur
 	*returnResult = params.results[0];
 	if ( exprs->mVerbose )
 	{
-		snprintf(eBuf, sizeof(eBuf), "computeViaRPN(): Finish. nest=%d. Terms=%d. rTop=%d, %s\n",
-				 nest, sPtr->mTermsPool.mNumUsed, params.rTop,
+		snprintf(eBuf, sizeof(eBuf), "computeViaRPN(): Finish. Terms=%d. rTop=%d, %s\n",
+				 numTerms, params.rTop,
 				 showTermType(exprs, sPtr, returnResult, params.tmpBuf0, sizeof(params.tmpBuf0) - 1));
 		showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
 	}
@@ -2703,6 +3464,7 @@ static const ErrMsgs_t Errs[] =
 	{ EXPR_TERM_BAD_PARAMETER, "Invalid parameter value" },
 	{ EXPR_TERM_BAD_NOLOCK, "Failed to lock pthread mutex" },
 	{ EXPR_TERM_BAD_NOUNLOCK, "Failed to unlock pthread mutex" },
+	{ EXPR_TERM_BAD_CYCLE, "Symbol depends on itself" },
 };
 #endif
 
@@ -2790,15 +3552,285 @@ static void textToPrint(char *eBuf, size_t eBufSize, const char *header, const c
 	snprintf(eBuf + len, eBufSize - len, "%s", trailer);
 }
 
-ExprsErrs_t libExprsEval(ExprsDef_t *exprs, const char *text, ExprsTerm_t *returnTerm, int alreadyLocked)
+/** runStatement - compute the result of one statement that has
+ *  already been parsed into RPN.
+ *
+ *  At entry:
+ *  @param exprs - pointer to ExprsDef_t returned from
+ *  			 libExprsInit()
+ *  @param terms - pointer to first RPN term of the statement
+ *  @param numTerms - number of terms in the statement
+ *  @param slotRun - pointer to slots holding values of symbols
+ *  			   (NULL if none)
+ *  @param returnTerm - pointer to place to deposit result
+ *
+ *  At exit:
+ *  @return - error code (0 == no error)
+ **/
+static ExprsErrs_t runStatement(ExprsDef_t *exprs, const ExprsTerm_t *terms, int numTerms, const ExprsSlotRun_t *slotRun, ExprsTerm_t *returnTerm)
 {
-	ExprsErrs_t peErr, err = EXPR_TERM_BAD_SYNTAX, err2 = EXPR_TERM_GOOD;
-	char eBuf[512], saveOpen, saveClose;
+	ExprsErrs_t err;
+	char eBuf[512];
 	int len;
+
+	if ( exprs->mVerbose )
+	{
+		showMsg(exprs, EXPRS_SEVERITY_INFO, "Stacks before computeViaRPN");
+		dumpTerms(exprs, terms, numTerms, NULL, 0);
+	}
+	err = computeViaRPN(exprs, terms, numTerms, slotRun, returnTerm);
+	if ( err <= EXPR_TERM_END )
+	{
+		if ( returnTerm->termType == EXPRS_TERM_SYMBOL )
+		{
+			ExprsTerm_t sym;
+			err = lookupSymbol(exprs, returnTerm, &sym);
+			if ( err )
+			{
+				len = snprintf(eBuf, sizeof(eBuf), "libExprsEval(): Undefined symbol: %s\n",
+							   libExprsStringPoolTop(exprs) + returnTerm->term.string);
+				if ( returnTerm->chrPtr )
+					snprintf(eBuf + len, sizeof(eBuf) - len, "At or near: %s\n", returnTerm->chrPtr);
+				showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
+			}
+			else
+			{
+				returnTerm->chrPtr = sym.chrPtr;
+				returnTerm->termType = sym.termType;
+				returnTerm->term.u64 = sym.term.u64;
+			}
+		}
+		else if ( exprs->mVerbose )
+		{
+			showMsg(exprs, EXPRS_SEVERITY_INFO, "Stacks after computeViaRPN");
+			dumpTerms(exprs, terms, numTerms, NULL, 0);
+			snprintf(eBuf, sizeof(eBuf), "The resulting term after computing RPN expression:\n");
+			showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
+			switch (returnTerm->termType)
+			{
+			case EXPRS_TERM_NULL:
+			case EXPRS_TERM_SYMBOL: /* Symbol */
+			case EXPRS_TERM_FUNCTION: /* Function call */
+			case EXPRS_TERM_STRING: /* Text string */
+				snprintf(eBuf, sizeof(eBuf), "Type %d: flags: 0x%X, value: '%s'\n",
+						 returnTerm->termType,
+						 returnTerm->flags,
+						 libExprsStringPoolTop(exprs) + returnTerm->term.string);
+				break;
+			case EXPRS_TERM_FLOAT:  /* 64 bit floating point number */
+				snprintf(eBuf, sizeof(eBuf), "Type %d: flags: 0x%X, value: '%g'\n",
+						 returnTerm->termType,
+						 returnTerm->flags,
+						 returnTerm->term.f64);
+				break;
+			case EXPRS_TERM_INTEGER:    /* 64 bit integer number */
+				snprintf(eBuf, sizeof(eBuf), "Type %d: flags: 0x%X, value: '%ld'\n",
+						 returnTerm->termType,
+						 returnTerm->flags,
+						 returnTerm->term.s64);
+				break;
+			default:
+				snprintf(eBuf, sizeof(eBuf), "Type %d: flags: 0x%X, value: 0x%lX (undefined)\n",
+						 returnTerm->termType,
+						 returnTerm->flags,
+						 returnTerm->term.s64);
+				break;
+			}
+			showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
+		}
+	}
+	else
+	{
+		len = snprintf(eBuf, sizeof(eBuf), "computeViaRPN() returned %d: %s\n", err, libExprsGetErrorStr(err));
+		if ( returnTerm->chrPtr )
+			snprintf(eBuf + len, sizeof(eBuf) - len, "At or near: %s\n", returnTerm->chrPtr);
+		showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
+		dumpTerms(exprs, terms, numTerms, NULL, 0);
+	}
+	return err;
+}
+
+static void quietMsgOut(void *msgArg, ExprsMsgSeverity_t severity, const char *msg)
+{
+}
+
+static bool isFoldable(const ExprsTerm_t *term)
+{
+	/* Registers and length qualified numbers are not plain constants */
+	return !term->flags
+		&& (term->termType == EXPRS_TERM_INTEGER || term->termType == EXPRS_TERM_FLOAT || term->termType == EXPRS_TERM_STRING);
+}
+
+/** foldConstants - replace every operator whose operands are all
+ *  constants with the constant it computes.
+ *
+ *  At entry:
+ *  @param exprs - pointer to ExprsDef_t with a statement freshly
+ *  			 parsed into mStack.
+ *
+ *  At exit:
+ *  @return nothing. mStack may hold fewer terms.
+ *
+ *  @note The operators are computed with computeViaRPN() so the
+ *  	  answers are identical to what running them would
+ *  	  produce. Any that fail (divide by 0, bad types, etc.)
+ *  	  are left alone so the error is reported at run time
+ *  	  just as before. Strings made by folding go into the
+ *  	  string pool.
+ **/
+static void foldConstants(ExprsDef_t *exprs)
+{
+	ExprsTerm_t *terms, *outTerms, tmp[3], result;
+	ExprsErrs_t err;
+	void (*saveMsgOut)(void *msgArg, ExprsMsgSeverity_t severity, const char *msg);
+	unsigned int saveVerbose;
+	int ii, numTerms, numOut = 0, depth = 0, numOps = 0, nOpers, numSkips = 0;
+	bool isConst[EXPRS_TERM_ASSIGN+1];
+	int skipOut[n_elts(isConst)], skipTo[n_elts(isConst)];	/* Skip terms output whose && or || has yet to be reached */
+	long lVal;
+	char eBuf[128];
+
+	numTerms = exprs->mStack.mTermsPool.mNumUsed;
+	if ( numTerms < 2 )
+		return;
+	outTerms = (ExprsTerm_t *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, numTerms * sizeof(ExprsTerm_t));
+	if ( !outTerms )
+		return;
+	/* Any complaints about constant expressions will be made again when they are run */
+	saveMsgOut = exprs->mCallbacks.msgOut;
+	saveVerbose = exprs->mVerbose;
+	exprs->mCallbacks.msgOut = quietMsgOut;
+	exprs->mVerbose = 0;
+	terms = libExprsTermPoolTop(exprs, &exprs->mStack);
+	for ( ii = 0; ii < numTerms; ++ii )
+	{
+		/* Terms may have been dropped so re-aim any skip whose && or || is next */
+		while ( numSkips && skipTo[numSkips - 1] == ii )
+		{
+			--numSkips;
+			outTerms[skipOut[numSkips]].term.link = numOut - skipOut[numSkips];
+		}
+		nOpers = 0;
+		switch (terms[ii].termType)
+		{
+		case EXPRS_TERM_NULL:
+			continue;
+		case EXPRS_TERM_SYMBOL:
+		case EXPRS_TERM_SYMBOL_COMPLEX:
+		case EXPRS_TERM_FUNCTION:
+		case EXPRS_TERM_STRING:
+		case EXPRS_TERM_FLOAT:
+		case EXPRS_TERM_INTEGER:
+			if ( depth >= n_elts(isConst) )
+				break;
+			isConst[depth++] = isFoldable(terms + ii);
+			outTerms[numOut++] = terms[ii];
+			continue;
+		case EXPRS_TERM_SKIP_FALSE:
+		case EXPRS_TERM_SKIP_TRUE:
+			if ( !depth || terms[ii].term.link < 1 || ii + terms[ii].term.link >= numTerms )
+				break;
+			if ( !isConst[depth - 1] )
+			{
+				skipOut[numSkips] = numOut;
+				skipTo[numSkips++] = ii + terms[ii].term.link;
+				outTerms[numOut++] = terms[ii];
+				continue;
+			}
+			/* A constant left side either decides the answer or makes the skip pointless */
+			if ( outTerms[numOut - 1].termType == EXPRS_TERM_STRING )
+				continue;
+			if ( outTerms[numOut - 1].termType == EXPRS_TERM_FLOAT )
+				lVal = outTerms[numOut - 1].term.f64;
+			else
+				lVal = outTerms[numOut - 1].term.s64;
+			if ( (lVal != 0) == (terms[ii].termType == EXPRS_TERM_SKIP_TRUE) )
+			{
+				outTerms[numOut - 1].termType = EXPRS_TERM_INTEGER;
+				outTerms[numOut - 1].term.s64 = (terms[ii].termType == EXPRS_TERM_SKIP_TRUE) ? 1 : 0;
+				ii += terms[ii].term.link;
+				++numOps;
+			}
+			continue;
+		case EXPRS_TERM_POS:
+		case EXPRS_TERM_NEG:
+		case EXPRS_TERM_COM:
+		case EXPRS_TERM_NOT:
+		case EXPRS_TERM_HIGH_BYTE:
+		case EXPRS_TERM_LOW_BYTE:
+		case EXPRS_TERM_SWAP:
+			nOpers = 1;
+			break;
+		case EXPRS_TERM_POW:
+		case EXPRS_TERM_MUL:
+		case EXPRS_TERM_DIV:
+		case EXPRS_TERM_MOD:
+		case EXPRS_TERM_ADD:
+		case EXPRS_TERM_SUB:
+		case EXPRS_TERM_SHL:
+		case EXPRS_TERM_SHR:
+		case EXPRS_TERM_GT:
+		case EXPRS_TERM_GE:
+		case EXPRS_TERM_LT:
+		case EXPRS_TERM_LE:
+		case EXPRS_TERM_EQ:
+		case EXPRS_TERM_NE:
+		case EXPRS_TERM_AND:
+		case EXPRS_TERM_XOR:
+		case EXPRS_TERM_OR:
+		case EXPRS_TERM_LAND:
+		case EXPRS_TERM_LOR:
+		case EXPRS_TERM_ASSIGN:
+			nOpers = 2;
+			break;
+		}
+		if ( !nOpers || depth < nOpers )
+			break;				/* Malformed. Leave it for the run to report */
+		depth -= nOpers;
+		if ( terms[ii].termType != EXPRS_TERM_ASSIGN && isConst[depth] && (nOpers == 1 || isConst[depth + 1]) )
+		{
+			/* The operands of a constant are always the last terms output */
+			memcpy(tmp, outTerms + numOut - nOpers, nOpers * sizeof(ExprsTerm_t));
+			tmp[nOpers] = terms[ii];
+			err = computeViaRPN(exprs, tmp, nOpers + 1, NULL, &result);
+			if ( err == EXPR_TERM_GOOD && isFoldable(&result) )
+			{
+				result.chrPtr = tmp[0].chrPtr;
+				numOut -= nOpers;
+				outTerms[numOut++] = result;
+				isConst[depth++] = true;
+				++numOps;
+				continue;
+			}
+		}
+		outTerms[numOut++] = terms[ii];
+		isConst[depth++] = false;
+	}
+	exprs->mCallbacks.msgOut = saveMsgOut;
+	exprs->mVerbose = saveVerbose;
+	if ( ii >= numTerms && depth == 1 && numOut < numTerms )
+	{
+		memcpy(terms, outTerms, numOut * sizeof(ExprsTerm_t));
+		exprs->mStack.mTermsPool.mNumUsed = numOut;
+		if ( exprs->mVerbose )
+		{
+			snprintf(eBuf, sizeof(eBuf), "foldConstants(): Folded %d operator%s. Terms %d -> %d\n",
+					 numOps, numOps == 1 ? "" : "s", numTerms, numOut);
+			showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
+		}
+	}
+	exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, outTerms);
+}
+
+static int evalCached(ExprsDef_t *exprs, const char *text, size_t textLen, ExprsTerm_t *returnTerm, ExprsErrs_t *errP);
+
+/* libExprsEval() and libExprsEvalN() of the len bytes at text. They are lexed where they are */
+static ExprsErrs_t evalSpan(ExprsDef_t *exprs, const char *text, size_t len, ExprsTerm_t *returnTerm, int alreadyLocked)
+{
+	ExprsErrs_t peErr, err = EXPR_TERM_BAD_SYNTAX, err2 = EXPR_TERM_GOOD;
+	char eBuf[512], noLf[128 + 64], saveOpen, saveClose;
 	const char *ePtr;
 
-	if ( !exprs || !returnTerm || !text )
-		return EXPR_TERM_BAD_PARAMETER;
 	if ( !alreadyLocked && (err2 = libExprsLock(exprs)) )
 		return err2;
 	saveOpen = exprs->mOpenDelimiter;
@@ -2807,100 +3839,33 @@ ExprsErrs_t libExprsEval(ExprsDef_t *exprs, const char *text, ExprsTerm_t *retur
 	returnTerm->term.s64 = 0;
 	returnTerm->chrPtr = NULL;
 	setup(exprs);
-	len = strlen(text);
 	ePtr = text + len;
 	exprs->mLineHead = exprs->mCurrPtr = text;
-	while ( exprs->mCurrPtr < ePtr && *exprs->mCurrPtr )
+	exprs->mEndPtr = ePtr;
+	/* The cache only gets in the way of seeing what the parser does */
+	if ( exprs->mProgCache && !exprs->mVerbose && evalCached(exprs, text, len, returnTerm, &err) )
+		ePtr = text;						/* Already run so skip the parse */
+	else
+		reset(exprs, true);                 /* Nothing is kept from a previous call */
+	while ( exprs->mCurrPtr < ePtr )
 	{
 		reset(exprs, false);                /* Clear any existing stacks (keep string pool) */
 		peErr = parseExpression(exprs, 0, true);
 		err = peErr;
 		if ( err <= EXPR_TERM_END )
 		{
-			if ( exprs->mVerbose )
-			{
-				showMsg(exprs, EXPRS_SEVERITY_INFO, "Stacks before computeViaRPN");
-				dumpStack(exprs, NULL, 0);
-			}
-			err = computeViaRPN(exprs, 0, returnTerm);
-			if ( err <= EXPR_TERM_END )
-			{
-				if ( returnTerm->termType == EXPRS_TERM_SYMBOL )
-				{
-					ExprsTerm_t sym;
-					err = lookupSymbol(exprs, returnTerm, &sym);
-					if ( err )
-					{
-						len = snprintf(eBuf, sizeof(eBuf), "libExprsEval(): Undefined symbol: %s\n",
-									   libExprsStringPoolTop(exprs) + returnTerm->term.string);
-						if ( returnTerm->chrPtr )
-							snprintf(eBuf + len, sizeof(eBuf) - len, "At or near: %s\n", returnTerm->chrPtr);
-						showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
-					}
-					else
-					{
-						returnTerm->chrPtr = sym.chrPtr;
-						returnTerm->termType = sym.termType;
-						returnTerm->term.u64 = sym.term.u64;
-					}
-				}
-				else if ( exprs->mVerbose )
-				{
-					showMsg(exprs, EXPRS_SEVERITY_INFO, "Stacks after computeViaRPN");
-					dumpStack(exprs, NULL, 0);
-					snprintf(eBuf, sizeof(eBuf), "The resulting term after computing RPN expression:\n");
-					showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
-					switch (returnTerm->termType)
-					{
-					case EXPRS_TERM_NULL:
-					case EXPRS_TERM_SYMBOL: /* Symbol */
-					case EXPRS_TERM_FUNCTION: /* Function call */
-					case EXPRS_TERM_STRING: /* Text string */
-						snprintf(eBuf, sizeof(eBuf), "Type %d: flags: 0x%X, value: '%s'\n",
-								 returnTerm->termType,
-								 returnTerm->flags,
-								 libExprsStringPoolTop(exprs) + returnTerm->term.string);
-						break;
-					case EXPRS_TERM_FLOAT:  /* 64 bit floating point number */
-						snprintf(eBuf, sizeof(eBuf), "Type %d: flags: 0x%X, value: '%g'\n",
-								 returnTerm->termType,
-								 returnTerm->flags,
-								 returnTerm->term.f64);
-						break;
-					case EXPRS_TERM_INTEGER:    /* 64 bit integer number */
-						snprintf(eBuf, sizeof(eBuf), "Type %d: flags: 0x%X, value: '%ld'\n",
-								 returnTerm->termType,
-								 returnTerm->flags,
-								 returnTerm->term.s64);
-						break;
-					default:
-						snprintf(eBuf, sizeof(eBuf), "Type %d: flags: 0x%X, value: 0x%lX (undefined)\n",
-								 returnTerm->termType,
-								 returnTerm->flags,
-								 returnTerm->term.s64);
-						break;
-					}
-					showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
-				}
-			}
-			else
-			{
-				len = snprintf(eBuf, sizeof(eBuf), "computeViaRPN() returned %d: %s\n", err, libExprsGetErrorStr(err));
-				if ( returnTerm->chrPtr )
-					snprintf(eBuf + len, sizeof(eBuf) - len, "At or near: %s\n", returnTerm->chrPtr);
-				showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
-				dumpStack(exprs, NULL, 0);
-			}
+			err = runStatement(exprs, libExprsTermPoolTop(exprs, &exprs->mStack), exprs->mStack.mTermsPool.mNumUsed, NULL, returnTerm);
 			if ( (exprs->mFlags & EXPRS_FLG_WS_DELIMIT) && peErr == EXPR_TERM_END )
 			{
 				if ( exprs->mVerbose )
 				{
-					textToPrint(eBuf, sizeof(eBuf), "Ending text: '", "'\n", exprs->mCurrPtr);
+					removeCrLf(noLf, sizeof(noLf), exprs->mCurrPtr, exprs->mEndPtr);
+					textToPrint(eBuf, sizeof(eBuf), "Ending text: '", "'\n", noLf);
 					showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
 				}
 				break;
 			}
-			if ( *exprs->mCurrPtr )
+			if ( exprs->mCurrPtr < ePtr )
 				++exprs->mCurrPtr;
 		}
 		else
@@ -2926,24 +3891,40 @@ ExprsErrs_t libExprsEval(ExprsDef_t *exprs, const char *text, ExprsTerm_t *retur
 	return err ? err : err2;
 }
 
-ExprsErrs_t libExprsParseToRPN(ExprsDef_t *exprs, const char *text, int alreadyLocked)
+ExprsErrs_t libExprsEval(ExprsDef_t *exprs, const char *text, ExprsTerm_t *returnTerm, int alreadyLocked)
+{
+	if ( !exprs || !returnTerm || !text )
+		return EXPR_TERM_BAD_PARAMETER;
+	return evalSpan(exprs, text, strlen(text), returnTerm, alreadyLocked);
+}
+
+ExprsErrs_t libExprsEvalN(ExprsDef_t *exprs, const char *text, size_t len, ExprsTerm_t *returnTerm, int alreadyLocked)
+{
+	if ( !exprs || !returnTerm || (!text && len) )
+		return EXPR_TERM_BAD_PARAMETER;
+	return evalSpan(exprs, text ? text : "", len, returnTerm, alreadyLocked);
+}
+
+/* libExprsParseToRPN() and libExprsParseToRPNN() of the len bytes at text */
+static ExprsErrs_t parseSpan(ExprsDef_t *exprs, const char *text, size_t len, int alreadyLocked)
 {
 	ExprsErrs_t peErr, err, err2 = EXPR_TERM_GOOD;
 	char eBuf[512], saveOpen, saveClose;
 
-	if ( !exprs || !text )
-		return EXPR_TERM_BAD_PARAMETER;
 	if ( !alreadyLocked && (err2 = libExprsLock(exprs)) )
 		return err2;
 	saveOpen = exprs->mOpenDelimiter;
 	saveClose = exprs->mCloseDelimiter;
 	setup(exprs);
 	exprs->mLineHead = exprs->mCurrPtr = text;
+	exprs->mEndPtr = text + len;
 	reset(exprs, true);                 /* Clear any existing stacks and string pool */
 	peErr = parseExpression(exprs, 0, TermIsUnary);
 	err = peErr;
 	if ( err <= EXPR_TERM_END )
 	{
+		if ( (exprs->mFlags & EXPRS_FLG_FOLD_CONSTANTS) )
+			foldConstants(exprs);
 		if ( exprs->mVerbose )
 		{
 			showMsg(exprs, EXPRS_SEVERITY_INFO, "Stacks after libExprsParseToRPN()");
@@ -2952,7 +3933,7 @@ ExprsErrs_t libExprsParseToRPN(ExprsDef_t *exprs, const char *text, int alreadyL
 		if ( exprs->mVerbose )
 		{
 			char noLf[128 + 64];
-			removeCrLf(noLf, sizeof(noLf), exprs->mCurrPtr);
+			removeCrLf(noLf, sizeof(noLf), exprs->mCurrPtr, exprs->mEndPtr);
 			textToPrint(eBuf, sizeof(eBuf), "Ending text: '", "'\n", noLf);
 			showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
 		}
@@ -2976,6 +3957,20 @@ ExprsErrs_t libExprsParseToRPN(ExprsDef_t *exprs, const char *text, int alreadyL
 	return err ? err : err2;
 }
 
+ExprsErrs_t libExprsParseToRPN(ExprsDef_t *exprs, const char *text, int alreadyLocked)
+{
+	if ( !exprs || !text )
+		return EXPR_TERM_BAD_PARAMETER;
+	return parseSpan(exprs, text, strlen(text), alreadyLocked);
+}
+
+ExprsErrs_t libExprsParseToRPNN(ExprsDef_t *exprs, const char *text, size_t len, int alreadyLocked)
+{
+	if ( !exprs || (!text && len) )
+		return EXPR_TERM_BAD_PARAMETER;
+	return parseSpan(exprs, text ? text : "", len, alreadyLocked);
+}
+
 static ExprsErrs_t walkStack(ExprsDef_t *exprs, ExprsErrs_t(*walkCallback)(ExprsDef_t *exprs, const ExprsTerm_t *term))
 {
 	ExprsTerm_t *term;
@@ -3000,13 +3995,3730 @@ ExprsErrs_t libExprsWalkParsedStack(ExprsDef_t *exprs, ExprsErrs_t(*walkCallback
 	return walkStack(exprs, walkCallback);
 }
 
-static void lclMsgOut(void *msgArg, ExprsMsgSeverity_t severity, const char *msg)
+/* A compiled statement is just a slice of the program's terms */
+typedef struct
 {
-	static const char *Severities[] = { "INFO", "WARN", "ERROR", "FATAL" };
-	fprintf(severity > EXPRS_SEVERITY_INFO ? stderr : stdout, "%s-libExprs(): %s", Severities[severity], msg);
-}
+	int mFirstTerm;					/* index into mTerms of first term of statement */
+	int mNumTerms;					/* number of terms in statement */
+	size_t mEndOffset;				/* offset into mText where parsing of the statement stopped */
+	int mIntOnly;					/* non-zero if statement uses nothing but integers */
+	int mCode;						/* index into mCode of statement's integer code (-1 if none) */
+	int mCodeEnd;					/* index into mCode of statement's INT_OP_END */
+	int mJit;						/* offset into mJitCode of statement's native code (-1 if none) */
+	int mJitSlots;					/* non-zero if the native code reads or writes slots */
+} ExprsStatement_t;
 
-static void* lclMalloc(void *memArg, size_t size)
+/* Operations of the integer code integer only statements are lowered to.
+ * The operators have to be in the same order as EXPRS_TERM_NEG..EXPRS_TERM_LOR. */
+typedef enum
+{
+	INT_OP_PUSH,					/* push arg.s64 */
+	INT_OP_LOAD,					/* push value of symbol arg.sym */
+	INT_OP_STORE,					/* assign top of stack to symbol arg.sym */
+	INT_OP_END,						/* done. arg.chrPtr is where the result came from */
+	INT_OP_SKIP_FALSE,				/* if top of stack is 0 go to op arg.target */
+	INT_OP_SKIP_TRUE,				/* if top of stack isn't 0 make it 1 and go to op arg.target */
+	INT_OP_NEG,
+	INT_OP_POS,
+	INT_OP_COM,
+	INT_OP_NOT,
+	INT_OP_LOW_BYTE,
+	INT_OP_HIGH_BYTE,
+	INT_OP_SWAP,
+	INT_OP_POW,
+	INT_OP_MUL,
+	INT_OP_DIV,
+	INT_OP_MOD,
+	INT_OP_ADD,
+	INT_OP_SUB,
+	INT_OP_SHL,
+	INT_OP_SHR,
+	INT_OP_GT,
+	INT_OP_GE,
+	INT_OP_LT,
+	INT_OP_LE,
+	INT_OP_EQ,
+	INT_OP_NE,
+	INT_OP_AND,
+	INT_OP_XOR,
+	INT_OP_OR,
+	INT_OP_LAND,
+	INT_OP_LOR,
+	INT_OP_MAX
+} ExprsIntOps_t;
+
+/* GCC's labels as values let each operation jump straight to the next one's handler */
+#if defined(__GNUC__)
+#define EXPRS_THREADED_CODE 1
+#else
+#define EXPRS_THREADED_CODE 0
+#endif
+
+typedef struct
+{
+#if EXPRS_THREADED_CODE
+	const void *mHandler;			/* address of label in runIntCode() handling mOp */
+#endif
+	ExprsIntOps_t mOp;
+	union
+	{
+		int64_t s64;
+		int sym;					/* index into mSyms */
+		int target;					/* index into mCode */
+		const char *chrPtr;
+	} arg;
+} ExprsIntOp_t;
+
+struct ExprsProgram_t
+{
+	void (*memFree)(void *memArg, void *memPtr);	/* callback used to free this program */
+	void *memArg;					/* argument to pass to memFree */
+	unsigned long mFlags;			/* flags in effect when compiled */
+	int mRadix;						/* radix in effect when compiled */
+	int mNumStmts;					/* number of ';' separated statements */
+	int mNumTerms;					/* total number of terms in all statements */
+	int mNumSyms;					/* number of distinct symbol names */
+	size_t mStringsSize;			/* number of bytes in mStrings */
+	ExprsStatement_t *mStmts;		/* list of statements */
+	ExprsTerm_t *mTerms;			/* RPN terms of all statements */
+	ExprsTermInfo_t *mInfo;			/* per term symbol info (parallel to mTerms) */
+	ExprsSymbol_t *mSyms;			/* list of distinct symbols */
+	ExprsIntOp_t *mCode;			/* integer code of all integer only statements */
+	unsigned char *mJitCode;		/* mmap()'ed native code of integer only statements (NULL if none) */
+	size_t mJitSize;				/* number of bytes mapped at mJitCode */
+	char *mStrings;					/* copy of the string pool as it was after parsing */
+	char *mText;					/* copy of the source text */
+};
+
+static void* growList(ExprsDef_t *exprs, void *list, size_t entrySize, int numUsed, int *numAvailP, int numNeeded)
+{
+	void *newList;
+	int newAvail;
+
+	if ( numUsed + numNeeded <= *numAvailP )
+		return list;
+	newAvail = *numAvailP ? *numAvailP * 2 : 16;
+	while ( newAvail < numUsed + numNeeded )
+		newAvail *= 2;
+	newList = exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, newAvail * entrySize);
+	if ( !newList )
+		return NULL;
+	if ( numUsed )
+		memcpy(newList, list, numUsed * entrySize);
+	if ( list )
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, list);
+	*numAvailP = newAvail;
+	return newList;
+}
+
+/** findSymbols - fill in a program's list of distinct symbol
+ *  names and note which terms refer to which symbol and which
+ *  of those are the target of an assignment. Also note which
+ *  statements are integer only.
+ *
+ *  At entry:
+ *  @param exprs - pointer to ExprsDef_t used to compile
+ *  @param prog - pointer to program with mTerms, mStmts and
+ *  			mStrings filled in and room for mInfo and mSyms
+ *
+ *  At exit:
+ *  @return 0 on success, else no memory.
+ **/
+static int findSymbols(ExprsDef_t *exprs, ExprsProgram_t *prog)
+{
+	ExprsStatement_t *stmt;
+	const ExprsTerm_t *term;
+	ExprsTermInfo_t *info;
+	int ii, jj, kk, hashSize, *hashTbl, depth, pushedBy[EXPRS_TERM_ASSIGN+1];
+	unsigned int hash;
+	const char *name;
+
+	for ( ii = 0; ii < prog->mNumTerms; ++ii )
+	{
+		prog->mInfo[ii].mSym = -1;
+		prog->mInfo[ii].mLvalue = 0;
+	}
+	/* Small open addressed hash table of indices into mSyms used to spot duplicate names */
+	for ( hashSize = 16; hashSize < prog->mNumTerms * 2; hashSize *= 2 )
+		;
+	hashTbl = (int *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, hashSize * sizeof(int));
+	if ( !hashTbl )
+		return -1;
+	for ( ii = 0; ii < hashSize; ++ii )
+		hashTbl[ii] = -1;
+	for ( ii = 0, term = prog->mTerms; ii < prog->mNumTerms; ++ii, ++term )
+	{
+		if ( term->termType != EXPRS_TERM_SYMBOL )
+			continue;
+		name = prog->mStrings + term->term.string;
+		for ( hash = 5381, jj = 0; name[jj]; ++jj )
+			hash = hash * 33 + (unsigned char)name[jj];
+		for ( kk = hash & (hashSize - 1); hashTbl[kk] >= 0; kk = (kk + 1) & (hashSize - 1) )
+		{
+			if ( !strcmp(prog->mStrings + prog->mSyms[hashTbl[kk]].mName, name) )
+				break;
+		}
+		if ( hashTbl[kk] < 0 )
+		{
+			hashTbl[kk] = prog->mNumSyms;
+			prog->mSyms[prog->mNumSyms].mName = term->term.string;
+			prog->mSyms[prog->mNumSyms].mSlot = -1;
+			++prog->mNumSyms;
+		}
+		prog->mInfo[ii].mSym = hashTbl[kk];
+	}
+	exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, hashTbl);
+	/* Walk each statement's RPN keeping track of which term pushed each stack entry to find the lvalues.
+	 * At the same time see if it is nothing but integer operations. A single assignment is allowed
+	 * if it is the last thing done so nothing has been changed should runIntCode() have to give up. */
+	for ( ii = 0, stmt = prog->mStmts; ii < prog->mNumStmts; ++ii, ++stmt )
+	{
+		bool intOnly = true, assigned = false;
+
+		term = prog->mTerms + stmt->mFirstTerm;
+		info = prog->mInfo + stmt->mFirstTerm;
+		for ( jj = 0, depth = 0; jj < stmt->mNumTerms; ++jj )
+		{
+			if ( assigned && term[jj].termType != EXPRS_TERM_NULL )
+				intOnly = false;
+#if NO_FLOATING_POINT
+			if ( term[jj].termType == EXPRS_TERM_POW )
+				intOnly = false;
+#endif
+			switch (term[jj].termType)
+			{
+			case EXPRS_TERM_NULL:
+				continue;
+			case EXPRS_TERM_INTEGER:
+				if ( term[jj].flags )
+					intOnly = false;
+				/* Fall through to normal push */
+			case EXPRS_TERM_SYMBOL:
+			case EXPRS_TERM_SYMBOL_COMPLEX:
+			case EXPRS_TERM_FUNCTION:
+			case EXPRS_TERM_STRING:
+			case EXPRS_TERM_FLOAT:
+				if ( term[jj].termType != EXPRS_TERM_INTEGER && term[jj].termType != EXPRS_TERM_SYMBOL )
+					intOnly = false;
+				if ( depth >= n_elts(pushedBy) )
+					break;
+				pushedBy[depth++] = jj;
+				continue;
+			case EXPRS_TERM_POS:
+			case EXPRS_TERM_NEG:
+			case EXPRS_TERM_COM:
+			case EXPRS_TERM_NOT:
+			case EXPRS_TERM_HIGH_BYTE:
+			case EXPRS_TERM_LOW_BYTE:
+			case EXPRS_TERM_SWAP:
+				if ( depth < 1 )
+					break;
+				pushedBy[depth - 1] = jj;
+				continue;
+			case EXPRS_TERM_SKIP_FALSE:
+			case EXPRS_TERM_SKIP_TRUE:
+				if ( depth < 1 )
+					break;
+				continue;
+			case EXPRS_TERM_ASSIGN:
+				if ( depth >= 2 && info[pushedBy[depth - 2]].mSym >= 0 )
+					info[pushedBy[depth - 2]].mLvalue = 1;
+				else
+					intOnly = false;
+				assigned = true;
+				/* Fall through to normal binary operator */
+			case EXPRS_TERM_POW:
+			case EXPRS_TERM_MUL:
+			case EXPRS_TERM_DIV:
+			case EXPRS_TERM_MOD:
+			case EXPRS_TERM_ADD:
+			case EXPRS_TERM_SUB:
+			case EXPRS_TERM_SHL:
+			case EXPRS_TERM_SHR:
+			case EXPRS_TERM_GT:
+			case EXPRS_TERM_GE:
+			case EXPRS_TERM_LT:
+			case EXPRS_TERM_LE:
+			case EXPRS_TERM_EQ:
+			case EXPRS_TERM_NE:
+			case EXPRS_TERM_AND:
+			case EXPRS_TERM_XOR:
+			case EXPRS_TERM_OR:
+			case EXPRS_TERM_LAND:
+			case EXPRS_TERM_LOR:
+				if ( depth < 2 )
+					break;
+				pushedBy[--depth - 1] = jj;
+				continue;
+			}
+			break;				/* Malformed. Running it will report the error */
+		}
+		stmt->mIntOnly = intOnly && jj >= stmt->mNumTerms && depth == 1;
+	}
+	return 0;
+}
+
+static bool runIntCode(ExprsDef_t *exprs, const ExprsProgram_t *program, const ExprsIntOp_t *pc, const ExprsSlotRun_t *slotRun, ExprsTerm_t *returnTerm);
+
+#if EXPRS_THREADED_CODE
+/* Handlers of the integer code. Filled in by runIntCode() the first time it is called. */
+static const void *const *IntCodeHandlers;
+static pthread_once_t IntCodeOnce = PTHREAD_ONCE_INIT;
+
+static void intCodeInit(void)
+{
+	runIntCode(NULL, NULL, NULL, NULL, NULL);
+}
+#endif
+
+/** lowerIntCode - translate the RPN of each statement
+ *  findSymbols() found to be integer only into integer code.
+ *
+ *  At entry:
+ *  @param prog - pointer to program with mInfo and mIntOnly
+ *  			filled in and room for numTerms+numStmts ops in
+ *  			mCode
+ *
+ *  At exit:
+ *  @return nothing. mCode of each statement is set.
+ **/
+static void lowerIntCode(ExprsProgram_t *prog)
+{
+	ExprsStatement_t *stmt;
+	const ExprsTerm_t *term;
+	const ExprsTermInfo_t *info;
+	ExprsIntOp_t *op = prog->mCode;
+	const char *chrPtrs[EXPRS_TERM_ASSIGN+1];
+	int skipOp[n_elts(chrPtrs)], skipTo[n_elts(chrPtrs)];	/* Skips waiting for the op after their && or || */
+	int ii, jj, depth, numSkips, lvalue = -1;
+
+#if EXPRS_THREADED_CODE
+	pthread_once(&IntCodeOnce, intCodeInit);
+#endif
+	for ( ii = 0, stmt = prog->mStmts; ii < prog->mNumStmts; ++ii, ++stmt )
+	{
+		stmt->mCode = -1;
+		stmt->mJit = -1;
+		if ( !stmt->mIntOnly )
+			continue;
+		stmt->mCode = op - prog->mCode;
+		term = prog->mTerms + stmt->mFirstTerm;
+		info = prog->mInfo + stmt->mFirstTerm;
+		/* findSymbols() has already checked the stack won't underflow or overflow */
+		for ( jj = 0, depth = 0, numSkips = 0; jj < stmt->mNumTerms; ++jj, ++term )
+		{
+			while ( numSkips && skipTo[numSkips - 1] == jj )
+			{
+				--numSkips;
+				prog->mCode[skipOp[numSkips]].arg.target = op - prog->mCode;
+			}
+			switch (term->termType)
+			{
+			case EXPRS_TERM_INTEGER:
+				op->mOp = INT_OP_PUSH;
+				op->arg.s64 = term->term.s64;
+				++op;
+				chrPtrs[depth++] = term->chrPtr;
+				break;
+			case EXPRS_TERM_SYMBOL:
+				/* The symbol being assigned to doesn't get pushed at all */
+				if ( info[jj].mLvalue )
+					lvalue = info[jj].mSym;
+				else
+				{
+					op->mOp = INT_OP_LOAD;
+					op->arg.sym = info[jj].mSym;
+					++op;
+				}
+				chrPtrs[depth++] = term->chrPtr;
+				break;
+			case EXPRS_TERM_POS:
+			case EXPRS_TERM_NULL:
+				break;
+			case EXPRS_TERM_NEG:
+			case EXPRS_TERM_COM:
+			case EXPRS_TERM_NOT:
+			case EXPRS_TERM_LOW_BYTE:
+			case EXPRS_TERM_HIGH_BYTE:
+			case EXPRS_TERM_SWAP:
+				op->mOp = (ExprsIntOps_t)(INT_OP_NEG + (term->termType - EXPRS_TERM_NEG));
+				++op;
+				break;
+			case EXPRS_TERM_ASSIGN:
+				op->mOp = INT_OP_STORE;
+				op->arg.sym = lvalue;
+				++op;
+				--depth;
+				chrPtrs[depth - 1] = chrPtrs[depth];
+				break;
+			case EXPRS_TERM_SKIP_FALSE:
+			case EXPRS_TERM_SKIP_TRUE:
+				/* Jump past the && or || */
+				op->mOp = term->termType == EXPRS_TERM_SKIP_FALSE ? INT_OP_SKIP_FALSE : INT_OP_SKIP_TRUE;
+				skipOp[numSkips] = op - prog->mCode;
+				skipTo[numSkips++] = jj + term->term.link + 1;
+				++op;
+				break;
+			default:
+				/* All that is left are the binary operators */
+				op->mOp = (ExprsIntOps_t)(INT_OP_NEG + (term->termType - EXPRS_TERM_NEG));
+				++op;
+				--depth;
+				break;
+			}
+		}
+		while ( numSkips )
+		{
+			--numSkips;
+			prog->mCode[skipOp[numSkips]].arg.target = op - prog->mCode;
+		}
+		stmt->mCodeEnd = op - prog->mCode;
+		op->mOp = INT_OP_END;
+		op->arg.chrPtr = chrPtrs[0];
+		++op;
+	}
+#if EXPRS_THREADED_CODE
+	for ( op = op - 1; op >= prog->mCode; --op )
+		op->mHandler = IntCodeHandlers[op->mOp];
+#endif
+}
+
+#if EXPRS_THREADED_CODE
+#define INT_CODE_OP(name) name:
+#define INT_CODE_NEXT() __extension__ ({ goto *(++pc)->mHandler; })
+#define INT_CODE_GOTO(target) __extension__ ({ pc = program->mCode + (target); goto *pc->mHandler; })
+#else
+#define INT_CODE_OP(name) case name:
+#define INT_CODE_NEXT() continue
+#define INT_CODE_GOTO(target) { pc = program->mCode + (target) - 1; continue; }
+#endif
+
+/** runIntCode - run the integer code of one statement on a
+ *  stack of raw int64_t's.
+ *
+ *  At entry:
+ *  @param exprs - pointer to ExprsDef_t returned from
+ *  			 libExprsInit() (NULL just to fill in
+ *  			 IntCodeHandlers)
+ *  @param program - pointer to program holding the code
+ *  @param pc - pointer to first operation of statement
+ *  @param slotRun - pointer to slots holding values of symbols
+ *  			   (NULL if none)
+ *  @param returnTerm - pointer to place to deposit result
+ *
+ *  At exit:
+ *  @return true if computed. false if a symbol turned out not to
+ *  		be an integer or something needs an error reported in
+ *  		which case nothing has been changed and the statement
+ *  		has to be run by runStatement().
+ **/
+static bool runIntCode(ExprsDef_t *exprs, const ExprsProgram_t *program, const ExprsIntOp_t *pc, const ExprsSlotRun_t *slotRun, ExprsTerm_t *returnTerm)
+{
+	int64_t stack[EXPRS_TERM_ASSIGN+1], *sp = stack - 1;
+	const ExprsSymTerm_t *value;
+	ExprsSymTerm_t ans;
+	int slot;
+#if EXPRS_THREADED_CODE
+	static const void *const handlers[INT_OP_MAX] =
+	{
+		__extension__ &&INT_OP_PUSH, __extension__ &&INT_OP_LOAD, __extension__ &&INT_OP_STORE, __extension__ &&INT_OP_END,
+		__extension__ &&INT_OP_SKIP_FALSE, __extension__ &&INT_OP_SKIP_TRUE, __extension__ &&INT_OP_NEG, __extension__ &&INT_OP_POS, __extension__ &&INT_OP_COM, __extension__ &&INT_OP_NOT,
+		__extension__ &&INT_OP_LOW_BYTE, __extension__ &&INT_OP_HIGH_BYTE, __extension__ &&INT_OP_SWAP,
+		__extension__ &&INT_OP_POW, __extension__ &&INT_OP_MUL, __extension__ &&INT_OP_DIV, __extension__ &&INT_OP_MOD,
+		__extension__ &&INT_OP_ADD, __extension__ &&INT_OP_SUB, __extension__ &&INT_OP_SHL, __extension__ &&INT_OP_SHR,
+		__extension__ &&INT_OP_GT, __extension__ &&INT_OP_GE, __extension__ &&INT_OP_LT, __extension__ &&INT_OP_LE,
+		__extension__ &&INT_OP_EQ, __extension__ &&INT_OP_NE, __extension__ &&INT_OP_AND, __extension__ &&INT_OP_XOR,
+		__extension__ &&INT_OP_OR, __extension__ &&INT_OP_LAND, __extension__ &&INT_OP_LOR
+	};
+
+	if ( !pc )
+	{
+		IntCodeHandlers = handlers;
+		return true;
+	}
+	__extension__ ({ goto *pc->mHandler; });
+#else
+	for ( ;; ++pc )
+	{
+	switch (pc->mOp)
+	{
+	case INT_OP_MAX:
+		return false;
+#endif
+	INT_CODE_OP(INT_OP_PUSH)
+		*++sp = pc->arg.s64;
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_LOAD)
+		slot = slotRun ? program->mSyms[pc->arg.sym].mSlot : -1;
+		if ( slot >= 0 )
+			value = slotRun->mSlots + slot;
+		else if ( exprs->mCallbacks.symGet
+				  && !exprs->mCallbacks.symGet(exprs->mCallbacks.symArg, program->mStrings + program->mSyms[pc->arg.sym].mName, &ans) )
+			value = &ans;
+		else
+			return false;
+		if ( value->termType != EXPRS_SYM_TERM_INTEGER || value->flags )
+			return false;
+		*++sp = value->value.s64;
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_STORE)
+		/* It is always the last operation so there is nothing to undo if it fails */
+		ans.termType = EXPRS_SYM_TERM_INTEGER;
+		ans.flags = 0;
+		ans.user1 = NULL;
+		ans.user2 = NULL;
+		ans.value.s64 = *sp;
+		slot = slotRun ? program->mSyms[pc->arg.sym].mSlot : -1;
+		if ( slot >= 0 )
+		{
+			slotRun->mSlots[slot] = ans;
+			slotRun->mPoolStrings[slot] = SLOT_NOT_IN_POOL;
+		}
+		else if ( !exprs->mCallbacks.symGet || !exprs->mCallbacks.symSet
+				  || exprs->mCallbacks.symSet(exprs->mCallbacks.symArg, program->mStrings + program->mSyms[pc->arg.sym].mName, &ans) )
+			return false;
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_END)
+		returnTerm->termType = EXPRS_TERM_INTEGER;
+		returnTerm->flags = 0;
+		returnTerm->term.s64 = *sp;
+		returnTerm->chrPtr = pc->arg.chrPtr;
+		returnTerm->user1 = NULL;
+		return true;
+	INT_CODE_OP(INT_OP_SKIP_FALSE)
+		if ( !*sp )
+			INT_CODE_GOTO(pc->arg.target);
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_SKIP_TRUE)
+		if ( *sp )
+		{
+			*sp = 1;
+			INT_CODE_GOTO(pc->arg.target);
+		}
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_NEG)
+		*sp = -(uint64_t)*sp;
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_POS)
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_COM)
+		*sp = ~*sp;
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_NOT)
+		*sp = *sp ? 0 : 1;
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_LOW_BYTE)
+		*sp &= 0xFF;
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_HIGH_BYTE)
+		*sp = ((uint64_t)*sp >> 8) & 0xFF;
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_SWAP)
+		*sp = (((uint64_t)*sp >> 8) & 0xFF) | (((uint64_t)*sp << 8) & 0xFF00);
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_POW)
+#if !NO_FLOATING_POINT
+		--sp;
+		sp[0] = pow(sp[0], sp[1]);
+		INT_CODE_NEXT();
+#else
+		return false;
+#endif
+	INT_CODE_OP(INT_OP_MUL)
+		--sp;
+		sp[0] = (uint64_t)sp[0] * (uint64_t)sp[1];
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_DIV)
+		--sp;
+		if ( !sp[1] )
+			return false;	/* Let the generic code report it */
+		sp[0] = sp[1] == -1 ? (int64_t)-(uint64_t)sp[0] : sp[0] / sp[1];
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_MOD)
+		--sp;
+		if ( !sp[1] )
+			return false;
+		sp[0] = sp[1] == -1 ? 0 : sp[0] % sp[1];
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_ADD)
+		--sp;
+		sp[0] = (uint64_t)sp[0] + (uint64_t)sp[1];
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_SUB)
+		--sp;
+		sp[0] = (uint64_t)sp[0] - (uint64_t)sp[1];
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_SHL)
+		--sp;
+		sp[0] = (uint64_t)sp[0] << (sp[1] & 63);
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_SHR)
+		--sp;
+		sp[0] >>= (sp[1] & 63);
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_GT)
+		--sp;
+		sp[0] = (int64_t)((uint64_t)sp[0] - (uint64_t)sp[1]) > 0;
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_GE)
+		--sp;
+		sp[0] = (int64_t)((uint64_t)sp[0] - (uint64_t)sp[1]) >= 0;
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_LT)
+		--sp;
+		sp[0] = (int64_t)((uint64_t)sp[0] - (uint64_t)sp[1]) < 0;
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_LE)
+		--sp;
+		sp[0] = (int64_t)((uint64_t)sp[0] - (uint64_t)sp[1]) <= 0;
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_EQ)
+		--sp;
+		sp[0] = sp[0] == sp[1];
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_NE)
+		--sp;
+		sp[0] = sp[0] != sp[1];
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_AND)
+		--sp;
+		sp[0] &= sp[1];
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_XOR)
+		--sp;
+		sp[0] ^= sp[1];
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_OR)
+		--sp;
+		sp[0] |= sp[1];
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_LAND)
+		--sp;
+		sp[0] = (sp[0] && sp[1]) ? 1 : 0;
+		INT_CODE_NEXT();
+	INT_CODE_OP(INT_OP_LOR)
+		--sp;
+		sp[0] = (sp[0] || sp[1]) ? 1 : 0;
+		INT_CODE_NEXT();
+#if !EXPRS_THREADED_CODE
+	}
+	}
+#endif
+}
+
+#if EXPRS_JIT
+/* Native code is called with the slots in rdi and where to put the result in rsi.
+ * It returns 0 if it computed the result or 1 if the interpreter has to do it. */
+typedef int (*ExprsJitFn_t)(const ExprsSymTerm_t *slots, int64_t *result);
+
+#define JIT_MAX_OP_BYTES 48			/* more than the most any one operation emits */
+#define JIT_MAX_STMT_BYTES 32		/* more than the entry, bail and return code of a statement */
+#define JIT_BYTES(pc, bytes) jitBytes(pc, bytes, sizeof(bytes) - 1)
+
+static unsigned char* jitBytes(unsigned char *pc, const char *bytes, int len)
+{
+	memcpy(pc, bytes, len);
+	return pc + len;
+}
+
+static unsigned char* jitImm32(unsigned char *pc, int32_t value)
+{
+	memcpy(pc, &value, sizeof(value));
+	return pc + sizeof(value);
+}
+
+/* Emit a jcc rel32 to target */
+static unsigned char* jitJcc(unsigned char *pc, unsigned char cc, const unsigned char *target)
+{
+	*pc++ = 0x0F;
+	*pc++ = cc;
+	return jitImm32(pc, (int32_t)(target - (pc + 4)));
+}
+
+/* Get the displacement of a member of a slot or -1 if the symbol isn't bound or is too far out */
+static long jitSlotDisp(const ExprsProgram_t *prog, int sym, size_t member)
+{
+	int slot = prog->mSyms[sym].mSlot;
+
+	if ( slot < 0 || slot >= (INT32_MAX - (long)sizeof(ExprsSymTerm_t)) / (long)sizeof(ExprsSymTerm_t) )
+		return -1;
+	return slot * (long)sizeof(ExprsSymTerm_t) + member;
+}
+
+/** jitStatement - translate the integer code of one statement
+ *  to x86-64 native code.
+ *
+ *  At entry:
+ *  @param prog - pointer to program
+ *  @param stmt - pointer to statement with integer code
+ *  @param pc - where to put the native code
+ *
+ *  At exit:
+ *  @return pointer to just past the native code or NULL if the
+ *  		statement has something that can't be translated. The
+ *  		statement's mJit and mJitSlots are set.
+ **/
+static unsigned char* jitStatement(ExprsProgram_t *prog, ExprsStatement_t *stmt, unsigned char *pc)
+{
+	const ExprsIntOp_t *op;
+	unsigned char *bail, *entry, *skipAt[EXPRS_TERM_ASSIGN+1];
+	int skipTo[n_elts(skipAt)];		/* Jumps waiting for their target op to be reached */
+	long disp;
+	int depth = 0, numSkips = 0;
+
+	stmt->mJitSlots = 0;
+	/* Bail out: mov rsp,r8; mov eax,1; ret */
+	bail = pc;
+	pc = JIT_BYTES(pc, "\x4C\x89\xC4\xB8\x01\x00\x00\x00\xC3");
+	/* Entry: mov r8,rsp so anywhere can bail out with things still pushed */
+	entry = pc;
+	pc = JIT_BYTES(pc, "\x49\x89\xE0");
+	/* The top of the stack lives in rax and the rest of it on the machine stack */
+	for ( op = prog->mCode + stmt->mCode; ; ++op )
+	{
+		while ( numSkips && skipTo[numSkips - 1] == op - prog->mCode )
+		{
+			--numSkips;
+			jitImm32(skipAt[numSkips], (int32_t)(pc - (skipAt[numSkips] + 4)));
+		}
+		switch (op->mOp)
+		{
+		case INT_OP_PUSH:
+			if ( depth++ )
+				*pc++ = 0x50;									/* push rax */
+			if ( op->arg.s64 >= INT32_MIN && op->arg.s64 <= INT32_MAX )
+			{
+				pc = JIT_BYTES(pc, "\x48\xC7\xC0");				/* mov rax,imm32 */
+				pc = jitImm32(pc, (int32_t)op->arg.s64);
+			}
+			else
+			{
+				pc = JIT_BYTES(pc, "\x48\xB8");					/* mov rax,imm64 */
+				memcpy(pc, &op->arg.s64, sizeof(op->arg.s64));
+				pc += sizeof(op->arg.s64);
+			}
+			continue;
+		case INT_OP_LOAD:
+			if ( (disp = jitSlotDisp(prog, op->arg.sym, 0)) < 0 )
+				return NULL;
+			stmt->mJitSlots = 1;
+			if ( depth++ )
+				*pc++ = 0x50;									/* push rax */
+			/* The slot has to be a plain integer else let the interpreter deal with it */
+			pc = JIT_BYTES(pc, "\x81\xBF");						/* cmp dword [rdi+disp32],EXPRS_SYM_TERM_INTEGER */
+			pc = jitImm32(pc, disp + offsetof(ExprsSymTerm_t, termType));
+			pc = jitImm32(pc, EXPRS_SYM_TERM_INTEGER);
+			pc = jitJcc(pc, 0x85, bail);						/* jne bail */
+			pc = JIT_BYTES(pc, "\x83\xBF");						/* cmp dword [rdi+disp32],0 */
+			pc = jitImm32(pc, disp + offsetof(ExprsSymTerm_t, flags));
+			*pc++ = 0x00;
+			pc = jitJcc(pc, 0x85, bail);						/* jne bail */
+			pc = JIT_BYTES(pc, "\x48\x8B\x87");					/* mov rax,[rdi+disp32] */
+			pc = jitImm32(pc, disp + offsetof(ExprsSymTerm_t, value));
+			continue;
+		case INT_OP_STORE:
+			/* runJit() does the assignment itself */
+			if ( jitSlotDisp(prog, op->arg.sym, 0) < 0 )
+				return NULL;
+			stmt->mJitSlots = 1;
+			continue;
+		case INT_OP_END:
+			pc = JIT_BYTES(pc, "\x48\x89\x06\x31\xC0\xC3");		/* mov [rsi],rax; xor eax,eax; ret */
+			break;
+		case INT_OP_SKIP_FALSE:
+		case INT_OP_SKIP_TRUE:
+			/* The target is always further on so leave the rel32 to be filled in when it is reached */
+			if ( numSkips >= n_elts(skipAt) )
+				return NULL;
+			pc = JIT_BYTES(pc, "\x48\x85\xC0");					/* test rax,rax */
+			if ( op->mOp == INT_OP_SKIP_FALSE )
+				pc = JIT_BYTES(pc, "\x0F\x84");					/* jz target */
+			else
+				pc = JIT_BYTES(pc, "\x74\x0A\xB8\x01\x00\x00\x00\xE9");	/* jz 1f; mov eax,1; jmp target; 1: */
+			skipAt[numSkips] = pc;
+			skipTo[numSkips++] = op->arg.target;
+			pc += 4;
+			continue;
+		case INT_OP_NEG:
+			pc = JIT_BYTES(pc, "\x48\xF7\xD8");					/* neg rax */
+			continue;
+		case INT_OP_POS:
+			continue;
+		case INT_OP_COM:
+			pc = JIT_BYTES(pc, "\x48\xF7\xD0");					/* not rax */
+			continue;
+		case INT_OP_NOT:
+			pc = JIT_BYTES(pc, "\x48\x85\xC0\x0F\x94\xC0\x0F\xB6\xC0");	/* test rax,rax; sete al; movzx eax,al */
+			continue;
+		case INT_OP_LOW_BYTE:
+			pc = JIT_BYTES(pc, "\x0F\xB6\xC0");					/* movzx eax,al */
+			continue;
+		case INT_OP_HIGH_BYTE:
+			pc = JIT_BYTES(pc, "\x48\xC1\xE8\x08\x0F\xB6\xC0");	/* shr rax,8; movzx eax,al */
+			continue;
+		case INT_OP_SWAP:
+			pc = JIT_BYTES(pc, "\x0F\xB7\xC0\x66\xC1\xC0\x08");	/* movzx eax,ax; rol ax,8 */
+			continue;
+		case INT_OP_POW:
+		case INT_OP_MAX:
+			return NULL;
+		default:
+			/* All that is left are the binary operators. aa goes into rcx, bb is in rax. */
+			*pc++ = 0x59;										/* pop rcx */
+			--depth;
+			break;
+		}
+		if ( op->mOp == INT_OP_END )
+			break;
+		switch (op->mOp)
+		{
+		case INT_OP_MUL:
+			pc = JIT_BYTES(pc, "\x48\x0F\xAF\xC1");				/* imul rax,rcx */
+			break;
+		case INT_OP_DIV:
+		case INT_OP_MOD:
+			pc = JIT_BYTES(pc, "\x48\x85\xC0");					/* test rax,rax */
+			pc = jitJcc(pc, 0x84, bail);						/* jz bail so the interpreter reports it */
+			pc = JIT_BYTES(pc, "\x48\x83\xF8\xFF");				/* cmp rax,-1 (idiv would trap on INT64_MIN/-1) */
+			if ( op->mOp == INT_OP_DIV )
+				pc = JIT_BYTES(pc, "\x75\x08\x48\x89\xC8\x48\xF7\xD8\xEB\x07"		/* jne 1f; mov rax,rcx; neg rax; jmp 2f */
+								   "\x48\x91\x48\x99\x48\xF7\xF9");					/* 1: xchg rax,rcx; cqo; idiv rcx; 2: */
+			else
+				pc = JIT_BYTES(pc, "\x75\x04\x31\xC0\xEB\x0A"						/* jne 1f; xor eax,eax; jmp 2f */
+								   "\x48\x91\x48\x99\x48\xF7\xF9\x48\x89\xD0");		/* 1: xchg rax,rcx; cqo; idiv rcx; mov rax,rdx; 2: */
+			break;
+		case INT_OP_ADD:
+			pc = JIT_BYTES(pc, "\x48\x01\xC8");					/* add rax,rcx */
+			break;
+		case INT_OP_SUB:
+			pc = JIT_BYTES(pc, "\x48\x29\xC1\x48\x89\xC8");		/* sub rcx,rax; mov rax,rcx */
+			break;
+		case INT_OP_SHL:
+			pc = JIT_BYTES(pc, "\x48\x91\x48\xD3\xE0");			/* xchg rax,rcx; shl rax,cl */
+			break;
+		case INT_OP_SHR:
+			pc = JIT_BYTES(pc, "\x48\x91\x48\xD3\xF8");			/* xchg rax,rcx; sar rax,cl */
+			break;
+		/* Comparisons are done on the sign of the difference just like the interpreter */
+		case INT_OP_GT:
+			pc = JIT_BYTES(pc, "\x48\x29\xC1\x48\x85\xC9\x0F\x9F\xC0\x0F\xB6\xC0");	/* sub rcx,rax; test rcx,rcx; setg al; movzx eax,al */
+			break;
+		case INT_OP_GE:
+			pc = JIT_BYTES(pc, "\x48\x29\xC1\x48\x85\xC9\x0F\x9D\xC0\x0F\xB6\xC0");	/* sub rcx,rax; test rcx,rcx; setge al; movzx eax,al */
+			break;
+		case INT_OP_LT:
+			pc = JIT_BYTES(pc, "\x48\x29\xC1\x48\x85\xC9\x0F\x9C\xC0\x0F\xB6\xC0");	/* sub rcx,rax; test rcx,rcx; setl al; movzx eax,al */
+			break;
+		case INT_OP_LE:
+			pc = JIT_BYTES(pc, "\x48\x29\xC1\x48\x85\xC9\x0F\x9E\xC0\x0F\xB6\xC0");	/* sub rcx,rax; test rcx,rcx; setle al; movzx eax,al */
+			break;
+		case INT_OP_EQ:
+			pc = JIT_BYTES(pc, "\x48\x39\xC1\x0F\x94\xC0\x0F\xB6\xC0");				/* cmp rcx,rax; sete al; movzx eax,al */
+			break;
+		case INT_OP_NE:
+			pc = JIT_BYTES(pc, "\x48\x39\xC1\x0F\x95\xC0\x0F\xB6\xC0");				/* cmp rcx,rax; setne al; movzx eax,al */
+			break;
+		case INT_OP_AND:
+			pc = JIT_BYTES(pc, "\x48\x21\xC8");					/* and rax,rcx */
+			break;
+		case INT_OP_XOR:
+			pc = JIT_BYTES(pc, "\x48\x31\xC8");					/* xor rax,rcx */
+			break;
+		case INT_OP_OR:
+			pc = JIT_BYTES(pc, "\x48\x09\xC8");					/* or rax,rcx */
+			break;
+		case INT_OP_LAND:
+			pc = JIT_BYTES(pc, "\x48\x85\xC9\x0F\x95\xC1\x48\x85\xC0\x0F\x95\xC0\x20\xC8\x0F\xB6\xC0");	/* test rcx,rcx; setne cl; test rax,rax; setne al; and al,cl; movzx eax,al */
+			break;
+		case INT_OP_LOR:
+			pc = JIT_BYTES(pc, "\x48\x09\xC8\x48\x85\xC0\x0F\x95\xC0\x0F\xB6\xC0");	/* or rax,rcx; test rax,rax; setne al; movzx eax,al */
+			break;
+		default:
+			return NULL;
+		}
+	}
+	stmt->mJit = entry - prog->mJitCode;
+	return pc;
+}
+
+/** jitProgram - (re)generate the native code of a program
+ *  compiled with EXPRS_FLG_JIT.
+ *
+ *  At entry:
+ *  @param prog - pointer to program with its integer code and
+ *  			symbol bindings in place
+ *
+ *  At exit:
+ *  @return nothing. Statements that could not be translated
+ *  		(or all of them if there is no memory) are left to
+ *  		the interpreter.
+ **/
+static void jitProgram(ExprsProgram_t *prog)
+{
+	ExprsStatement_t *stmt;
+	unsigned char *pc, *end;
+	size_t size;
+	long pageSize;
+	int ii;
+
+	if ( prog->mJitCode )
+		munmap(prog->mJitCode, prog->mJitSize);
+	prog->mJitCode = NULL;
+	prog->mJitSize = 0;
+	for ( ii = 0, stmt = prog->mStmts; ii < prog->mNumStmts; ++ii, ++stmt )
+		stmt->mJit = -1;
+	if ( !(prog->mFlags & EXPRS_FLG_JIT) )
+		return;
+	for ( ii = 0, size = 0, stmt = prog->mStmts; ii < prog->mNumStmts; ++ii, ++stmt )
+	{
+		if ( stmt->mCode >= 0 )
+			size += (stmt->mCodeEnd - stmt->mCode + 1) * JIT_MAX_OP_BYTES + JIT_MAX_STMT_BYTES;
+	}
+	if ( !size )
+		return;
+	pageSize = sysconf(_SC_PAGESIZE);
+	size = (size + pageSize - 1) & ~(pageSize - 1);
+	pc = (unsigned char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if ( pc == (unsigned char *)MAP_FAILED )
+		return;
+	prog->mJitCode = pc;
+	prog->mJitSize = size;
+	for ( ii = 0, stmt = prog->mStmts; ii < prog->mNumStmts; ++ii, ++stmt )
+	{
+		if ( stmt->mCode < 0 )
+			continue;
+		if ( (end = jitStatement(prog, stmt, pc)) )
+			pc = end;
+		else
+			stmt->mJit = -1;
+	}
+	/* Never leave a page both writable and executable */
+	if ( mprotect(prog->mJitCode, prog->mJitSize, PROT_READ | PROT_EXEC) )
+	{
+		munmap(prog->mJitCode, prog->mJitSize);
+		prog->mJitCode = NULL;
+		prog->mJitSize = 0;
+		for ( ii = 0, stmt = prog->mStmts; ii < prog->mNumStmts; ++ii, ++stmt )
+			stmt->mJit = -1;
+	}
+}
+
+/** runJit - run the native code of one statement.
+ *
+ *  At entry:
+ *  @param program - pointer to program
+ *  @param stmt - pointer to statement with native code
+ *  @param slotRun - pointer to slots holding values of symbols
+ *  			   (NULL if none)
+ *  @param returnTerm - pointer to place to deposit result
+ *
+ *  At exit:
+ *  @return true if computed. false if the statement has to be
+ *  		run by the interpreter (nothing has been changed).
+ **/
+static bool runJit(const ExprsProgram_t *program, const ExprsStatement_t *stmt, const ExprsSlotRun_t *slotRun, ExprsTerm_t *returnTerm)
+{
+	const ExprsIntOp_t *end = program->mCode + stmt->mCodeEnd;
+	ExprsJitFn_t fn;
+	int64_t value;
+	int slot;
+
+	if ( stmt->mJitSlots && !slotRun )
+		return false;
+	fn = __extension__ (ExprsJitFn_t)(program->mJitCode + stmt->mJit);
+	if ( fn(slotRun ? slotRun->mSlots : NULL, &value) )
+		return false;
+	if ( end[-1].mOp == INT_OP_STORE )
+	{
+		slot = program->mSyms[end[-1].arg.sym].mSlot;
+		slotRun->mSlots[slot].termType = EXPRS_SYM_TERM_INTEGER;
+		slotRun->mSlots[slot].flags = 0;
+		slotRun->mSlots[slot].value.s64 = value;
+		slotRun->mSlots[slot].user1 = NULL;
+		slotRun->mSlots[slot].user2 = NULL;
+		slotRun->mPoolStrings[slot] = SLOT_NOT_IN_POOL;
+	}
+	returnTerm->termType = EXPRS_TERM_INTEGER;
+	returnTerm->flags = 0;
+	returnTerm->term.s64 = value;
+	returnTerm->chrPtr = end->arg.chrPtr;
+	returnTerm->user1 = NULL;
+	return true;
+}
+#endif	/* EXPRS_JIT */
+
+static ExprsErrs_t buildProgram(ExprsDef_t *exprs,
+								const char *text,
+								size_t textLen,
+								const ExprsTerm_t *terms,
+								int numTerms,
+								const ExprsStatement_t *stmts,
+								int numStmts,
+								ExprsProgram_t **programP)
+{
+	ExprsProgram_t *prog;
+	ExprsTerm_t *term;
+	size_t totSize, stringsSize;
+	char eBuf[256];
+	int ii, maxSyms;
+
+	stringsSize = exprs->mStringPool.mNumUsed;
+	for ( ii = maxSyms = 0; ii < numTerms; ++ii )
+	{
+		if ( terms[ii].termType == EXPRS_TERM_SYMBOL )
+			++maxSyms;
+	}
+	totSize = sizeof(ExprsProgram_t)
+		+ numTerms * sizeof(ExprsTerm_t)
+		+ (numTerms + numStmts) * sizeof(ExprsIntOp_t)
+		+ numStmts * sizeof(ExprsStatement_t)
+		+ numTerms * sizeof(ExprsTermInfo_t)
+		+ maxSyms * sizeof(ExprsSymbol_t)
+		+ stringsSize
+		+ textLen + 1;
+	prog = (ExprsProgram_t *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, totSize);
+	if ( !prog )
+	{
+		snprintf(eBuf, sizeof(eBuf), "libExprsCompile(): Failed to allocate " FMT_SZ " bytes for program: %s\n", totSize, strerror(errno));
+		showMsg(exprs, EXPRS_SEVERITY_FATAL, eBuf);
+		return EXPR_TERM_BAD_OUT_OF_MEMORY;
+	}
+	memset(prog, 0, sizeof(ExprsProgram_t));
+	prog->memFree = exprs->mCallbacks.memFree;
+	prog->memArg = exprs->mCallbacks.memArg;
+	prog->mFlags = exprs->mFlags;
+	prog->mRadix = exprs->mRadix;
+	prog->mNumStmts = numStmts;
+	prog->mNumTerms = numTerms;
+	prog->mStringsSize = stringsSize;
+	prog->mTerms = (ExprsTerm_t *)(prog + 1);
+	prog->mCode = (ExprsIntOp_t *)(prog->mTerms + numTerms);
+	prog->mStmts = (ExprsStatement_t *)(prog->mCode + numTerms + numStmts);
+	prog->mInfo = (ExprsTermInfo_t *)(prog->mStmts + numStmts);
+	prog->mSyms = (ExprsSymbol_t *)(prog->mInfo + numTerms);
+	prog->mStrings = (char *)(prog->mSyms + maxSyms);
+	prog->mText = prog->mStrings + stringsSize;
+	if ( numTerms )
+		memcpy(prog->mTerms, terms, numTerms * sizeof(ExprsTerm_t));
+	if ( numStmts )
+		memcpy(prog->mStmts, stmts, numStmts * sizeof(ExprsStatement_t));
+	if ( stringsSize )
+		memcpy(prog->mStrings, libExprsStringPoolTop(exprs), stringsSize);
+	memcpy(prog->mText, text, textLen);
+	prog->mText[textLen] = 0;
+	/* Point the terms at our copy of the text so it doesn't need to hang around */
+	for ( ii = 0, term = prog->mTerms; ii < numTerms; ++ii, ++term )
+	{
+		if ( term->chrPtr && term->chrPtr >= text && term->chrPtr <= text + textLen )
+			term->chrPtr = prog->mText + (term->chrPtr - text);
+		else
+			term->chrPtr = NULL;
+	}
+	if ( findSymbols(exprs, prog) )
+	{
+		prog->memFree(prog->memArg, prog);
+		return EXPR_TERM_BAD_OUT_OF_MEMORY;
+	}
+	lowerIntCode(prog);
+#if EXPRS_JIT
+	jitProgram(prog);
+#endif
+	*programP = prog;
+	return EXPR_TERM_GOOD;
+}
+
+/* libExprsCompile() and libExprsCompileN() of the textLen bytes at text */
+static ExprsErrs_t compileSpan(ExprsDef_t *exprs, const char *text, size_t textLen, ExprsProgram_t **programP, int alreadyLocked)
+{
+	ExprsErrs_t peErr, err = EXPR_TERM_GOOD, err2 = EXPR_TERM_GOOD;
+	char eBuf[512], saveOpen, saveClose;
+	ExprsTerm_t *terms = NULL;
+	ExprsStatement_t *stmts = NULL;
+	int numTerms = 0, maxTerms = 0, numStmts = 0, maxStmts = 0;
+	const char *ePtr;
+
+	*programP = NULL;
+	if ( !alreadyLocked && (err2 = libExprsLock(exprs)) )
+		return err2;
+	saveOpen = exprs->mOpenDelimiter;
+	saveClose = exprs->mCloseDelimiter;
+	setup(exprs);
+	ePtr = text + textLen;
+	exprs->mLineHead = exprs->mCurrPtr = text;
+	exprs->mEndPtr = ePtr;
+	reset(exprs, true);
+	while ( exprs->mCurrPtr < ePtr )
+	{
+		ExprsStatement_t *stmt;
+		void *newList;
+		int used;
+
+		reset(exprs, false);                /* Clear any existing stacks (keep string pool) */
+		peErr = parseExpression(exprs, 0, true);
+		if ( peErr > EXPR_TERM_END )
+		{
+			err = peErr;
+			if ( exprs->mVerbose )
+			{
+				snprintf(eBuf, sizeof(eBuf), "parseExpression() returned %d: %s\n", err, libExprsGetErrorStr(err));
+				showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
+				dumpStack(exprs, NULL, 0);
+			}
+			break;
+		}
+		if ( (exprs->mFlags & EXPRS_FLG_FOLD_CONSTANTS) )
+			foldConstants(exprs);
+		used = exprs->mStack.mTermsPool.mNumUsed;
+		if ( !(newList = growList(exprs, terms, sizeof(ExprsTerm_t), numTerms, &maxTerms, used)) )
+		{
+			err = EXPR_TERM_BAD_OUT_OF_MEMORY;
+			break;
+		}
+		terms = (ExprsTerm_t *)newList;
+		if ( !(newList = growList(exprs, stmts, sizeof(ExprsStatement_t), numStmts, &maxStmts, 1)) )
+		{
+			err = EXPR_TERM_BAD_OUT_OF_MEMORY;
+			break;
+		}
+		stmts = (ExprsStatement_t *)newList;
+		if ( used )
+			memcpy(terms + numTerms, libExprsTermPoolTop(exprs, &exprs->mStack), used * sizeof(ExprsTerm_t));
+		stmt = stmts + numStmts++;
+		stmt->mFirstTerm = numTerms;
+		stmt->mNumTerms = used;
+		numTerms += used;
+		if ( !((exprs->mFlags & EXPRS_FLG_WS_DELIMIT) && peErr == EXPR_TERM_END) && exprs->mCurrPtr < ePtr )
+			++exprs->mCurrPtr;
+		stmt->mEndOffset = exprs->mCurrPtr - text;
+		if ( (exprs->mFlags & EXPRS_FLG_WS_DELIMIT) && peErr == EXPR_TERM_END )
+			break;
+	}
+	if ( !err )
+		err = buildProgram(exprs, text, textLen, terms, numTerms, stmts, numStmts, programP);
+	if ( terms )
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, terms);
+	if ( stmts )
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, stmts);
+	if ( (exprs->mFlags & EXPRS_FLG_SPECIAL_UNARY) )
+	{
+		exprs->mOpenDelimiter = saveOpen;
+		exprs->mCloseDelimiter = saveClose;
+	}
+	if ( !alreadyLocked )
+		err2 = libExprsUnlock(exprs);
+	return err ? err : err2;
+}
+
+ExprsErrs_t libExprsCompile(ExprsDef_t *exprs, const char *text, ExprsProgram_t **programP, int alreadyLocked)
+{
+	if ( !exprs || !text || !programP )
+		return EXPR_TERM_BAD_PARAMETER;
+	return compileSpan(exprs, text, strlen(text), programP, alreadyLocked);
+}
+
+ExprsErrs_t libExprsCompileN(ExprsDef_t *exprs, const char *text, size_t len, ExprsProgram_t **programP, int alreadyLocked)
+{
+	if ( !exprs || (!text && len) || !programP )
+		return EXPR_TERM_BAD_PARAMETER;
+	return compileSpan(exprs, text ? text : "", len, programP, alreadyLocked);
+}
+
+static ExprsErrs_t loadProgramStrings(ExprsDef_t *exprs, const ExprsProgram_t *program)
+{
+	char *strings;
+
+	reset(exprs, true);
+	if ( program->mStringsSize )
+	{
+		/* The terms refer to strings by offset so they have to go back at the bottom of the pool */
+		strings = getFromStringPool(exprs, program->mStringsSize);
+		if ( !strings )
+			return EXPR_TERM_BAD_OUT_OF_MEMORY;
+		memcpy(strings, program->mStrings, program->mStringsSize);
+	}
+	exprs->mLineHead = exprs->mCurrPtr = program->mText;
+	return EXPR_TERM_GOOD;
+}
+
+/* Run one statement of a program the fastest way available */
+static ExprsErrs_t runProgramStmt(ExprsDef_t *exprs, const ExprsProgram_t *program, const ExprsStatement_t *stmt, ExprsSlotRun_t *slotRun, ExprsTerm_t *returnTerm)
+{
+	if ( slotRun )
+		slotRun->mInfo = program->mInfo + stmt->mFirstTerm;
+#if EXPRS_JIT
+	if ( stmt->mJit >= 0 && !exprs->mVerbose && runJit(program, stmt, slotRun, returnTerm) )
+		return EXPR_TERM_GOOD;
+#endif
+	if ( stmt->mCode >= 0 && !exprs->mVerbose && runIntCode(exprs, program, program->mCode + stmt->mCode, slotRun, returnTerm) )
+		return EXPR_TERM_GOOD;
+	return runStatement(exprs, program->mTerms + stmt->mFirstTerm, stmt->mNumTerms, slotRun, returnTerm);
+}
+
+static ExprsErrs_t runProgram(ExprsDef_t *exprs, const ExprsProgram_t *program, ExprsSlotRun_t *slotRun, ExprsTerm_t *returnTerm)
+{
+	ExprsErrs_t err = EXPR_TERM_BAD_SYNTAX;
+	const ExprsStatement_t *stmt;
+	int ii;
+
+	returnTerm->termType = EXPRS_TERM_NULL;
+	returnTerm->term.s64 = 0;
+	returnTerm->chrPtr = NULL;
+	if ( (err = loadProgramStrings(exprs, program)) )
+		return err;
+	err = EXPR_TERM_BAD_SYNTAX;
+	for ( ii = 0, stmt = program->mStmts; ii < program->mNumStmts; ++ii, ++stmt )
+	{
+		err = runProgramStmt(exprs, program, stmt, slotRun, returnTerm);
+		exprs->mCurrPtr = program->mText + stmt->mEndOffset;
+		if ( err > EXPR_TERM_END )
+			break;
+	}
+	return err;
+}
+
+static int runWaves(ExprsDef_t *exprs, const ExprsProgram_t *program, ExprsTerm_t *returnTerm, ExprsErrs_t *errP);
+
+ExprsErrs_t libExprsRun(ExprsDef_t *exprs, const ExprsProgram_t *program, ExprsTerm_t *returnTerm, int alreadyLocked)
+{
+	ExprsErrs_t err, err2 = EXPR_TERM_GOOD;
+
+	if ( !exprs || !program || !returnTerm )
+		return EXPR_TERM_BAD_PARAMETER;
+	if ( !alreadyLocked && (err2 = libExprsLock(exprs)) )
+		return err2;
+	if ( !runWaves(exprs, program, returnTerm, &err) )
+		err = runProgram(exprs, program, NULL, returnTerm);
+	if ( !alreadyLocked )
+		err2 = libExprsUnlock(exprs);
+	return err ? err : err2;
+}
+
+int libExprsProgramNumSymbols(const ExprsProgram_t *program)
+{
+	return program ? program->mNumSyms : 0;
+}
+
+const char* libExprsProgramSymbolName(const ExprsProgram_t *program, int symIdx)
+{
+	if ( !program || symIdx < 0 || symIdx >= program->mNumSyms )
+		return NULL;
+	return program->mStrings + program->mSyms[symIdx].mName;
+}
+
+ExprsErrs_t libExprsBindSymbols(ExprsProgram_t *program, ExprsErrs_t (*bindCallback)(void *bindArg, const char *symName, int *slotP), void *bindArg)
+{
+	ExprsErrs_t err = EXPR_TERM_GOOD;
+	int ii, slot;
+
+	if ( !program )
+		return EXPR_TERM_BAD_PARAMETER;
+	for ( ii = 0; ii < program->mNumSyms; ++ii )
+	{
+		slot = ii;
+		if ( bindCallback && (err = bindCallback(bindArg, program->mStrings + program->mSyms[ii].mName, &slot)) )
+			break;
+		program->mSyms[ii].mSlot = slot < 0 ? -1 : slot;
+	}
+#if EXPRS_JIT
+	/* The slot numbers are built into the native code */
+	jitProgram(program);
+#endif
+	return err;
+}
+
+ExprsErrs_t libExprsRunSlots(ExprsDef_t *exprs, const ExprsProgram_t *program, ExprsSymTerm_t *slots, int numSlots, ExprsTerm_t *returnTerm, int alreadyLocked)
+{
+	ExprsErrs_t err, err2 = EXPR_TERM_GOOD;
+	ExprsSlotRun_t slotRun;
+	size_t lclPoolStrings[32];
+	char eBuf[256];
+	int ii;
+
+	if ( !exprs || !program || !returnTerm || numSlots < 0 || (numSlots && !slots) )
+		return EXPR_TERM_BAD_PARAMETER;
+	for ( ii = 0; ii < program->mNumSyms; ++ii )
+	{
+		if ( program->mSyms[ii].mSlot >= numSlots )
+		{
+			snprintf(eBuf, sizeof(eBuf), "libExprsRunSlots(): Symbol '%s' is bound to slot %d but only %d slots provided\n",
+					 program->mStrings + program->mSyms[ii].mName, program->mSyms[ii].mSlot, numSlots);
+			showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
+			return EXPR_TERM_BAD_PARAMETER;
+		}
+	}
+	slotRun.mSyms = program->mSyms;
+	slotRun.mSlots = slots;
+	slotRun.mPoolStrings = lclPoolStrings;
+	if ( numSlots > n_elts(lclPoolStrings) )
+	{
+		slotRun.mPoolStrings = (size_t *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, numSlots * sizeof(size_t));
+		if ( !slotRun.mPoolStrings )
+			return EXPR_TERM_BAD_OUT_OF_MEMORY;
+	}
+	for ( ii = 0; ii < numSlots; ++ii )
+		slotRun.mPoolStrings[ii] = SLOT_NOT_IN_POOL;
+	if ( !alreadyLocked && (err2 = libExprsLock(exprs)) )
+		err = err2;
+	else
+	{
+		err = runProgram(exprs, program, &slotRun, returnTerm);
+		/* The pool may have moved since the strings were assigned */
+		for ( ii = 0; ii < numSlots; ++ii )
+		{
+			if ( slotRun.mPoolStrings[ii] != SLOT_NOT_IN_POOL )
+				slots[ii].value.string = libExprsStringPoolTop(exprs) + slotRun.mPoolStrings[ii];
+		}
+		if ( !alreadyLocked )
+			err2 = libExprsUnlock(exprs);
+	}
+	if ( slotRun.mPoolStrings != lclPoolStrings )
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, slotRun.mPoolStrings);
+	return err ? err : err2;
+}
+
+/* A thread's working space. It is just a private ExprsDef_t (like each
+ * worker of libExprsSetThreads() has) that is never locked. */
+struct ExprsScratch_t
+{
+	ExprsDef_t *mExprs;
+};
+
+ExprsErrs_t libExprsScratchCreate(ExprsDef_t *exprs, ExprsScratch_t **scratchP, int alreadyLocked)
+{
+	ExprsErrs_t err = EXPR_TERM_GOOD, err2 = EXPR_TERM_GOOD;
+	ExprsScratch_t *scratch;
+
+	if ( !exprs || !scratchP )
+		return EXPR_TERM_BAD_PARAMETER;
+	*scratchP = NULL;
+	if ( !alreadyLocked && (err2 = libExprsLock(exprs)) )
+		return err2;
+	scratch = (ExprsScratch_t *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, sizeof(ExprsScratch_t));
+	if ( scratch && !(scratch->mExprs = libExprsInit(&exprs->mCallbacks, exprs->mTermsPoolInc, exprs->mStringPoolInc)) )
+	{
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, scratch);
+		scratch = NULL;
+	}
+	if ( !scratch )
+		err = EXPR_TERM_BAD_OUT_OF_MEMORY;
+	*scratchP = scratch;
+	if ( !alreadyLocked )
+		err2 = libExprsUnlock(exprs);
+	return err ? err : err2;
+}
+
+void libExprsScratchFree(ExprsScratch_t *scratch)
+{
+	void (*memFree)(void *memArg, void *memPtr);
+	void *memArg;
+
+	if ( !scratch )
+		return;
+	memFree = scratch->mExprs->mCallbacks.memFree;
+	memArg = scratch->mExprs->mCallbacks.memArg;
+	libExprsDestroy(scratch->mExprs);
+	memFree(memArg, scratch);
+}
+
+char *libExprsScratchStringPoolTop(ExprsScratch_t *scratch)
+{
+	return libExprsStringPoolTop(scratch->mExprs);
+}
+
+ExprsErrs_t libExprsRunScratch(ExprsScratch_t *scratch, const ExprsProgram_t *program, ExprsTerm_t *returnTerm)
+{
+	if ( !scratch || !program || !returnTerm )
+		return EXPR_TERM_BAD_PARAMETER;
+	return runProgram(scratch->mExprs, program, NULL, returnTerm);
+}
+
+ExprsErrs_t libExprsRunSlotsScratch(ExprsScratch_t *scratch, const ExprsProgram_t *program, ExprsSymTerm_t *slots, int numSlots, ExprsTerm_t *returnTerm)
+{
+	if ( !scratch )
+		return EXPR_TERM_BAD_PARAMETER;
+	return libExprsRunSlots(scratch->mExprs, program, slots, numSlots, returnTerm, 1);
+}
+
+#define BATCH_ROWS 256				/* number of rows computed per pass over the RPN */
+
+/* Batch values are held in arrays of these so either type can live at any stack level */
+typedef union
+{
+	long s64;
+	unsigned long u64;
+	double f64;
+} BatchValue_t;
+
+/* One level of the batch evaluator's stack */
+typedef struct
+{
+	ExprsTermTypes_t mType;			/* EXPRS_TERM_INTEGER or EXPRS_TERM_FLOAT */
+	BatchValue_t *mVals;			/* BATCH_ROWS values */
+} BatchEntry_t;
+
+/* Everything the batch evaluator needs while computing blocks of rows */
+typedef struct
+{
+	ExprsDef_t *exprs;
+	const ExprsProgram_t *program;
+	const ExprsColumn_t *columns;
+	BatchEntry_t *stack;
+	int firstRow;					/* row number of first row in block */
+	int errRow;						/* first row found in error (-1 if none) */
+	ExprsErrs_t err;				/* error found at errRow */
+} BatchParams_t;
+
+/** batchPlan - decide whether a program can be computed a column
+ *  at a time.
+ *
+ *  At entry:
+ *  @param program - pointer to program to examine
+ *  @param columns - pointer to list of input columns
+ *  @param numColumns - number of columns
+ *  @param depthP - pointer to place to deposit maximum stack depth
+ *
+ *  At exit:
+ *  @return non-zero if it can be. Only a single statement of
+ *  		integer and float arithmetic on constants and symbols
+ *  		bound to columns qualifies. Anything else (strings,
+ *  		assignments, unbound symbols, etc.) has to be run a
+ *  		row at a time.
+ *
+ *  @note Both sides of && and || are always computed a column
+ *  	  at a time. That is only the same as skipping the right
+ *  	  side if it can't fail so a statement with both a && or
+ *  	  || and a divide has to be run a row at a time.
+ **/
+static int batchPlan(const ExprsProgram_t *program, const ExprsColumn_t *columns, int numColumns, int *depthP)
+{
+	const ExprsTerm_t *term;
+	const ExprsTermInfo_t *info;
+	ExprsTermTypes_t types[EXPRS_TERM_ASSIGN+1];
+	int ii, slot, depth = 0, maxDepth = 0;
+	bool hasSkip = false, canFail = false;
+
+	if ( program->mNumStmts != 1 )
+		return 0;
+	term = program->mTerms;
+	info = program->mInfo;
+	for ( ii = 0; ii < program->mNumTerms; ++ii, ++term, ++info )
+	{
+		switch (term->termType)
+		{
+		case EXPRS_TERM_NULL:
+			continue;
+		case EXPRS_TERM_SYMBOL:
+			if ( info->mSym < 0 || info->mLvalue )
+				return 0;
+			slot = program->mSyms[info->mSym].mSlot;
+			if ( slot < 0 || slot >= numColumns || depth >= n_elts(types) )
+				return 0;
+			types[depth++] = (ExprsTermTypes_t)columns[slot].termType;
+			break;
+		case EXPRS_TERM_INTEGER:
+		case EXPRS_TERM_FLOAT:
+			if ( depth >= n_elts(types) )
+				return 0;
+			types[depth++] = term->termType;
+			break;
+		case EXPRS_TERM_POS:
+		case EXPRS_TERM_NEG:
+			if ( depth < 1 )
+				return 0;
+			break;
+		case EXPRS_TERM_COM:
+		case EXPRS_TERM_NOT:
+		case EXPRS_TERM_LOW_BYTE:
+		case EXPRS_TERM_HIGH_BYTE:
+		case EXPRS_TERM_SWAP:
+			if ( depth < 1 )
+				return 0;
+			types[depth - 1] = EXPRS_TERM_INTEGER;
+			break;
+		case EXPRS_TERM_SKIP_FALSE:
+		case EXPRS_TERM_SKIP_TRUE:
+			if ( depth < 1 )
+				return 0;
+			hasSkip = true;
+			break;
+		case EXPRS_TERM_MOD:
+		case EXPRS_TERM_DIV:
+			canFail = true;
+			/* Fall through */
+		case EXPRS_TERM_POW:
+#if NO_FLOATING_POINT
+			if ( term->termType != EXPRS_TERM_DIV )
+				return 0;
+#endif
+		case EXPRS_TERM_MUL:
+		case EXPRS_TERM_ADD:
+		case EXPRS_TERM_SUB:
+			if ( depth < 2 )
+				return 0;
+			--depth;
+			if ( types[depth] == EXPRS_TERM_FLOAT )
+				types[depth - 1] = EXPRS_TERM_FLOAT;
+			break;
+		case EXPRS_TERM_SHL:
+		case EXPRS_TERM_SHR:
+		case EXPRS_TERM_GT:
+		case EXPRS_TERM_GE:
+		case EXPRS_TERM_LT:
+		case EXPRS_TERM_LE:
+		case EXPRS_TERM_EQ:
+		case EXPRS_TERM_NE:
+		case EXPRS_TERM_AND:
+		case EXPRS_TERM_XOR:
+		case EXPRS_TERM_OR:
+		case EXPRS_TERM_LAND:
+		case EXPRS_TERM_LOR:
+			if ( depth < 2 )
+				return 0;
+			--depth;
+			types[depth - 1] = EXPRS_TERM_INTEGER;
+			break;
+		default:
+			return 0;
+		}
+		if ( depth > maxDepth )
+			maxDepth = depth;
+	}
+	if ( depth != 1 || (hasSkip && canFail) )
+		return 0;
+	*depthP = maxDepth;
+	return 1;
+}
+
+static void batchError(BatchParams_t *params, int row, ExprsErrs_t err)
+{
+	if ( params->errRow < 0 || row < params->errRow )
+	{
+		params->errRow = row;
+		params->err = err;
+	}
+}
+
+/* Same conversion prepUnaryTerm() and prepBinaryTerms() do with toInteger set */
+static void batchToInteger(BatchEntry_t *ent, int numRows)
+{
+	int ii;
+	if ( ent->mType == EXPRS_TERM_FLOAT )
+	{
+		for ( ii = 0; ii < numRows; ++ii )
+			ent->mVals[ii].s64 = ent->mVals[ii].f64;
+		ent->mType = EXPRS_TERM_INTEGER;
+	}
+}
+
+/* Same promotion doAdd() et al do when one term is float and the other integer */
+static void batchToFloat(BatchEntry_t *ent, int numRows)
+{
+	int ii;
+	if ( ent->mType == EXPRS_TERM_INTEGER )
+	{
+		for ( ii = 0; ii < numRows; ++ii )
+			ent->mVals[ii].f64 = ent->mVals[ii].s64;
+		ent->mType = EXPRS_TERM_FLOAT;
+	}
+}
+
+static void batchUnary(ExprsTermTypes_t op, BatchEntry_t *aa, int numRows)
+{
+	BatchValue_t *av = aa->mVals;
+	int ii;
+
+	if ( op == EXPRS_TERM_POS )
+		return;
+	if ( op == EXPRS_TERM_NEG )
+	{
+		if ( aa->mType == EXPRS_TERM_FLOAT )
+		{
+			for ( ii = 0; ii < numRows; ++ii )
+				av[ii].f64 = -av[ii].f64;
+		}
+		else
+		{
+			for ( ii = 0; ii < numRows; ++ii )
+				av[ii].s64 = -(unsigned long)av[ii].s64;
+		}
+		return;
+	}
+	batchToInteger(aa, numRows);
+	switch (op)
+	{
+	case EXPRS_TERM_COM:
+		for ( ii = 0; ii < numRows; ++ii )
+			av[ii].s64 = ~av[ii].s64;
+		break;
+	case EXPRS_TERM_NOT:
+		for ( ii = 0; ii < numRows; ++ii )
+			av[ii].s64 = av[ii].s64 ? 0 : 1;
+		break;
+	case EXPRS_TERM_LOW_BYTE:
+		for ( ii = 0; ii < numRows; ++ii )
+			av[ii].s64 = av[ii].s64 & 0xFF;
+		break;
+	case EXPRS_TERM_HIGH_BYTE:
+		for ( ii = 0; ii < numRows; ++ii )
+			av[ii].s64 = (av[ii].s64 >> 8) & 0xFF;
+		break;
+	case EXPRS_TERM_SWAP:
+		for ( ii = 0; ii < numRows; ++ii )
+			av[ii].s64 = ((av[ii].u64 >> 8) & 0xFF) | ((av[ii].u64 << 8) & 0xFF00);
+		break;
+	default:
+		break;
+	}
+}
+
+/* Vector kernels for the batch evaluator. Each one computes the rows it can
+ * (a multiple of its vector width) and returns how many it did, leaving the rest
+ * to the scalar loops. Only operations that give bit for bit the same answers as
+ * the scalar code are done; anything else returns 0. */
+typedef int (*BatchKernel_t)(ExprsTermTypes_t op, BatchValue_t *av, const BatchValue_t *bv, int numRows);
+
+static struct
+{
+	int isa;						/* EXPRS_BATCH_ISA_xxx in use */
+	BatchKernel_t intOp;			/* integer operators (NULL if none) */
+	BatchKernel_t floatOp;			/* float operators (NULL if none) */
+} BatchKernels;
+
+static pthread_once_t BatchKernelsOnce = PTHREAD_ONCE_INIT;
+static int BatchMaxIsa = EXPRS_BATCH_ISA_AVX2;
+
+#if EXPRS_BATCH_SIMD
+#define AVX2_INT_LOOP(expr) \
+	for ( ii = 0; ii < last; ii += 4 ) \
+	{ \
+		aa = _mm256_loadu_si256((const __m256i *)(av + ii)); \
+		bb = _mm256_loadu_si256((const __m256i *)(bv + ii)); \
+		_mm256_storeu_si256((__m256i *)(av + ii), (expr)); \
+	}
+
+__attribute__((target("avx2")))
+static int batchIntAvx2(ExprsTermTypes_t op, BatchValue_t *av, const BatchValue_t *bv, int numRows)
+{
+	const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi64x(1), mask63 = _mm256_set1_epi64x(63);
+	__m256i aa, bb;
+	int ii, last = numRows & ~3;
+
+	switch (op)
+	{
+	case EXPRS_TERM_ADD:
+		AVX2_INT_LOOP(_mm256_add_epi64(aa, bb));
+		break;
+	case EXPRS_TERM_SUB:
+		AVX2_INT_LOOP(_mm256_sub_epi64(aa, bb));
+		break;
+	case EXPRS_TERM_SHL:
+		AVX2_INT_LOOP(_mm256_sllv_epi64(aa, _mm256_and_si256(bb, mask63)));
+		break;
+	case EXPRS_TERM_GT:
+		AVX2_INT_LOOP(_mm256_and_si256(_mm256_cmpgt_epi64(_mm256_sub_epi64(aa, bb), zero), one));
+		break;
+	case EXPRS_TERM_GE:
+		AVX2_INT_LOOP(_mm256_andnot_si256(_mm256_cmpgt_epi64(zero, _mm256_sub_epi64(aa, bb)), one));
+		break;
+	case EXPRS_TERM_LT:
+		AVX2_INT_LOOP(_mm256_and_si256(_mm256_cmpgt_epi64(zero, _mm256_sub_epi64(aa, bb)), one));
+		break;
+	case EXPRS_TERM_LE:
+		AVX2_INT_LOOP(_mm256_andnot_si256(_mm256_cmpgt_epi64(_mm256_sub_epi64(aa, bb), zero), one));
+		break;
+	case EXPRS_TERM_EQ:
+		AVX2_INT_LOOP(_mm256_and_si256(_mm256_cmpeq_epi64(aa, bb), one));
+		break;
+	case EXPRS_TERM_NE:
+		AVX2_INT_LOOP(_mm256_andnot_si256(_mm256_cmpeq_epi64(aa, bb), one));
+		break;
+	case EXPRS_TERM_AND:
+		AVX2_INT_LOOP(_mm256_and_si256(aa, bb));
+		break;
+	case EXPRS_TERM_XOR:
+		AVX2_INT_LOOP(_mm256_xor_si256(aa, bb));
+		break;
+	case EXPRS_TERM_OR:
+		AVX2_INT_LOOP(_mm256_or_si256(aa, bb));
+		break;
+	case EXPRS_TERM_LAND:
+		AVX2_INT_LOOP(_mm256_andnot_si256(_mm256_or_si256(_mm256_cmpeq_epi64(aa, zero), _mm256_cmpeq_epi64(bb, zero)), one));
+		break;
+	case EXPRS_TERM_LOR:
+		AVX2_INT_LOOP(_mm256_andnot_si256(_mm256_and_si256(_mm256_cmpeq_epi64(aa, zero), _mm256_cmpeq_epi64(bb, zero)), one));
+		break;
+	default:
+		return 0;				/* mul, div, mod, pow and shr have no exact 64 bit vector form */
+	}
+	return last;
+}
+
+#define AVX2_FLOAT_LOOP(expr) \
+	for ( ii = 0; ii < last; ii += 4 ) \
+	{ \
+		aa = _mm256_loadu_pd((const double *)(av + ii)); \
+		bb = _mm256_loadu_pd((const double *)(bv + ii)); \
+		_mm256_storeu_pd((double *)(av + ii), (expr)); \
+	}
+
+/* Comparisons leave an integer 0 or 1 */
+#define AVX2_FLOAT_CMP(pred) AVX2_FLOAT_LOOP(_mm256_castsi256_pd(_mm256_and_si256(_mm256_castpd_si256(_mm256_cmp_pd(_mm256_sub_pd(aa, bb), zero, pred)), one)))
+
+__attribute__((target("avx2")))
+static int batchFloatAvx2(ExprsTermTypes_t op, BatchValue_t *av, const BatchValue_t *bv, int numRows)
+{
+	const __m256d zero = _mm256_setzero_pd();
+	const __m256i one = _mm256_set1_epi64x(1);
+	__m256d aa, bb;
+	int ii, last = numRows & ~3;
+
+	switch (op)
+	{
+	case EXPRS_TERM_ADD:
+		AVX2_FLOAT_LOOP(_mm256_add_pd(aa, bb));
+		break;
+	case EXPRS_TERM_SUB:
+		AVX2_FLOAT_LOOP(_mm256_sub_pd(aa, bb));
+		break;
+	case EXPRS_TERM_MUL:
+		AVX2_FLOAT_LOOP(_mm256_mul_pd(aa, bb));
+		break;
+	case EXPRS_TERM_DIV:
+		/* Leave the whole lot to the scalar code if there is a divide by 0 anywhere */
+		for ( ii = 0; ii < numRows; ++ii )
+		{
+			if ( bv[ii].f64 == 0.0 )
+				return 0;
+		}
+		AVX2_FLOAT_LOOP(_mm256_div_pd(aa, bb));
+		break;
+	case EXPRS_TERM_GT:
+		AVX2_FLOAT_CMP(_CMP_GT_OQ);
+		break;
+	case EXPRS_TERM_GE:
+		AVX2_FLOAT_CMP(_CMP_GE_OQ);
+		break;
+	case EXPRS_TERM_LT:
+		AVX2_FLOAT_CMP(_CMP_LT_OQ);
+		break;
+	case EXPRS_TERM_LE:
+		AVX2_FLOAT_CMP(_CMP_LE_OQ);
+		break;
+	case EXPRS_TERM_EQ:
+		AVX2_FLOAT_CMP(_CMP_EQ_OQ);
+		break;
+	case EXPRS_TERM_NE:
+		AVX2_FLOAT_CMP(_CMP_NEQ_UQ);
+		break;
+	default:
+		return 0;				/* mod and pow go through libm */
+	}
+	return last;
+}
+
+#define SSE_INT_LOOP(expr) \
+	for ( ii = 0; ii < last; ii += 2 ) \
+	{ \
+		aa = _mm_loadu_si128((const __m128i *)(av + ii)); \
+		bb = _mm_loadu_si128((const __m128i *)(bv + ii)); \
+		_mm_storeu_si128((__m128i *)(av + ii), (expr)); \
+	}
+
+__attribute__((target("sse4.2")))
+static int batchIntSse42(ExprsTermTypes_t op, BatchValue_t *av, const BatchValue_t *bv, int numRows)
+{
+	const __m128i zero = _mm_setzero_si128(), one = _mm_set1_epi64x(1);
+	__m128i aa, bb;
+	int ii, last = numRows & ~1;
+
+	switch (op)
+	{
+	case EXPRS_TERM_ADD:
+		SSE_INT_LOOP(_mm_add_epi64(aa, bb));
+		break;
+	case EXPRS_TERM_SUB:
+		SSE_INT_LOOP(_mm_sub_epi64(aa, bb));
+		break;
+	case EXPRS_TERM_GT:
+		SSE_INT_LOOP(_mm_and_si128(_mm_cmpgt_epi64(_mm_sub_epi64(aa, bb), zero), one));
+		break;
+	case EXPRS_TERM_GE:
+		SSE_INT_LOOP(_mm_andnot_si128(_mm_cmpgt_epi64(zero, _mm_sub_epi64(aa, bb)), one));
+		break;
+	case EXPRS_TERM_LT:
+		SSE_INT_LOOP(_mm_and_si128(_mm_cmpgt_epi64(zero, _mm_sub_epi64(aa, bb)), one));
+		break;
+	case EXPRS_TERM_LE:
+		SSE_INT_LOOP(_mm_andnot_si128(_mm_cmpgt_epi64(_mm_sub_epi64(aa, bb), zero), one));
+		break;
+	case EXPRS_TERM_EQ:
+		SSE_INT_LOOP(_mm_and_si128(_mm_cmpeq_epi64(aa, bb), one));
+		break;
+	case EXPRS_TERM_NE:
+		SSE_INT_LOOP(_mm_andnot_si128(_mm_cmpeq_epi64(aa, bb), one));
+		break;
+	case EXPRS_TERM_AND:
+		SSE_INT_LOOP(_mm_and_si128(aa, bb));
+		break;
+	case EXPRS_TERM_XOR:
+		SSE_INT_LOOP(_mm_xor_si128(aa, bb));
+		break;
+	case EXPRS_TERM_OR:
+		SSE_INT_LOOP(_mm_or_si128(aa, bb));
+		break;
+	case EXPRS_TERM_LAND:
+		SSE_INT_LOOP(_mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi64(aa, zero), _mm_cmpeq_epi64(bb, zero)), one));
+		break;
+	case EXPRS_TERM_LOR:
+		SSE_INT_LOOP(_mm_andnot_si128(_mm_and_si128(_mm_cmpeq_epi64(aa, zero), _mm_cmpeq_epi64(bb, zero)), one));
+		break;
+	default:
+		return 0;				/* no variable shifts before AVX2 either */
+	}
+	return last;
+}
+
+#define SSE_FLOAT_LOOP(expr) \
+	for ( ii = 0; ii < last; ii += 2 ) \
+	{ \
+		aa = _mm_loadu_pd((const double *)(av + ii)); \
+		bb = _mm_loadu_pd((const double *)(bv + ii)); \
+		_mm_storeu_pd((double *)(av + ii), (expr)); \
+	}
+
+#define SSE_FLOAT_CMP(cmp) SSE_FLOAT_LOOP(_mm_castsi128_pd(_mm_and_si128(_mm_castpd_si128(cmp(_mm_sub_pd(aa, bb), zero)), one)))
+
+__attribute__((target("sse4.2")))
+static int batchFloatSse42(ExprsTermTypes_t op, BatchValue_t *av, const BatchValue_t *bv, int numRows)
+{
+	const __m128d zero = _mm_setzero_pd();
+	const __m128i one = _mm_set1_epi64x(1);
+	__m128d aa, bb;
+	int ii, last = numRows & ~1;
+
+	switch (op)
+	{
+	case EXPRS_TERM_ADD:
+		SSE_FLOAT_LOOP(_mm_add_pd(aa, bb));
+		break;
+	case EXPRS_TERM_SUB:
+		SSE_FLOAT_LOOP(_mm_sub_pd(aa, bb));
+		break;
+	case EXPRS_TERM_MUL:
+		SSE_FLOAT_LOOP(_mm_mul_pd(aa, bb));
+		break;
+	case EXPRS_TERM_DIV:
+		for ( ii = 0; ii < numRows; ++ii )
+		{
+			if ( bv[ii].f64 == 0.0 )
+				return 0;
+		}
+		SSE_FLOAT_LOOP(_mm_div_pd(aa, bb));
+		break;
+	case EXPRS_TERM_GT:
+		SSE_FLOAT_CMP(_mm_cmpgt_pd);
+		break;
+	case EXPRS_TERM_GE:
+		SSE_FLOAT_CMP(_mm_cmpge_pd);
+		break;
+	case EXPRS_TERM_LT:
+		SSE_FLOAT_CMP(_mm_cmplt_pd);
+		break;
+	case EXPRS_TERM_LE:
+		SSE_FLOAT_CMP(_mm_cmple_pd);
+		break;
+	case EXPRS_TERM_EQ:
+		SSE_FLOAT_CMP(_mm_cmpeq_pd);
+		break;
+	case EXPRS_TERM_NE:
+		SSE_FLOAT_CMP(_mm_cmpneq_pd);
+		break;
+	default:
+		return 0;
+	}
+	return last;
+}
+#endif	/* EXPRS_BATCH_SIMD */
+
+static void batchPickKernels(void)
+{
+	BatchKernels.isa = EXPRS_BATCH_ISA_SCALAR;
+	BatchKernels.intOp = NULL;
+	BatchKernels.floatOp = NULL;
+#if EXPRS_BATCH_SIMD
+	__builtin_cpu_init();
+	if ( BatchMaxIsa >= EXPRS_BATCH_ISA_AVX2 && __builtin_cpu_supports("avx2") )
+	{
+		BatchKernels.isa = EXPRS_BATCH_ISA_AVX2;
+		BatchKernels.intOp = batchIntAvx2;
+		BatchKernels.floatOp = batchFloatAvx2;
+	}
+	else if ( BatchMaxIsa >= EXPRS_BATCH_ISA_SSE42 && __builtin_cpu_supports("sse4.2") )
+	{
+		BatchKernels.isa = EXPRS_BATCH_ISA_SSE42;
+		BatchKernels.intOp = batchIntSse42;
+		BatchKernels.floatOp = batchFloatSse42;
+	}
+#endif
+}
+
+int libExprsSetBatchIsa(int maxIsa)
+{
+	pthread_once(&BatchKernelsOnce, batchPickKernels);
+	BatchMaxIsa = maxIsa;
+	batchPickKernels();
+	return BatchKernels.isa;
+}
+
+/* Integer operators. Arithmetic is done unsigned so it wraps the way the scalar code does on this hardware. */
+static void batchIntBinary(BatchParams_t *params, ExprsTermTypes_t op, BatchValue_t *av, const BatchValue_t *bv, int numRows)
+{
+	int ii, first = 0;
+
+	if ( BatchKernels.intOp )
+		first = BatchKernels.intOp(op, av, bv, numRows);
+	switch (op)
+	{
+	case EXPRS_TERM_ADD:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 = (unsigned long)av[ii].s64 + (unsigned long)bv[ii].s64;
+		break;
+	case EXPRS_TERM_SUB:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 = (unsigned long)av[ii].s64 - (unsigned long)bv[ii].s64;
+		break;
+	case EXPRS_TERM_MUL:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 = (unsigned long)av[ii].s64 * (unsigned long)bv[ii].s64;
+		break;
+	case EXPRS_TERM_DIV:
+	case EXPRS_TERM_MOD:
+		for ( ii = first; ii < numRows; ++ii )
+		{
+			if ( !bv[ii].s64 )
+			{
+				batchError(params, params->firstRow + ii, EXPR_TERM_BAD_DIV_BY_0);
+				av[ii].s64 = 0;
+			}
+			else if ( bv[ii].s64 == -1 )
+				av[ii].s64 = op == EXPRS_TERM_DIV ? -(unsigned long)av[ii].s64 : 0;	/* avoid trapping on LONG_MIN/-1 */
+			else if ( op == EXPRS_TERM_DIV )
+				av[ii].s64 /= bv[ii].s64;
+			else
+				av[ii].s64 %= bv[ii].s64;
+		}
+		break;
+#if !NO_FLOATING_POINT
+	case EXPRS_TERM_POW:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 = pow(av[ii].s64, bv[ii].s64);
+		break;
+#endif
+	case EXPRS_TERM_SHL:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 = (unsigned long)av[ii].s64 << (bv[ii].s64 & 63);
+		break;
+	case EXPRS_TERM_SHR:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 = av[ii].s64 >> (bv[ii].s64 & 63);
+		break;
+	case EXPRS_TERM_GT:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 = (long)((unsigned long)av[ii].s64 - (unsigned long)bv[ii].s64) > 0;
+		break;
+	case EXPRS_TERM_GE:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 = (long)((unsigned long)av[ii].s64 - (unsigned long)bv[ii].s64) >= 0;
+		break;
+	case EXPRS_TERM_LT:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 = (long)((unsigned long)av[ii].s64 - (unsigned long)bv[ii].s64) < 0;
+		break;
+	case EXPRS_TERM_LE:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 = (long)((unsigned long)av[ii].s64 - (unsigned long)bv[ii].s64) <= 0;
+		break;
+	case EXPRS_TERM_EQ:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 = av[ii].s64 == bv[ii].s64;
+		break;
+	case EXPRS_TERM_NE:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 = av[ii].s64 != bv[ii].s64;
+		break;
+	case EXPRS_TERM_AND:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 &= bv[ii].s64;
+		break;
+	case EXPRS_TERM_XOR:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 ^= bv[ii].s64;
+		break;
+	case EXPRS_TERM_OR:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 |= bv[ii].s64;
+		break;
+	case EXPRS_TERM_LAND:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 = (av[ii].s64 && bv[ii].s64) ? 1 : 0;
+		break;
+	case EXPRS_TERM_LOR:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].s64 = (av[ii].s64 || bv[ii].s64) ? 1 : 0;
+		break;
+	default:
+		break;
+	}
+}
+
+/* Float operators. Comparisons are done on the difference just like the scalar code does. */
+static void batchFloatBinary(BatchParams_t *params, ExprsTermTypes_t op, BatchValue_t *av, const BatchValue_t *bv, int numRows)
+{
+	int ii, first = 0;
+	double diff;
+
+	if ( BatchKernels.floatOp )
+		first = BatchKernels.floatOp(op, av, bv, numRows);
+	switch (op)
+	{
+	case EXPRS_TERM_ADD:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].f64 += bv[ii].f64;
+		break;
+	case EXPRS_TERM_SUB:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].f64 -= bv[ii].f64;
+		break;
+	case EXPRS_TERM_MUL:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].f64 *= bv[ii].f64;
+		break;
+	case EXPRS_TERM_DIV:
+	case EXPRS_TERM_MOD:
+		for ( ii = first; ii < numRows; ++ii )
+		{
+			if ( bv[ii].f64 == 0.0 )
+			{
+				batchError(params, params->firstRow + ii, EXPR_TERM_BAD_DIV_BY_0);
+				av[ii].f64 = 0.0;
+			}
+			else if ( op == EXPRS_TERM_DIV )
+				av[ii].f64 /= bv[ii].f64;
+#if !NO_FLOATING_POINT
+			else
+				av[ii].f64 = fmod(av[ii].f64, bv[ii].f64);
+#endif
+		}
+		break;
+#if !NO_FLOATING_POINT
+	case EXPRS_TERM_POW:
+		for ( ii = first; ii < numRows; ++ii )
+			av[ii].f64 = pow(av[ii].f64, bv[ii].f64);
+		break;
+#endif
+	case EXPRS_TERM_GT:
+		for ( ii = first; ii < numRows; ++ii )
+		{
+			diff = av[ii].f64 - bv[ii].f64;
+			av[ii].s64 = diff > 0;
+		}
+		break;
+	case EXPRS_TERM_GE:
+		for ( ii = first; ii < numRows; ++ii )
+		{
+			diff = av[ii].f64 - bv[ii].f64;
+			av[ii].s64 = diff >= 0;
+		}
+		break;
+	case EXPRS_TERM_LT:
+		for ( ii = first; ii < numRows; ++ii )
+		{
+			diff = av[ii].f64 - bv[ii].f64;
+			av[ii].s64 = diff < 0;
+		}
+		break;
+	case EXPRS_TERM_LE:
+		for ( ii = first; ii < numRows; ++ii )
+		{
+			diff = av[ii].f64 - bv[ii].f64;
+			av[ii].s64 = diff <= 0;
+		}
+		break;
+	case EXPRS_TERM_EQ:
+		for ( ii = first; ii < numRows; ++ii )
+		{
+			diff = av[ii].f64 - bv[ii].f64;
+			av[ii].s64 = diff == 0;
+		}
+		break;
+	case EXPRS_TERM_NE:
+		for ( ii = first; ii < numRows; ++ii )
+		{
+			diff = av[ii].f64 - bv[ii].f64;
+			av[ii].s64 = diff != 0;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void batchBinary(BatchParams_t *params, ExprsTermTypes_t op, BatchEntry_t *aa, BatchEntry_t *bb, int numRows)
+{
+	switch (op)
+	{
+	case EXPRS_TERM_ADD:
+	case EXPRS_TERM_SUB:
+	case EXPRS_TERM_MUL:
+	case EXPRS_TERM_DIV:
+	case EXPRS_TERM_MOD:
+	case EXPRS_TERM_POW:
+		if ( aa->mType == EXPRS_TERM_INTEGER && bb->mType == EXPRS_TERM_INTEGER )
+		{
+			batchIntBinary(params, op, aa->mVals, bb->mVals, numRows);
+			return;
+		}
+		batchToFloat(aa, numRows);
+		batchToFloat(bb, numRows);
+		batchFloatBinary(params, op, aa->mVals, bb->mVals, numRows);
+		return;
+	case EXPRS_TERM_GT:
+	case EXPRS_TERM_GE:
+	case EXPRS_TERM_LT:
+	case EXPRS_TERM_LE:
+	case EXPRS_TERM_EQ:
+	case EXPRS_TERM_NE:
+		if ( aa->mType == EXPRS_TERM_INTEGER && bb->mType == EXPRS_TERM_INTEGER )
+		{
+			batchIntBinary(params, op, aa->mVals, bb->mVals, numRows);
+			return;
+		}
+		batchToFloat(aa, numRows);
+		batchToFloat(bb, numRows);
+		batchFloatBinary(params, op, aa->mVals, bb->mVals, numRows);
+		aa->mType = EXPRS_TERM_INTEGER;
+		return;
+	default:
+		batchToInteger(aa, numRows);
+		batchToInteger(bb, numRows);
+		batchIntBinary(params, op, aa->mVals, bb->mVals, numRows);
+		return;
+	}
+}
+
+/* Compute numRows rows starting at params->firstRow leaving the answers at the bottom of the stack */
+static void batchBlock(BatchParams_t *params, int numRows)
+{
+	const ExprsProgram_t *program = params->program;
+	const ExprsTerm_t *term = program->mTerms;
+	const ExprsTermInfo_t *info = program->mInfo;
+	const ExprsColumn_t *col;
+	BatchEntry_t *ent;
+	int ii, jj, depth = 0;
+
+	for ( ii = 0; ii < program->mNumTerms; ++ii, ++term, ++info )
+	{
+		switch (term->termType)
+		{
+		case EXPRS_TERM_NULL:
+			continue;
+		case EXPRS_TERM_SYMBOL:
+			ent = params->stack + depth++;
+			col = params->columns + program->mSyms[info->mSym].mSlot;
+			ent->mType = (ExprsTermTypes_t)col->termType;
+			if ( ent->mType == EXPRS_TERM_FLOAT )
+			{
+				for ( jj = 0; jj < numRows; ++jj )
+					ent->mVals[jj].f64 = col->data.f64[params->firstRow + jj];
+			}
+			else
+			{
+				for ( jj = 0; jj < numRows; ++jj )
+					ent->mVals[jj].s64 = col->data.s64[params->firstRow + jj];
+			}
+			continue;
+		case EXPRS_TERM_INTEGER:
+		case EXPRS_TERM_FLOAT:
+			ent = params->stack + depth++;
+			ent->mType = term->termType;
+			for ( jj = 0; jj < numRows; ++jj )
+				ent->mVals[jj].s64 = term->term.s64;
+			continue;
+		case EXPRS_TERM_POS:
+		case EXPRS_TERM_NEG:
+		case EXPRS_TERM_COM:
+		case EXPRS_TERM_NOT:
+		case EXPRS_TERM_LOW_BYTE:
+		case EXPRS_TERM_HIGH_BYTE:
+		case EXPRS_TERM_SWAP:
+			batchUnary(term->termType, params->stack + depth - 1, numRows);
+			continue;
+		case EXPRS_TERM_SKIP_FALSE:
+		case EXPRS_TERM_SKIP_TRUE:
+			/* batchPlan() made sure computing the right side anyway is harmless */
+			continue;
+		default:
+			--depth;
+			batchBinary(params, term->termType, params->stack + depth - 1, params->stack + depth, numRows);
+			continue;
+		}
+	}
+}
+
+/* Run the program one row at a time for those that cannot be done a column at a time */
+static ExprsErrs_t batchByRows(ExprsDef_t *exprs, const ExprsProgram_t *program, int nRows, const ExprsColumn_t *columns, int numColumns, ExprsColumn_t *out)
+{
+	ExprsSymTerm_t lclSlots[16], *slots = lclSlots;
+	ExprsTerm_t result;
+	ExprsErrs_t err = EXPR_TERM_GOOD;
+	char eBuf[256];
+	int row, ii;
+
+	if ( numColumns > n_elts(lclSlots) )
+	{
+		slots = (ExprsSymTerm_t *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, numColumns * sizeof(ExprsSymTerm_t));
+		if ( !slots )
+			return EXPR_TERM_BAD_OUT_OF_MEMORY;
+	}
+	for ( row = 0; row < nRows; ++row )
+	{
+		for ( ii = 0; ii < numColumns; ++ii )
+		{
+			memset(slots + ii, 0, sizeof(ExprsSymTerm_t));
+			slots[ii].termType = columns[ii].termType;
+			if ( columns[ii].termType == EXPRS_SYM_TERM_FLOAT )
+				slots[ii].value.f64 = columns[ii].data.f64[row];
+			else
+				slots[ii].value.s64 = columns[ii].data.s64[row];
+		}
+		if ( (err = libExprsRunSlots(exprs, program, slots, numColumns, &result, 1)) )
+			break;
+		if ( result.termType != EXPRS_TERM_INTEGER && result.termType != EXPRS_TERM_FLOAT )
+			err = EXPR_TERM_BAD_UNSUPPORTED;
+		else if ( !row )
+			out->termType = (ExprsSymTermTypes_t)result.termType;
+		else if ( out->termType != (ExprsSymTermTypes_t)result.termType )
+			err = EXPR_TERM_BAD_UNSUPPORTED;
+		if ( err )
+		{
+			snprintf(eBuf, sizeof(eBuf), "libExprsEvalBatch(): Row %d result of type %d cannot be stored in a column of type %d\n",
+					 row, result.termType, out->termType);
+			showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
+			break;
+		}
+		if ( result.termType == EXPRS_TERM_FLOAT )
+			out->data.f64[row] = result.term.f64;
+		else
+			out->data.s64[row] = result.term.s64;
+	}
+	if ( err && err != EXPR_TERM_BAD_UNSUPPORTED )
+	{
+		snprintf(eBuf, sizeof(eBuf), "libExprsEvalBatch(): Row %d failed: %s\n", row, libExprsGetErrorStr(err));
+		showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
+	}
+	if ( slots != lclSlots )
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, slots);
+	return err;
+}
+
+ExprsErrs_t libExprsEvalBatch(ExprsDef_t *exprs, const ExprsProgram_t *program, int nRows, const ExprsColumn_t *columns, int numColumns, ExprsColumn_t *out, int alreadyLocked)
+{
+	ExprsErrs_t err = EXPR_TERM_GOOD, err2 = EXPR_TERM_GOOD;
+	BatchParams_t params;
+	BatchValue_t *vals;
+	char eBuf[256];
+	int ii, depth, numRows;
+
+	if ( !exprs || !program || !out || nRows < 0 || numColumns < 0 || (numColumns && !columns) )
+		return EXPR_TERM_BAD_PARAMETER;
+	for ( ii = 0; ii < numColumns; ++ii )
+	{
+		if ( columns[ii].termType != EXPRS_SYM_TERM_INTEGER && columns[ii].termType != EXPRS_SYM_TERM_FLOAT )
+			return EXPR_TERM_BAD_PARAMETER;
+	}
+	pthread_once(&BatchKernelsOnce, batchPickKernels);
+	if ( !alreadyLocked && (err2 = libExprsLock(exprs)) )
+		return err2;
+	if ( exprs->mVerbose || !batchPlan(program, columns, numColumns, &depth) )
+	{
+		if ( exprs->mVerbose )
+		{
+			snprintf(eBuf, sizeof(eBuf), "libExprsEvalBatch(): Computing %d rows one row at a time\n", nRows);
+			showMsg(exprs, EXPRS_SEVERITY_INFO, eBuf);
+		}
+		err = batchByRows(exprs, program, nRows, columns, numColumns, out);
+	}
+	else
+	{
+		params.exprs = exprs;
+		params.program = program;
+		params.columns = columns;
+		params.errRow = -1;
+		params.err = EXPR_TERM_GOOD;
+		params.stack = (BatchEntry_t *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, depth * (sizeof(BatchEntry_t) + BATCH_ROWS * sizeof(BatchValue_t)));
+		if ( !params.stack )
+			err = EXPR_TERM_BAD_OUT_OF_MEMORY;
+		else
+		{
+			vals = (BatchValue_t *)(params.stack + depth);
+			for ( ii = 0; ii < depth; ++ii )
+				params.stack[ii].mVals = vals + ii * BATCH_ROWS;
+			for ( params.firstRow = 0; params.firstRow < nRows; params.firstRow += numRows )
+			{
+				numRows = nRows - params.firstRow;
+				if ( numRows > BATCH_ROWS )
+					numRows = BATCH_ROWS;
+				batchBlock(&params, numRows);
+				if ( params.errRow >= 0 )
+					numRows = params.errRow - params.firstRow;	/* Keep only the rows before the failing one */
+				out->termType = (ExprsSymTermTypes_t)params.stack[0].mType;
+				if ( out->termType == EXPRS_SYM_TERM_FLOAT )
+				{
+					for ( ii = 0; ii < numRows; ++ii )
+						out->data.f64[params.firstRow + ii] = params.stack[0].mVals[ii].f64;
+				}
+				else
+				{
+					for ( ii = 0; ii < numRows; ++ii )
+						out->data.s64[params.firstRow + ii] = params.stack[0].mVals[ii].s64;
+				}
+				if ( params.errRow >= 0 )
+				{
+					err = params.err;
+					snprintf(eBuf, sizeof(eBuf), "libExprsEvalBatch(): Row %d failed: %s\n", params.errRow, libExprsGetErrorStr(err));
+					showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
+					break;
+				}
+			}
+			exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, params.stack);
+		}
+	}
+	if ( !alreadyLocked )
+		err2 = libExprsUnlock(exprs);
+	return err ? err : err2;
+}
+
+void libExprsFreeProgram(ExprsProgram_t *program)
+{
+	if ( program )
+	{
+#if EXPRS_JIT
+		if ( program->mJitCode )
+			munmap(program->mJitCode, program->mJitSize);
+#endif
+		program->memFree(program->memArg, program);
+	}
+}
+
+/* One compiled program in the cache */
+typedef struct
+{
+	ExprsProgram_t *mProgram;
+	uint32_t mHash;					/* hash of the normalized text, flags, radix and delimiters */
+	char mOpenDelimiter;			/* delimiters in effect when compiled */
+	char mCloseDelimiter;
+	int mHashNext;					/* next entry in same hash bucket (-1 if none) */
+	int mLruPrev;					/* next more recently used entry (-1 if none) */
+	int mLruNext;					/* next less recently used entry (-1 if none) */
+} ExprsCacheEntry_t;
+
+typedef struct ExprsProgCache_t ExprsProgCache_t;
+
+struct ExprsProgCache_t
+{
+	int mMaxEntries;
+	int mNumEntries;
+	int mHashMask;					/* number of hash buckets - 1 */
+	int *mBuckets;					/* index of first entry in each bucket (-1 if none) */
+	ExprsCacheEntry_t *mEntries;
+	int mLruHead;					/* most recently used entry */
+	int mLruTail;					/* least recently used entry */
+	char *mNormText;				/* text being looked up with the white space squeezed out */
+	int *mNormOffsets;				/* offset into the original text of each char in mNormText */
+	size_t mNormSize;				/* number of chars mNormText can hold */
+	unsigned long mHits;
+	unsigned long mMisses;
+	unsigned long mEvictions;
+};
+
+static void cacheFree(ExprsDef_t *exprs)
+{
+	ExprsProgCache_t *cache = exprs->mProgCache;
+	int ii;
+
+	if ( !cache )
+		return;
+	for ( ii = 0; ii < cache->mNumEntries; ++ii )
+		libExprsFreeProgram(cache->mEntries[ii].mProgram);
+	if ( cache->mNormText )
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, cache->mNormText);
+	if ( cache->mNormOffsets )
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, cache->mNormOffsets);
+	exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, cache);
+	exprs->mProgCache = NULL;
+}
+
+ExprsErrs_t libExprsSetCacheSize(ExprsDef_t *exprs, int maxEntries, int alreadyLocked)
+{
+	ExprsErrs_t err2 = EXPR_TERM_GOOD;
+	ExprsProgCache_t *cache;
+	int ii, numBuckets;
+	size_t totSize;
+
+	if ( !exprs || maxEntries < 0 )
+		return EXPR_TERM_BAD_PARAMETER;
+	if ( !alreadyLocked && (err2 = libExprsLock(exprs)) )
+		return err2;
+	cacheFree(exprs);
+	if ( maxEntries )
+	{
+		for ( numBuckets = 16; numBuckets < maxEntries * 2; numBuckets *= 2 )
+			;
+		totSize = sizeof(ExprsProgCache_t) + maxEntries * sizeof(ExprsCacheEntry_t) + numBuckets * sizeof(int);
+		cache = (ExprsProgCache_t *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, totSize);
+		if ( !cache )
+		{
+			char eBuf[128];
+			snprintf(eBuf, sizeof(eBuf), "libExprsSetCacheSize(): Failed to allocate " FMT_SZ " bytes for cache: %s\n", totSize, strerror(errno));
+			showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
+			err2 = EXPR_TERM_BAD_OUT_OF_MEMORY;
+		}
+		else
+		{
+			memset(cache, 0, sizeof(ExprsProgCache_t));
+			cache->mMaxEntries = maxEntries;
+			cache->mHashMask = numBuckets - 1;
+			cache->mEntries = (ExprsCacheEntry_t *)(cache + 1);
+			cache->mBuckets = (int *)(cache->mEntries + maxEntries);
+			for ( ii = 0; ii < numBuckets; ++ii )
+				cache->mBuckets[ii] = -1;
+			cache->mLruHead = cache->mLruTail = -1;
+			exprs->mProgCache = cache;
+		}
+	}
+	if ( !alreadyLocked )
+	{
+		ExprsErrs_t err = libExprsUnlock(exprs);
+		if ( !err2 )
+			err2 = err;
+	}
+	return err2;
+}
+
+ExprsErrs_t libExprsGetCacheStats(ExprsDef_t *exprs, ExprsCacheStats_t *stats, int alreadyLocked)
+{
+	ExprsErrs_t err2 = EXPR_TERM_GOOD;
+	const ExprsProgCache_t *cache;
+
+	if ( !exprs || !stats )
+		return EXPR_TERM_BAD_PARAMETER;
+	if ( !alreadyLocked && (err2 = libExprsLock(exprs)) )
+		return err2;
+	memset(stats, 0, sizeof(ExprsCacheStats_t));
+	if ( (cache = exprs->mProgCache) )
+	{
+		stats->hits = cache->mHits;
+		stats->misses = cache->mMisses;
+		stats->evictions = cache->mEvictions;
+		stats->numEntries = cache->mNumEntries;
+		stats->maxEntries = cache->mMaxEntries;
+	}
+	if ( !alreadyLocked )
+		err2 = libExprsUnlock(exprs);
+	return err2;
+}
+
+/* Operators and punctuation. White space between one of these and anything else can't matter. */
+static bool cacheIsOper(char cc)
+{
+	return cc && strchr("()+-*/%<>=!&|^~,;", cc) != NULL;
+}
+
+/* True for a char that could be part of a number or symbol name and so go on into a following sign */
+static bool cacheIsWord(char cc)
+{
+	return isalnum((unsigned char)cc) || cc == '.' || cc == '_' || cc == '$';
+}
+
+/** cacheNormalize - copy a text into the cache's mNormText
+ *  squeezing out white space that can't change its meaning.
+ *
+ *  At entry:
+ *  @param exprs - pointer to ExprsDef_t with a cache
+ *  @param text - text to normalize
+ *  @param textLen - length of text
+ *
+ *  At exit:
+ *  @return 0 on success, else no memory or the text holds a
+ *  		null. mNormOffsets holds
+ *  		where in 'text' each char of mNormText came from
+ *  		(plus one more entry for the terminating nul).
+ *
+ *  @note A run of spaces and tabs becomes one space and it is
+ *  	  dropped altogether between an operator and something
+ *  	  that isn't one unless it comes after a number or name
+ *  	  and before a '+' or '-' (which could be taken as part
+ *  	  of an exponent). Everything from the first quote on is
+ *  	  copied as is and nothing is squeezed if white space
+ *  	  delimits terms.
+ **/
+static int cacheNormalize(ExprsDef_t *exprs, const char *text, size_t textLen)
+{
+	ExprsProgCache_t *cache = exprs->mProgCache;
+	size_t ii, nn;
+	bool asIs = (exprs->mFlags & EXPRS_FLG_WS_DELIMIT) != 0;
+	char cc;
+
+	if ( textLen + 1 > cache->mNormSize )
+	{
+		if ( cache->mNormText )
+			exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, cache->mNormText);
+		if ( cache->mNormOffsets )
+			exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, cache->mNormOffsets);
+		cache->mNormSize = textLen + 1 < 256 ? 256 : textLen + 1;
+		cache->mNormText = (char *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, cache->mNormSize);
+		cache->mNormOffsets = (int *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, cache->mNormSize * sizeof(int));
+		if ( !cache->mNormText || !cache->mNormOffsets )
+		{
+			if ( cache->mNormText )
+				exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, cache->mNormText);
+			if ( cache->mNormOffsets )
+				exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, cache->mNormOffsets);
+			cache->mNormText = NULL;
+			cache->mNormOffsets = NULL;
+			cache->mNormSize = 0;
+			return -1;
+		}
+	}
+	for ( ii = nn = 0; ii < textLen; )
+	{
+		cc = text[ii];
+		/* Programs are looked up by their text as a string so a span holding a null can't be cached */
+		if ( !cc )
+			return -1;
+		if ( !asIs && (cc == ' ' || cc == '\t') )
+		{
+			cache->mNormOffsets[nn] = ii;
+			while ( ii < textLen && (text[ii] == ' ' || text[ii] == '\t') )
+				++ii;
+			/* Leading and trailing white space is kept since it might end a term or statement. So is a space
+			 * between something that could go on as a number or name and a sign ("1.5e +2" is not "1.5e+2") */
+			if (    !nn || ii >= textLen
+				 || cacheIsOper(cache->mNormText[nn - 1]) == cacheIsOper(text[ii])
+				 || (cacheIsWord(cache->mNormText[nn - 1]) && (text[ii] == '+' || text[ii] == '-')) )
+				cache->mNormText[nn++] = ' ';
+			continue;
+		}
+		if ( cc == '"' || cc == '\'' || cc == '`' )
+			asIs = true;
+		cache->mNormOffsets[nn] = ii++;
+		cache->mNormText[nn++] = cc;
+	}
+	cache->mNormOffsets[nn] = textLen;
+	cache->mNormText[nn] = 0;
+	return 0;
+}
+
+/* Turn a pointer into a cached program's text into one into the text given libExprsEval() */
+static const char* cacheMapPtr(const ExprsProgCache_t *cache, const ExprsProgram_t *prog, const char *ptr, const char *text)
+{
+	if ( !ptr || ptr < prog->mText || ptr > prog->mText + strlen(prog->mText) )
+		return ptr;
+	return text + cache->mNormOffsets[ptr - prog->mText];
+}
+
+static void cacheUnlink(ExprsProgCache_t *cache, int idx)
+{
+	ExprsCacheEntry_t *ent = cache->mEntries + idx;
+
+	if ( ent->mLruPrev >= 0 )
+		cache->mEntries[ent->mLruPrev].mLruNext = ent->mLruNext;
+	else
+		cache->mLruHead = ent->mLruNext;
+	if ( ent->mLruNext >= 0 )
+		cache->mEntries[ent->mLruNext].mLruPrev = ent->mLruPrev;
+	else
+		cache->mLruTail = ent->mLruPrev;
+}
+
+static void cacheLinkHead(ExprsProgCache_t *cache, int idx)
+{
+	ExprsCacheEntry_t *ent = cache->mEntries + idx;
+
+	ent->mLruPrev = -1;
+	ent->mLruNext = cache->mLruHead;
+	if ( cache->mLruHead >= 0 )
+		cache->mEntries[cache->mLruHead].mLruPrev = idx;
+	else
+		cache->mLruTail = idx;
+	cache->mLruHead = idx;
+}
+
+/* Drop the least recently used program and return its entry for re-use */
+static int cacheEvict(ExprsProgCache_t *cache)
+{
+	int idx = cache->mLruTail, *linkP;
+	ExprsCacheEntry_t *ent = cache->mEntries + idx;
+
+	for ( linkP = cache->mBuckets + (ent->mHash & cache->mHashMask); *linkP != idx; linkP = &cache->mEntries[*linkP].mHashNext )
+		;
+	*linkP = ent->mHashNext;
+	cacheUnlink(cache, idx);
+	libExprsFreeProgram(ent->mProgram);
+	ent->mProgram = NULL;
+	++cache->mEvictions;
+	return idx;
+}
+
+/** evalCached - run a text with libExprsEval() by way of the
+ *  program cache.
+ *
+ *  At entry:
+ *  @param exprs - pointer to ExprsDef_t with a cache and
+ *  			 setup() done
+ *  @param text - text to evaluate
+ *  @param textLen - length of text
+ *  @param returnTerm - pointer to place to deposit result
+ *  @param errP - pointer to place to deposit error code
+ *
+ *  At exit:
+ *  @return non-zero if the text has been run. 0 if it has to be
+ *  		parsed and run the normal way (parse error or no
+ *  		memory) in which case nothing has been run.
+ **/
+static int evalCached(ExprsDef_t *exprs, const char *text, size_t textLen, ExprsTerm_t *returnTerm, ExprsErrs_t *errP)
+{
+	ExprsProgCache_t *cache = exprs->mProgCache;
+	ExprsCacheEntry_t *ent;
+	ExprsProgram_t *prog;
+	ExprsErrs_t err;
+	void (*saveMsgOut)(void *msgArg, ExprsMsgSeverity_t severity, const char *msg);
+	uint32_t hash = 2166136261u;
+	const unsigned char *cp;
+	int idx;
+
+	if ( cacheNormalize(exprs, text, textLen) )
+		return 0;
+	/* FNV-1a of the text followed by everything else that changes how it parses */
+	for ( cp = (const unsigned char *)cache->mNormText; *cp; ++cp )
+		hash = (hash ^ *cp) * 16777619u;
+	hash = (hash ^ (uint32_t)exprs->mFlags) * 16777619u;
+	hash = (hash ^ (uint32_t)exprs->mRadix) * 16777619u;
+	hash = (hash ^ (unsigned char)exprs->mOpenDelimiter) * 16777619u;
+	hash = (hash ^ (unsigned char)exprs->mCloseDelimiter) * 16777619u;
+	for ( idx = cache->mBuckets[hash & cache->mHashMask]; idx >= 0; idx = ent->mHashNext )
+	{
+		ent = cache->mEntries + idx;
+		prog = ent->mProgram;
+		if (    ent->mHash == hash
+			 && prog->mFlags == exprs->mFlags
+			 && prog->mRadix == exprs->mRadix
+			 && ent->mOpenDelimiter == exprs->mOpenDelimiter
+			 && ent->mCloseDelimiter == exprs->mCloseDelimiter
+			 && !strcmp(prog->mText, cache->mNormText) )
+			break;
+	}
+	if ( idx >= 0 )
+	{
+		++cache->mHits;
+		cacheUnlink(cache, idx);
+	}
+	else
+	{
+		++cache->mMisses;
+		/* Errors are left for the normal parse to report just as they would be without a cache */
+		saveMsgOut = exprs->mCallbacks.msgOut;
+		exprs->mCallbacks.msgOut = quietMsgOut;
+		err = libExprsCompile(exprs, cache->mNormText, &prog, 1);
+		exprs->mCallbacks.msgOut = saveMsgOut;
+		exprs->mEndPtr = text + textLen;
+		if ( err )
+		{
+			exprs->mLineHead = exprs->mCurrPtr = text;
+			return 0;
+		}
+		idx = cache->mNumEntries < cache->mMaxEntries ? cache->mNumEntries++ : cacheEvict(cache);
+		ent = cache->mEntries + idx;
+		ent->mProgram = prog;
+		ent->mHash = hash;
+		ent->mOpenDelimiter = exprs->mOpenDelimiter;
+		ent->mCloseDelimiter = exprs->mCloseDelimiter;
+		ent->mHashNext = cache->mBuckets[hash & cache->mHashMask];
+		cache->mBuckets[hash & cache->mHashMask] = idx;
+	}
+	cacheLinkHead(cache, idx);
+	prog = cache->mEntries[idx].mProgram;
+	*errP = runProgram(exprs, prog, NULL, returnTerm);
+	/* Make it look like the caller's text was parsed */
+	returnTerm->chrPtr = cacheMapPtr(cache, prog, returnTerm->chrPtr, text);
+	exprs->mCurrPtr = cacheMapPtr(cache, prog, exprs->mCurrPtr, text);
+	exprs->mLineHead = text;
+	return 1;
+}
+
+/* One symbol named by any of the formulas in an ExprsDeps_t */
+typedef struct
+{
+	char *mName;
+	int *mReaders;					/* formulas that read this symbol */
+	int mNumReaders;
+	int mMaxReaders;
+	int *mWriters;					/* formulas that assign this symbol */
+	int mNumWriters;
+	int mMaxWriters;
+	int mHashNext;					/* next symbol in same hash bucket (-1 if none) */
+	unsigned int mMark;				/* stamp used while looking for cycles */
+} ExprsDepSym_t;
+
+/* One formula in an ExprsDeps_t */
+typedef struct
+{
+	ExprsProgram_t *mProgram;
+	int *mInputs;					/* symbols read followed by ... */
+	int *mOutputs;					/* ... symbols assigned (in the same allocation) */
+	int mNumInputs;
+	int mNumOutputs;
+	int mRank;						/* position in dependency order */
+	bool mDirty;					/* needs to be run */
+	bool mBlocked;					/* an upstream formula failed in this update so not run */
+} ExprsDepFormula_t;
+
+struct ExprsDeps_t
+{
+	ExprsDef_t *mExprs;
+	ExprsDepSym_t *mSyms;
+	int mNumSyms;
+	int mMaxSyms;
+	int *mBuckets;					/* index of first symbol in each bucket (-1 if none) */
+	int mHashMask;					/* number of buckets - 1 */
+	ExprsDepFormula_t *mFormulas;
+	int mNumFormulas;
+	int mMaxFormulas;
+	int *mWork;						/* scratch used for searches, sorting and the run queue */
+	int mMaxWork;
+	bool mRanked;					/* mRank of every formula is current */
+	unsigned int mStamp;			/* last stamp handed out */
+};
+
+#define DEPS_INIT_BUCKETS (64)
+
+ExprsErrs_t libExprsDepsCreate(ExprsDef_t *exprs, ExprsDeps_t **depsP)
+{
+	ExprsDeps_t *deps;
+	size_t totSize;
+	int ii;
+
+	if ( !exprs || !depsP )
+		return EXPR_TERM_BAD_PARAMETER;
+	totSize = sizeof(ExprsDeps_t) + DEPS_INIT_BUCKETS * sizeof(int);
+	deps = (ExprsDeps_t *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, totSize);
+	if ( !deps )
+	{
+		char eBuf[128];
+		snprintf(eBuf, sizeof(eBuf), "libExprsDepsCreate(): Failed to allocate " FMT_SZ " bytes: %s\n", totSize, strerror(errno));
+		showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
+		return EXPR_TERM_BAD_OUT_OF_MEMORY;
+	}
+	memset(deps, 0, sizeof(ExprsDeps_t));
+	deps->mExprs = exprs;
+	deps->mBuckets = (int *)(deps + 1);
+	deps->mHashMask = DEPS_INIT_BUCKETS - 1;
+	for ( ii = 0; ii < DEPS_INIT_BUCKETS; ++ii )
+		deps->mBuckets[ii] = -1;
+	deps->mRanked = true;
+	*depsP = deps;
+	return EXPR_TERM_GOOD;
+}
+
+static unsigned int depsHash(const char *name)
+{
+	unsigned int hash;
+
+	for ( hash = 5381; *name; ++name )
+		hash = hash * 33 + (unsigned char)*name;
+	return hash;
+}
+
+/** depsFindSym - look up a symbol by name.
+ *
+ *  At entry:
+ *  @param deps - pointer to set of formulas
+ *  @param name - name of symbol
+ *  @param create - true to add the symbol if not found
+ *
+ *  At exit:
+ *  @return index into mSyms or -1 if not found (or no memory
+ *  		to add it).
+ **/
+static int depsFindSym(ExprsDeps_t *deps, const char *name, bool create)
+{
+	ExprsDef_t *exprs = deps->mExprs;
+	ExprsDepSym_t *sym;
+	unsigned int hash = depsHash(name);
+	int idx, ii, *buckets;
+	size_t len;
+
+	for ( idx = deps->mBuckets[hash & deps->mHashMask]; idx >= 0; idx = deps->mSyms[idx].mHashNext )
+	{
+		if ( !strcmp(deps->mSyms[idx].mName, name) )
+			return idx;
+	}
+	if ( !create )
+		return -1;
+	if ( !(sym = (ExprsDepSym_t *)growList(exprs, deps->mSyms, sizeof(ExprsDepSym_t), deps->mNumSyms, &deps->mMaxSyms, 1)) )
+		return -1;
+	deps->mSyms = sym;
+	/* Keep the chains short by having at least as many buckets as symbols */
+	if ( deps->mNumSyms > deps->mHashMask )
+	{
+		int numBuckets = (deps->mHashMask + 1) * 2;
+
+		if ( !(buckets = (int *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, numBuckets * sizeof(int))) )
+			return -1;
+		for ( ii = 0; ii < numBuckets; ++ii )
+			buckets[ii] = -1;
+		for ( ii = 0; ii < deps->mNumSyms; ++ii )
+		{
+			unsigned int hh = depsHash(deps->mSyms[ii].mName) & (numBuckets - 1);
+			deps->mSyms[ii].mHashNext = buckets[hh];
+			buckets[hh] = ii;
+		}
+		if ( deps->mBuckets != (int *)(deps + 1) )
+			exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, deps->mBuckets);
+		deps->mBuckets = buckets;
+		deps->mHashMask = numBuckets - 1;
+	}
+	len = strlen(name) + 1;
+	sym = deps->mSyms + deps->mNumSyms;
+	memset(sym, 0, sizeof(ExprsDepSym_t));
+	if ( !(sym->mName = (char *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, len)) )
+		return -1;
+	memcpy(sym->mName, name, len);
+	idx = deps->mNumSyms++;
+	sym->mHashNext = deps->mBuckets[hash & deps->mHashMask];
+	deps->mBuckets[hash & deps->mHashMask] = idx;
+	return idx;
+}
+
+/** depsFindCycle - see if a would be formula closes a loop.
+ *
+ *  At entry:
+ *  @param deps - pointer to set of formulas with mWork holding
+ *  			at least one int per symbol
+ *  @param inputs - symbols the new formula reads
+ *  @param numIn - number of inputs
+ *  @param outputs - symbols the new formula assigns
+ *  @param numOut - number of outputs
+ *
+ *  At exit:
+ *  @return index of the input that depends on one of the
+ *  		outputs or -1 if none does.
+ **/
+static int depsFindCycle(ExprsDeps_t *deps, const int *inputs, int numIn, const int *outputs, int numOut)
+{
+	ExprsDepSym_t *syms = deps->mSyms;
+	const ExprsDepFormula_t *form;
+	unsigned int inMark, seenMark;
+	int ii, jj, sym, out, numWork = 0;
+
+	inMark = ++deps->mStamp;
+	seenMark = ++deps->mStamp;
+	for ( ii = 0; ii < numOut; ++ii )
+	{
+		syms[outputs[ii]].mMark = seenMark;
+		deps->mWork[numWork++] = outputs[ii];
+	}
+	/* Marked after the outputs so one the formula both reads and assigns is a cycle if reached again */
+	for ( ii = 0; ii < numIn; ++ii )
+		syms[inputs[ii]].mMark = inMark;
+	/* Follow everything computed from the outputs. Each symbol is only looked at once. */
+	while ( numWork )
+	{
+		sym = deps->mWork[--numWork];
+		for ( ii = 0; ii < syms[sym].mNumReaders; ++ii )
+		{
+			form = deps->mFormulas + syms[sym].mReaders[ii];
+			for ( jj = 0; jj < form->mNumOutputs; ++jj )
+			{
+				out = form->mOutputs[jj];
+				if ( syms[out].mMark == inMark )
+					return out;
+				if ( syms[out].mMark != seenMark )
+				{
+					syms[out].mMark = seenMark;
+					deps->mWork[numWork++] = out;
+				}
+			}
+		}
+	}
+	return -1;
+}
+
+/** depsRank - number the formulas in dependency order.
+ *
+ *  At entry:
+ *  @param deps - pointer to set of formulas with mWork holding
+ *  			at least two ints per formula
+ *
+ *  At exit:
+ *  @return 0 on success, else there is a cycle (which
+ *  		libExprsDepsAdd() should have prevented).
+ **/
+static int depsRank(ExprsDeps_t *deps)
+{
+	const ExprsDepFormula_t *form;
+	const ExprsDepSym_t *sym;
+	int *inDegree = deps->mWork, *queue = deps->mWork + deps->mNumFormulas;
+	int ii, jj, kk, head, tail = 0;
+
+	/* Kahn's algorithm. A formula is ready once every other formula assigning one of its inputs has been numbered. */
+	for ( ii = 0, form = deps->mFormulas; ii < deps->mNumFormulas; ++ii, ++form )
+	{
+		inDegree[ii] = 0;
+		for ( jj = 0; jj < form->mNumInputs; ++jj )
+		{
+			sym = deps->mSyms + form->mInputs[jj];
+			for ( kk = 0; kk < sym->mNumWriters; ++kk )
+				inDegree[ii] += sym->mWriters[kk] != ii;
+		}
+		if ( !inDegree[ii] )
+			queue[tail++] = ii;
+	}
+	for ( head = 0; head < tail; ++head )
+	{
+		form = deps->mFormulas + queue[head];
+		deps->mFormulas[queue[head]].mRank = head;
+		for ( jj = 0; jj < form->mNumOutputs; ++jj )
+		{
+			sym = deps->mSyms + form->mOutputs[jj];
+			for ( kk = 0; kk < sym->mNumReaders; ++kk )
+			{
+				if ( sym->mReaders[kk] != queue[head] && !--inDegree[sym->mReaders[kk]] )
+					queue[tail++] = sym->mReaders[kk];
+			}
+		}
+	}
+	deps->mRanked = (tail == deps->mNumFormulas);
+	return deps->mRanked ? 0 : -1;
+}
+
+/** depsLink - record which symbols a compiled formula reads
+ *  and assigns and add it to the set.
+ *
+ *  At entry:
+ *  @param deps - pointer to set of formulas
+ *  @param prog - compiled formula
+ *  @param formulaP - pointer to place to deposit the index of
+ *  				the formula. May be NULL.
+ *
+ *  At exit:
+ *  @return 0 on success, else error. The program belongs to
+ *  		the set on success and is untouched otherwise.
+ **/
+static ExprsErrs_t depsLink(ExprsDeps_t *deps, ExprsProgram_t *prog, int *formulaP)
+{
+	ExprsDef_t *exprs = deps->mExprs;
+	ExprsDepFormula_t *form;
+	ExprsDepSym_t *sym;
+	unsigned char *use;
+	int ii, numIn = 0, numOut = 0, numWork, *list, *inputs, *outputs, cycle;
+	void *newList;
+	char eBuf[128];
+
+	/* Bit 0 set if a symbol is read before it is assigned, bit 1 if it is assigned */
+	use = (unsigned char *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, prog->mNumSyms + 1);
+	list = (int *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, (2 * prog->mNumSyms + 1) * sizeof(int));
+	if ( !use || !list )
+		goto noMem;
+	memset(use, 0, prog->mNumSyms);
+	for ( ii = 0; ii < prog->mNumStmts; ++ii )
+	{
+		const ExprsStatement_t *stmt = prog->mStmts + ii;
+		const ExprsTermInfo_t *info = prog->mInfo + stmt->mFirstTerm;
+		int jj;
+
+		/* An assignment is taken to land at the end of its statement so a read in the
+		 * same statement (i.e. "n=n+1") is always of the value from before it */
+		for ( jj = 0; jj < stmt->mNumTerms; ++jj )
+		{
+			if ( info[jj].mSym >= 0 && !info[jj].mLvalue && !(use[info[jj].mSym] & 2) )
+				use[info[jj].mSym] |= 1;
+		}
+		for ( jj = 0; jj < stmt->mNumTerms; ++jj )
+		{
+			if ( info[jj].mSym >= 0 && info[jj].mLvalue )
+				use[info[jj].mSym] |= 2;
+		}
+	}
+	for ( ii = 0; ii < prog->mNumSyms; ++ii )
+		numIn += (use[ii] & 1) != 0;
+	inputs = list;
+	outputs = list + numIn;
+	for ( ii = 0; ii < prog->mNumSyms; ++ii )
+	{
+		int idx;
+
+		if ( !use[ii] )
+			continue;
+		if ( (idx = depsFindSym(deps, prog->mStrings + prog->mSyms[ii].mName, true)) < 0 )
+			goto noMem;
+		if ( use[ii] & 1 )
+			*inputs++ = idx;
+		if ( use[ii] & 2 )
+			outputs[numOut++] = idx;
+	}
+	inputs = list;
+	exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, use);
+	use = NULL;
+	/* Room for everything done later so nothing can fail once the formula is partly linked */
+	numWork = deps->mNumSyms > 2 * (deps->mNumFormulas + 1) ? deps->mNumSyms : 2 * (deps->mNumFormulas + 1);
+	if ( numWork > deps->mMaxWork )
+	{
+		if ( !(newList = growList(exprs, deps->mWork, sizeof(int), 0, &deps->mMaxWork, numWork)) )
+			goto noMem;
+		deps->mWork = (int *)newList;
+	}
+	if ( !(newList = growList(exprs, deps->mFormulas, sizeof(ExprsDepFormula_t), deps->mNumFormulas, &deps->mMaxFormulas, 1)) )
+		goto noMem;
+	deps->mFormulas = (ExprsDepFormula_t *)newList;
+	for ( ii = 0; ii < numIn + numOut; ++ii )
+	{
+		sym = deps->mSyms + list[ii];
+		if ( ii < numIn )
+		{
+			if ( !(newList = growList(exprs, sym->mReaders, sizeof(int), sym->mNumReaders, &sym->mMaxReaders, 1)) )
+				goto noMem;
+			sym->mReaders = (int *)newList;
+		}
+		else
+		{
+			if ( !(newList = growList(exprs, sym->mWriters, sizeof(int), sym->mNumWriters, &sym->mMaxWriters, 1)) )
+				goto noMem;
+			sym->mWriters = (int *)newList;
+		}
+	}
+	if ( (cycle = depsFindCycle(deps, inputs, numIn, outputs, numOut)) >= 0 )
+	{
+		snprintf(eBuf, sizeof(eBuf), "libExprsDepsAdd(): '%.40s' would be computed from itself\n", deps->mSyms[cycle].mName);
+		showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, list);
+		return EXPR_TERM_BAD_CYCLE;
+	}
+	form = deps->mFormulas + deps->mNumFormulas;
+	form->mProgram = prog;
+	form->mInputs = list;
+	form->mOutputs = list + numIn;
+	form->mNumInputs = numIn;
+	form->mNumOutputs = numOut;
+	form->mRank = 0;
+	form->mDirty = true;
+	form->mBlocked = false;
+	for ( ii = 0; ii < numIn; ++ii )
+	{
+		sym = deps->mSyms + inputs[ii];
+		sym->mReaders[sym->mNumReaders++] = deps->mNumFormulas;
+	}
+	for ( ii = 0; ii < numOut; ++ii )
+	{
+		sym = deps->mSyms + outputs[ii];
+		sym->mWriters[sym->mNumWriters++] = deps->mNumFormulas;
+	}
+	if ( formulaP )
+		*formulaP = deps->mNumFormulas;
+	++deps->mNumFormulas;
+	deps->mRanked = false;
+	return EXPR_TERM_GOOD;
+
+noMem:
+	if ( use )
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, use);
+	if ( list )
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, list);
+	snprintf(eBuf, sizeof(eBuf), "libExprsDepsAdd(): Ran out of memory: %s\n", strerror(errno));
+	showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
+	return EXPR_TERM_BAD_OUT_OF_MEMORY;
+}
+
+ExprsErrs_t libExprsDepsAdd(ExprsDeps_t *deps, const char *text, int *formulaP, int alreadyLocked)
+{
+	ExprsDef_t *exprs;
+	ExprsProgram_t *prog = NULL;
+	ExprsErrs_t err, err2;
+
+	if ( !deps || !text )
+		return EXPR_TERM_BAD_PARAMETER;
+	exprs = deps->mExprs;
+	if ( !alreadyLocked && (err2 = libExprsLock(exprs)) )
+		return err2;
+	err = libExprsCompile(exprs, text, &prog, 1);
+	if ( !err && (err = depsLink(deps, prog, formulaP)) )
+		libExprsFreeProgram(prog);
+	if ( !alreadyLocked && (err2 = libExprsUnlock(exprs)) && !err )
+		err = err2;
+	return err;
+}
+
+ExprsErrs_t libExprsDepsChanged(ExprsDeps_t *deps, const char *symName, int alreadyLocked)
+{
+	const ExprsDepSym_t *sym;
+	ExprsErrs_t err2;
+	int ii, idx;
+
+	if ( !deps || !symName )
+		return EXPR_TERM_BAD_PARAMETER;
+	if ( !alreadyLocked && (err2 = libExprsLock(deps->mExprs)) )
+		return err2;
+	if ( (idx = depsFindSym(deps, symName, false)) >= 0 )
+	{
+		sym = deps->mSyms + idx;
+		for ( ii = 0; ii < sym->mNumReaders; ++ii )
+			deps->mFormulas[sym->mReaders[ii]].mDirty = true;
+	}
+	if ( !alreadyLocked )
+		return libExprsUnlock(deps->mExprs);
+	return EXPR_TERM_GOOD;
+}
+
+/* The formulas waiting to run are kept in a heap ordered by rank in mWork */
+static void depsPush(ExprsDeps_t *deps, int numHeap, int formula)
+{
+	int *heap = deps->mWork, ii = numHeap, parent, rank = deps->mFormulas[formula].mRank;
+
+	while ( ii > 0 && deps->mFormulas[heap[parent = (ii - 1) / 2]].mRank > rank )
+	{
+		heap[ii] = heap[parent];
+		ii = parent;
+	}
+	heap[ii] = formula;
+}
+
+static int depsPop(ExprsDeps_t *deps, int numHeap)
+{
+	int *heap = deps->mWork, ans = heap[0], last = heap[numHeap - 1], ii = 0, child, rank;
+
+	--numHeap;
+	rank = deps->mFormulas[last].mRank;
+	while ( (child = 2 * ii + 1) < numHeap )
+	{
+		if ( child + 1 < numHeap && deps->mFormulas[heap[child + 1]].mRank < deps->mFormulas[heap[child]].mRank )
+			++child;
+		if ( deps->mFormulas[heap[child]].mRank >= rank )
+			break;
+		heap[ii] = heap[child];
+		ii = child;
+	}
+	heap[ii] = last;
+	return ans;
+}
+
+ExprsErrs_t libExprsDepsUpdate(ExprsDeps_t *deps, int *numRunP, int alreadyLocked)
+{
+	ExprsDef_t *exprs;
+	ExprsDepFormula_t *form;
+	const ExprsDepSym_t *sym;
+	ExprsTerm_t result;
+	ExprsErrs_t err = EXPR_TERM_GOOD, err2;
+	int ii, jj, idx, numHeap = 0, numRun = 0;
+
+	if ( !deps )
+		return EXPR_TERM_BAD_PARAMETER;
+	exprs = deps->mExprs;
+	if ( !alreadyLocked && (err2 = libExprsLock(exprs)) )
+		return err2;
+	if ( !deps->mRanked && depsRank(deps) )
+		err = EXPR_TERM_BAD_CYCLE;
+	for ( ii = 0; ii < deps->mNumFormulas && !err; ++ii )
+	{
+		if ( deps->mFormulas[ii].mDirty )
+			depsPush(deps, numHeap++, ii);
+	}
+	/* Whatever a formula feeds has a higher rank so is always still to come */
+	while ( numHeap )
+	{
+		idx = depsPop(deps, numHeap--);
+		form = deps->mFormulas + idx;
+		if ( !form->mBlocked && (err2 = libExprsRun(exprs, form->mProgram, &result, 1)) )
+		{
+			if ( !err )
+				err = err2;
+			form->mBlocked = true;
+		}
+		if ( form->mBlocked )
+		{
+			/* Leave it dirty and pass the block on so its readers wait for it rather than run on stale inputs */
+			form->mBlocked = false;
+		}
+		else
+		{
+			form->mDirty = false;
+			++numRun;
+		}
+		for ( ii = 0; ii < form->mNumOutputs; ++ii )
+		{
+			sym = deps->mSyms + form->mOutputs[ii];
+			for ( jj = 0; jj < sym->mNumReaders; ++jj )
+			{
+				ExprsDepFormula_t *reader = deps->mFormulas + sym->mReaders[jj];
+
+				/* A formula reading what it assigns has already used the value it had */
+				if ( reader == form )
+					continue;
+				if ( form->mDirty )
+					reader->mBlocked = true;
+				if ( !reader->mDirty )
+				{
+					reader->mDirty = true;
+					depsPush(deps, numHeap++, sym->mReaders[jj]);
+				}
+			}
+		}
+	}
+	if ( numRunP )
+		*numRunP = numRun;
+	if ( !alreadyLocked && (err2 = libExprsUnlock(exprs)) && !err )
+		err = err2;
+	return err;
+}
+
+void libExprsDepsFree(ExprsDeps_t *deps)
+{
+	ExprsDef_t *exprs;
+	int ii;
+
+	if ( !deps )
+		return;
+	exprs = deps->mExprs;
+	for ( ii = 0; ii < deps->mNumFormulas; ++ii )
+	{
+		libExprsFreeProgram(deps->mFormulas[ii].mProgram);
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, deps->mFormulas[ii].mInputs);
+	}
+	for ( ii = 0; ii < deps->mNumSyms; ++ii )
+	{
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, deps->mSyms[ii].mName);
+		if ( deps->mSyms[ii].mReaders )
+			exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, deps->mSyms[ii].mReaders);
+		if ( deps->mSyms[ii].mWriters )
+			exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, deps->mSyms[ii].mWriters);
+	}
+	if ( deps->mSyms )
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, deps->mSyms);
+	if ( deps->mFormulas )
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, deps->mFormulas);
+	if ( deps->mWork )
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, deps->mWork);
+	if ( deps->mBuckets != (int *)(deps + 1) )
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, deps->mBuckets);
+	exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, deps);
+}
+
+typedef struct ExprsWorkers_t ExprsWorkers_t;
+
+/* One thread of the pool libExprsRun() spreads statements over */
+typedef struct
+{
+	ExprsWorkers_t *mPool;
+	ExprsDef_t *mExprs;				/* worker's own stacks and pools (the caller's for worker 0) */
+	int mIndex;						/* 0 is the thread that called libExprsRun() */
+	int mStmt;						/* statement being run */
+	char *mSets;					/* assignments held back by the statements run in the current wave */
+	size_t mSetsSize;
+	size_t mSetsUsed;
+	pthread_t mThread;
+} ExprsWorker_t;
+
+/* An assignment held back until every statement before it has been run. The symbol's name and then any string value follow it. */
+typedef struct
+{
+	ExprsSymTerm_t mValue;
+	size_t mSize;					/* of this and what follows rounded up to keep the next one aligned */
+	int mStmt;						/* statement that made it */
+} ExprsWaveSet_t;
+
+/* Where the assignments of a statement are */
+typedef struct
+{
+	int mWorker;					/* whose mSets they are in, WAVE_SETS_PENDING or WAVE_SETS_NOT_RUN */
+	size_t mStart;
+	size_t mEnd;
+} ExprsStmtSets_t;
+
+#define WAVE_SETS_PENDING	(-1)	/* moved to the pool's mPending */
+#define WAVE_SETS_NOT_RUN	(-2)	/* statement not run yet */
+
+struct ExprsWorkers_t
+{
+	int mNumWorkers;				/* including the calling thread */
+	int mNumStarted;				/* number of threads actually created */
+	ExprsWorker_t *mWorkers;
+	pthread_mutex_t mMutex;
+	pthread_cond_t mStartCond;		/* broadcast when a wave is ready or it is time to quit */
+	pthread_cond_t mDoneCond;		/* signalled when the last worker finishes its share of a wave */
+	unsigned int mWaveNum;			/* bumped for each wave handed out */
+	int mNumBusy;					/* threads still running their share of the current wave */
+	bool mQuit;
+	/* The wave being run */
+	const ExprsProgram_t *mProgram;
+	const int *mWave;				/* indices of the statements in the wave */
+	int mWaveSize;
+	ExprsErrs_t *mErrs;				/* error from each statement of the program */
+	ExprsStmtSets_t *mStmtSets;		/* assignments of each statement of the program */
+	ExprsTerm_t *mResult;			/* where the last statement of the program leaves its result */
+	ExprsCallbacks_t mCallbacks;	/* caller's callbacks the held back assignments are made through */
+	int mApplied;					/* statements before this one have had their assignments made */
+	char *mPending;					/* assignments of statements run ahead of one before them */
+	size_t mPendingSize;
+	size_t mPendingUsed;
+	int mPendingMax;				/* highest statement with assignments in mPending */
+};
+
+/* Make room for 'need' more bytes in a buffer of held back assignments */
+static ExprsErrs_t waveSetsRoom(ExprsWorkers_t *pool, char **bufP, size_t *sizeP, size_t used, size_t need)
+{
+	size_t newSize;
+	char *newBuf;
+
+	if ( used + need <= *sizeP )
+		return EXPR_TERM_GOOD;
+	newSize = *sizeP ? 2 * *sizeP : 1024;
+	while ( newSize < used + need )
+		newSize *= 2;
+	if ( !(newBuf = (char *)pool->mCallbacks.memAlloc(pool->mCallbacks.memArg, newSize)) )
+		return EXPR_TERM_BAD_OUT_OF_MEMORY;
+	if ( *bufP )
+	{
+		memcpy(newBuf, *bufP, used);
+		pool->mCallbacks.memFree(pool->mCallbacks.memArg, *bufP);
+	}
+	*bufP = newBuf;
+	*sizeP = newSize;
+	return EXPR_TERM_GOOD;
+}
+
+/* Hold an assignment back until the statements before it have been run */
+static ExprsErrs_t waveSymSet(void *symArg, const char *symName, const ExprsSymTerm_t *symValue)
+{
+	ExprsWorker_t *worker = (ExprsWorker_t *)symArg;
+	ExprsWaveSet_t *set;
+	size_t nameLen = strlen(symName) + 1, strLen = 0, need;
+
+	if ( symValue->termType == EXPRS_SYM_TERM_STRING )
+		strLen = strlen(symValue->value.string) + 1;
+	need = (sizeof(ExprsWaveSet_t) + nameLen + strLen + sizeof(ExprsWaveSet_t) - 1) / sizeof(ExprsWaveSet_t) * sizeof(ExprsWaveSet_t);
+	if ( waveSetsRoom(worker->mPool, &worker->mSets, &worker->mSetsSize, worker->mSetsUsed, need) )
+		return EXPR_TERM_BAD_OUT_OF_MEMORY;
+	set = (ExprsWaveSet_t *)(worker->mSets + worker->mSetsUsed);
+	set->mValue = *symValue;
+	set->mSize = need;
+	set->mStmt = worker->mStmt;
+	memcpy(set + 1, symName, nameLen);
+	if ( strLen )
+		memcpy((char *)(set + 1) + nameLen, symValue->value.string, strLen);
+	worker->mSetsUsed += need;
+	return EXPR_TERM_GOOD;
+}
+
+/* Look for the last assignment to a symbol in a buffer of held back ones made by statements from 'first' up to 'last' */
+static const ExprsWaveSet_t* waveSetsFind(const char *buf, size_t start, size_t end, int first, int last, const char *symName)
+{
+	const ExprsWaveSet_t *set, *found = NULL;
+	size_t off;
+
+	for ( off = start; off < end; off += set->mSize )
+	{
+		set = (const ExprsWaveSet_t *)(buf + off);
+		if ( set->mStmt >= first && set->mStmt <= last && (!found || set->mStmt >= found->mStmt) && !strcmp((const char *)(set + 1), symName) )
+			found = set;
+	}
+	return found;
+}
+
+/* A symbol has the value held back by the statement itself (i.e. "x=(y=2)*y") or by the last one before it still waiting */
+static ExprsErrs_t waveSymGet(void *symArg, const char *symName, ExprsSymTerm_t *symValue)
+{
+	ExprsWorker_t *worker = (ExprsWorker_t *)symArg;
+	ExprsWorkers_t *pool = worker->mPool;
+	const ExprsWaveSet_t *found;
+
+	found = waveSetsFind(worker->mSets, pool->mStmtSets[worker->mStmt].mStart, worker->mSetsUsed, worker->mStmt, worker->mStmt, symName);
+	if ( !found )
+		found = waveSetsFind(pool->mPending, 0, pool->mPendingUsed, pool->mApplied, worker->mStmt - 1, symName);
+	if ( !found )
+		return pool->mCallbacks.symGet(pool->mCallbacks.symArg, symName, symValue);
+	*symValue = found->mValue;
+	if ( symValue->termType == EXPRS_SYM_TERM_STRING )
+		symValue->value.string = (char *)(found + 1) + strlen((const char *)(found + 1)) + 1;
+	return EXPR_TERM_GOOD;
+}
+
+/* Run every mNumWorkers'th statement of the current wave starting with the worker's index */
+static void runWaveShare(ExprsWorker_t *worker)
+{
+	ExprsWorkers_t *pool = worker->mPool;
+	const ExprsProgram_t *program = pool->mProgram;
+	ExprsTerm_t result;
+	int ii, stmt;
+
+	for ( ii = worker->mIndex; ii < pool->mWaveSize; ii += pool->mNumWorkers )
+	{
+		stmt = pool->mWave[ii];
+		worker->mStmt = stmt;
+		pool->mStmtSets[stmt].mWorker = worker->mIndex;
+		pool->mStmtSets[stmt].mStart = worker->mSetsUsed;
+		pool->mErrs[stmt] = runProgramStmt(worker->mExprs, program, program->mStmts + stmt, NULL,
+										   stmt == program->mNumStmts - 1 ? pool->mResult : &result);
+		pool->mStmtSets[stmt].mEnd = worker->mSetsUsed;
+	}
+}
+
+static void* workerMain(void *arg)
+{
+	ExprsWorker_t *worker = (ExprsWorker_t *)arg;
+	ExprsWorkers_t *pool = worker->mPool;
+	unsigned int waveNum = 0;
+
+	pthread_mutex_lock(&pool->mMutex);
+	for (;;)
+	{
+		while ( !pool->mQuit && pool->mWaveNum == waveNum )
+			pthread_cond_wait(&pool->mStartCond, &pool->mMutex);
+		if ( pool->mQuit )
+			break;
+		waveNum = pool->mWaveNum;
+		pthread_mutex_unlock(&pool->mMutex);
+		runWaveShare(worker);
+		pthread_mutex_lock(&pool->mMutex);
+		if ( !--pool->mNumBusy )
+			pthread_cond_signal(&pool->mDoneCond);
+	}
+	pthread_mutex_unlock(&pool->mMutex);
+	return NULL;
+}
+
+static void workersFree(ExprsDef_t *exprs)
+{
+	ExprsWorkers_t *pool = exprs->mWorkers;
+	int ii;
+
+	if ( !pool )
+		return;
+	pthread_mutex_lock(&pool->mMutex);
+	pool->mQuit = true;
+	pthread_cond_broadcast(&pool->mStartCond);
+	pthread_mutex_unlock(&pool->mMutex);
+	for ( ii = 1; ii <= pool->mNumStarted; ++ii )
+		pthread_join(pool->mWorkers[ii].mThread, NULL);
+	for ( ii = 0; ii < pool->mNumWorkers; ++ii )
+	{
+		if ( ii && pool->mWorkers[ii].mExprs )
+			libExprsDestroy(pool->mWorkers[ii].mExprs);
+		if ( pool->mWorkers[ii].mSets )
+			exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, pool->mWorkers[ii].mSets);
+	}
+	if ( pool->mPending )
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, pool->mPending);
+	pthread_cond_destroy(&pool->mDoneCond);
+	pthread_cond_destroy(&pool->mStartCond);
+	pthread_mutex_destroy(&pool->mMutex);
+	exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, pool);
+	exprs->mWorkers = NULL;
+}
+
+ExprsErrs_t libExprsSetThreads(ExprsDef_t *exprs, int numThreads, int alreadyLocked)
+{
+	ExprsErrs_t err2 = EXPR_TERM_GOOD;
+	ExprsWorkers_t *pool;
+	char eBuf[128];
+	size_t totSize;
+	int ii;
+
+	if ( !exprs || numThreads < 0 )
+		return EXPR_TERM_BAD_PARAMETER;
+	if ( !alreadyLocked && (err2 = libExprsLock(exprs)) )
+		return err2;
+	workersFree(exprs);
+	if ( numThreads > 1 )
+	{
+		totSize = sizeof(ExprsWorkers_t) + numThreads * sizeof(ExprsWorker_t);
+		pool = (ExprsWorkers_t *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, totSize);
+		if ( !pool )
+		{
+			snprintf(eBuf, sizeof(eBuf), "libExprsSetThreads(): Failed to allocate " FMT_SZ " bytes: %s\n", totSize, strerror(errno));
+			showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
+			err2 = EXPR_TERM_BAD_OUT_OF_MEMORY;
+		}
+		else
+		{
+			memset(pool, 0, totSize);
+			pool->mNumWorkers = numThreads;
+			pool->mWorkers = (ExprsWorker_t *)(pool + 1);
+			pthread_mutex_init(&pool->mMutex, NULL);
+			pthread_cond_init(&pool->mStartCond, NULL);
+			pthread_cond_init(&pool->mDoneCond, NULL);
+			exprs->mWorkers = pool;
+			for ( ii = 0; ii < numThreads; ++ii )
+			{
+				pool->mWorkers[ii].mPool = pool;
+				pool->mWorkers[ii].mIndex = ii;
+				if ( !ii )
+					continue;
+				pool->mWorkers[ii].mExprs = libExprsInit(&exprs->mCallbacks, exprs->mTermsPoolInc, exprs->mStringPoolInc);
+				if ( !pool->mWorkers[ii].mExprs )
+				{
+					err2 = EXPR_TERM_BAD_OUT_OF_MEMORY;
+					break;
+				}
+				if ( pthread_create(&pool->mWorkers[ii].mThread, NULL, workerMain, pool->mWorkers + ii) )
+				{
+					snprintf(eBuf, sizeof(eBuf), "libExprsSetThreads(): Failed to create thread %d: %s\n", ii, strerror(errno));
+					showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
+					err2 = EXPR_TERM_BAD_OUT_OF_MEMORY;
+					break;
+				}
+				pool->mNumStarted = ii;
+			}
+			if ( err2 )
+				workersFree(exprs);
+		}
+	}
+	if ( !alreadyLocked )
+	{
+		ExprsErrs_t err = libExprsUnlock(exprs);
+		if ( !err2 )
+			err2 = err;
+	}
+	return err2;
+}
+
+/** runWaves - run a program's statements a wave at a time
+ *  spreading each wave over the pool of threads.
+ *
+ *  At entry:
+ *  @param exprs - pointer to ExprsDef_t (locked)
+ *  @param program - program to run
+ *  @param returnTerm - pointer to place to deposit the result
+ *  @param errP - pointer to place to deposit the error
+ *
+ *  At exit:
+ *  @return 1 if the program was run, else 0 and nothing has
+ *  		been done. The caller has to run it the normal way.
+ *
+ *  @note A statement goes in the wave after the last one that
+ *  	  assigns a symbol it reads or assigns and after the
+ *  	  last one that reads a symbol it assigns. So within a
+ *  	  wave order doesn't matter and each statement sees
+ *  	  exactly what it would have if run in turn. The
+ *  	  assignments are held back and made in statement order
+ *  	  once every statement before them has been run,
+ *  	  stopping at the first one that failed, so nothing
+ *  	  after it is assigned. Until then a later statement
+ *  	  reading the symbol gets the held back value.
+ **/
+static int runWaves(ExprsDef_t *exprs, const ExprsProgram_t *program, ExprsTerm_t *returnTerm, ExprsErrs_t *errP)
+{
+	ExprsWorkers_t *pool = exprs->mWorkers;
+	const ExprsStatement_t *stmt;
+	const ExprsTermInfo_t *info;
+	const ExprsWaveSet_t *set;
+	ExprsStmtSets_t *stmtSets, *sets;
+	ExprsSymTerm_t value;
+	ExprsErrs_t *errs, err;
+	const char *name, *buf;
+	char eBuf[512];
+	int *level, *order, *inTurn, *start, *writeLvl, *readLvl;
+	int ii, jj, lvl, numLevels = 0, numStmts = program->mNumStmts, bad;
+	size_t totSize, off;
+
+	if ( !pool || numStmts < 2 || exprs->mVerbose )
+		return 0;
+	totSize = numStmts * (sizeof(ExprsStmtSets_t) + sizeof(ExprsErrs_t)) + (4 * numStmts + 1 + 2 * program->mNumSyms) * sizeof(int);
+	if ( !(stmtSets = (ExprsStmtSets_t *)exprs->mCallbacks.memAlloc(exprs->mCallbacks.memArg, totSize)) )
+		return 0;
+	errs = (ExprsErrs_t *)(stmtSets + numStmts);
+	level = (int *)(errs + numStmts);
+	order = level + numStmts;
+	inTurn = order + numStmts;
+	start = inTurn + numStmts;
+	writeLvl = start + numStmts + 1;
+	readLvl = writeLvl + program->mNumSyms;
+	for ( ii = 0; ii < program->mNumSyms; ++ii )
+		writeLvl[ii] = readLvl[ii] = -1;
+	for ( ii = 0, stmt = program->mStmts; ii < numStmts; ++ii, ++stmt )
+	{
+		lvl = 0;
+		for ( jj = 0, info = program->mInfo + stmt->mFirstTerm; jj < stmt->mNumTerms; ++jj, ++info )
+		{
+			if ( info->mSym < 0 )
+				continue;
+			if ( lvl <= writeLvl[info->mSym] )
+				lvl = writeLvl[info->mSym] + 1;
+			if ( info->mLvalue && lvl <= readLvl[info->mSym] )
+				lvl = readLvl[info->mSym] + 1;
+		}
+		for ( jj = 0, info = program->mInfo + stmt->mFirstTerm; jj < stmt->mNumTerms; ++jj, ++info )
+		{
+			if ( info->mSym < 0 )
+				continue;
+			if ( info->mLvalue )
+				writeLvl[info->mSym] = lvl;
+			else if ( readLvl[info->mSym] < lvl )
+				readLvl[info->mSym] = lvl;
+		}
+		level[ii] = lvl;
+		if ( numLevels <= lvl )
+			numLevels = lvl + 1;
+	}
+	if ( numLevels == numStmts )
+	{
+		/* Nothing can be run side by side */
+		exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, stmtSets);
+		return 0;
+	}
+	for ( ii = 0; ii < pool->mNumWorkers; ++ii )
+	{
+		ExprsDef_t *wExprs = ii ? pool->mWorkers[ii].mExprs : exprs;
+
+		if ( ii )
+		{
+			wExprs->mCallbacks = exprs->mCallbacks;
+			wExprs->mFlags = exprs->mFlags;
+			wExprs->mRadix = exprs->mRadix;
+		}
+		if ( loadProgramStrings(wExprs, program) )
+		{
+			exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, stmtSets);
+			return 0;
+		}
+	}
+	/* Assignments are held back and made in statement order as soon as every statement before them has been run */
+	pool->mWorkers[0].mExprs = exprs;
+	pool->mCallbacks = exprs->mCallbacks;
+	pool->mApplied = 0;
+	pool->mPendingUsed = 0;
+	pool->mPendingMax = -1;
+	for ( ii = 0; ii < numStmts; ++ii )
+		stmtSets[ii].mWorker = WAVE_SETS_NOT_RUN;
+	for ( ii = 0; ii < pool->mNumWorkers; ++ii )
+	{
+		ExprsDef_t *wExprs = pool->mWorkers[ii].mExprs;
+
+		wExprs->mCallbacks.symGet = pool->mCallbacks.symGet ? waveSymGet : NULL;
+		wExprs->mCallbacks.symSet = pool->mCallbacks.symSet ? waveSymSet : NULL;
+		wExprs->mCallbacks.symArg = pool->mWorkers + ii;
+		pool->mWorkers[ii].mSetsUsed = 0;
+	}
+	/* Sort the statements by wave keeping them in order within each */
+	memset(start, 0, (numLevels + 1) * sizeof(int));
+	for ( ii = 0; ii < numStmts; ++ii )
+		++start[level[ii] + 1];
+	for ( lvl = 0; lvl < numLevels; ++lvl )
+		start[lvl + 1] += start[lvl];
+	for ( ii = 0; ii < numStmts; ++ii )
+		order[start[level[ii]]++] = ii;
+	for ( lvl = numLevels; lvl > 0; --lvl )
+		start[lvl] = start[lvl - 1];
+	start[0] = 0;
+	memcpy(inTurn, order, numStmts * sizeof(int));
+	/* The last statement is always run by the calling thread so any string result is in its pool */
+	lvl = level[numStmts - 1];
+	order[start[lvl + 1] - 1] = order[start[lvl]];
+	order[start[lvl]] = numStmts - 1;
+	returnTerm->termType = EXPRS_TERM_NULL;
+	returnTerm->term.s64 = 0;
+	returnTerm->chrPtr = NULL;
+	pool->mProgram = program;
+	pool->mErrs = errs;
+	pool->mStmtSets = stmtSets;
+	pool->mResult = returnTerm;
+	bad = -1;
+	for ( lvl = 0; lvl < numLevels && bad < 0; ++lvl )
+	{
+		pool->mWave = order + start[lvl];
+		pool->mWaveSize = start[lvl + 1] - start[lvl];
+		if ( pool->mWaveSize > 1 )
+		{
+			pthread_mutex_lock(&pool->mMutex);
+			pool->mNumBusy = pool->mNumWorkers - 1;
+			++pool->mWaveNum;
+			pthread_cond_broadcast(&pool->mStartCond);
+			pthread_mutex_unlock(&pool->mMutex);
+			runWaveShare(pool->mWorkers);
+			pthread_mutex_lock(&pool->mMutex);
+			while ( pool->mNumBusy )
+				pthread_cond_wait(&pool->mDoneCond, &pool->mMutex);
+			pthread_mutex_unlock(&pool->mMutex);
+		}
+		else
+			runWaveShare(pool->mWorkers);
+		/* Make the assignments in statement order up to the first statement not run yet or the first that failed */
+		for ( ; pool->mApplied < numStmts && stmtSets[pool->mApplied].mWorker != WAVE_SETS_NOT_RUN && bad < 0; ++pool->mApplied )
+		{
+			jj = pool->mApplied;
+			sets = stmtSets + jj;
+			buf = sets->mWorker == WAVE_SETS_PENDING ? pool->mPending : pool->mWorkers[sets->mWorker].mSets;
+			for ( off = sets->mStart; off < sets->mEnd; off += set->mSize )
+			{
+				set = (const ExprsWaveSet_t *)(buf + off);
+				name = (const char *)(set + 1);
+				value = set->mValue;
+				if ( value.termType == EXPRS_SYM_TERM_STRING )
+					value.value.string = (char *)name + strlen(name) + 1;
+				if ( (err = pool->mCallbacks.symSet(pool->mCallbacks.symArg, name, &value)) )
+				{
+					snprintf(eBuf, sizeof(eBuf), "runWaves(): Failed ('%s') to assign symbol '%s'\n", libExprsGetErrorStr(err), name);
+					showMsg(exprs, EXPRS_SEVERITY_ERROR, eBuf);
+					errs[jj] = err;
+					break;
+				}
+			}
+			if ( errs[jj] > EXPR_TERM_END )
+				bad = jj;
+		}
+		if ( pool->mPendingMax < pool->mApplied )
+		{
+			pool->mPendingUsed = 0;
+			pool->mPendingMax = -1;
+		}
+		/* What is left of the wave was run ahead of a statement before it so has to wait */
+		for ( ii = 0; ii < pool->mWaveSize && bad < 0; ++ii )
+		{
+			jj = pool->mWave[ii];
+			sets = stmtSets + jj;
+			if ( jj < pool->mApplied || sets->mStart == sets->mEnd )
+				continue;
+			if ( waveSetsRoom(pool, &pool->mPending, &pool->mPendingSize, pool->mPendingUsed, sets->mEnd - sets->mStart) )
+			{
+				errs[jj] = EXPR_TERM_BAD_OUT_OF_MEMORY;
+				bad = jj;
+				break;
+			}
+			memcpy(pool->mPending + pool->mPendingUsed, pool->mWorkers[sets->mWorker].mSets + sets->mStart, sets->mEnd - sets->mStart);
+			sets->mWorker = WAVE_SETS_PENDING;
+			sets->mEnd = pool->mPendingUsed + sets->mEnd - sets->mStart;
+			sets->mStart = pool->mPendingUsed;
+			pool->mPendingUsed = sets->mEnd;
+			if ( pool->mPendingMax < jj )
+				pool->mPendingMax = jj;
+		}
+		for ( ii = 0; ii < pool->mNumWorkers; ++ii )
+			pool->mWorkers[ii].mSetsUsed = 0;
+	}
+	exprs->mCallbacks = pool->mCallbacks;
+	if ( bad < 0 )
+		bad = numStmts - 1;
+	*errP = errs[bad];
+	exprs->mCurrPtr = program->mText + program->mStmts[bad].mEndOffset;
+	exprs->mCallbacks.memFree(exprs->mCallbacks.memArg, stmtSets);
+	return 1;
+}
+
+static void lclMsgOut(void *msgArg, ExprsMsgSeverity_t severity, const char *msg)
+{
+	static const char *Severities[] = { "INFO", "WARN", "ERROR", "FATAL" };
+	fprintf(severity > EXPRS_SEVERITY_INFO ? stderr : stdout, "%s-libExprs(): %s", Severities[severity], msg);
+}
+
+static void* lclMalloc(void *memArg, size_t size)
 {
 	if ( !size )
 	{
@@ -3083,15 +7795,15 @@ ExprsDef_t* libExprsInit(const ExprsCallbacks_t *callbacks, int termIncs, int st
 		termIncs = 32;
 	if ( !stringIncs )
 		stringIncs = 2048;
-	if (    n_elts(PrecedenceNormal) != EXPRS_TERM_ASSIGN + 1
-		 || n_elts(PrecedenceNone) != EXPRS_TERM_ASSIGN + 1 )
+	if (    n_elts(PrecedenceNormal) != EXPRS_TERM_SKIP_TRUE + 1
+		 || n_elts(PrecedenceNone) != EXPRS_TERM_SKIP_TRUE + 1 )
 	{
 		/* Sanity check */
 		snprintf(tBuf, sizeof(tBuf),
 				 "libExprsInit(): n_elts(PrecedenceNormal) s/b %d is %d\n"
 				 "libExprsInit(): n_elts(PrecedenceNone)   s/b %d is %d\n",
-				 n_elts(PrecedenceNormal), EXPRS_TERM_ASSIGN + 1,
-				 n_elts(PrecedenceNone), EXPRS_TERM_ASSIGN + 1);
+				 n_elts(PrecedenceNormal), EXPRS_TERM_SKIP_TRUE + 1,
+				 n_elts(PrecedenceNone), EXPRS_TERM_SKIP_TRUE + 1);
 		tCallbacks.msgOut(tCallbacks.msgArg, EXPRS_SEVERITY_FATAL, tBuf);
 		return NULL;
 	}
@@ -3103,6 +7815,7 @@ ExprsDef_t* libExprsInit(const ExprsCallbacks_t *callbacks, int termIncs, int st
 		tCallbacks.msgOut(tCallbacks.msgArg, EXPRS_SEVERITY_FATAL, tBuf);
 		return NULL;
 	}
+	pthread_once(&LexScannerOnce, lexPickScanner);
 	memset(exprs, 0, sizeof(ExprsDef_t));
 	exprs->mOpenDelimiter = '(';
 	exprs->mCloseDelimiter = ')';
@@ -3126,6 +7839,8 @@ ExprsErrs_t libExprsDestroy(ExprsDef_t *exprs)
 	ExprsStack_t *stack;
 
 	err = libExprsLock(exprs);
+	cacheFree(exprs);
+	workersFree(exprs);
 	stack = &exprs->mStack;
 	if ( stack->mTermsPool.mPoolTop )
 		memFree(pArg, stack->mTermsPool.mPoolTop);
@@ -3137,6 +7852,224 @@ ExprsErrs_t libExprsDestroy(ExprsDef_t *exprs)
 	return err;
 }
 
+/* A pool of parser contexts. Idle contexts are kept either on the pool's
+ * shared list (which takes the pool's mutex) or in a small cache belonging
+ * to the thread that last released them (which takes no lock at all). A
+ * thread that releases what it acquires therefore never touches the mutex
+ * once its cache is primed. Idle contexts are chained through userArg1,
+ * which is cleared again when the context is handed out. */
+#define CTX_POOL_CACHE 4			/* idle contexts kept by each thread */
+
+typedef struct ExprsCtxCache_t
+{
+	struct ExprsCtxPool_t *mPool;
+	struct ExprsCtxCache_t *mNext;	/* list of every thread's cache (so libExprsCtxPoolFree() can find them) */
+	struct ExprsCtxCache_t *mPrev;
+	int mNumCtx;
+	ExprsDef_t *mCtx[CTX_POOL_CACHE];
+} ExprsCtxCache_t;
+
+struct ExprsCtxPool_t
+{
+	pthread_mutex_t mMutex;			/* guards the members below mKey */
+	pthread_key_t mKey;				/* this thread's ExprsCtxCache_t */
+	ExprsCallbacks_t mCallbacks;	/* given to each new context */
+	int mTermsPoolInc;
+	int mStringPoolInc;
+	ExprsDef_t *mIdle;				/* shared list of idle contexts */
+	ExprsCtxCache_t *mCaches;
+	int mNumCtx;					/* contexts in existence */
+};
+
+/* Restore a context to the state libExprsInit() leaves it in apart from
+ * the memory it has grown and any cache or threads set on it. */
+static void ctxPoolReset(ExprsCtxPool_t *pool, ExprsDef_t *exprs)
+{
+	reset(exprs, 1);
+	exprs->userArg1 = NULL;
+	exprs->userArg2 = NULL;
+	exprs->mCallbacks = pool->mCallbacks;
+	exprs->mVerbose = 0;
+	exprs->mFlags = 0;
+	exprs->mRadix = 0;
+	exprs->mOpenDelimiter = '(';
+	exprs->mCloseDelimiter = ')';
+}
+
+/* Called with the pool locked */
+static void ctxPoolPush(ExprsCtxPool_t *pool, ExprsDef_t *exprs)
+{
+	exprs->userArg1 = pool->mIdle;
+	pool->mIdle = exprs;
+}
+
+/* Runs when a thread that used the pool exits. Its idle contexts go back
+ * to the shared list. */
+static void ctxCacheExit(void *arg)
+{
+	ExprsCtxCache_t *cache = (ExprsCtxCache_t *)arg;
+	ExprsCtxPool_t *pool = cache->mPool;
+
+	pthread_mutex_lock(&pool->mMutex);
+	while ( cache->mNumCtx )
+		ctxPoolPush(pool, cache->mCtx[--cache->mNumCtx]);
+	if ( cache->mPrev )
+		cache->mPrev->mNext = cache->mNext;
+	else
+		pool->mCaches = cache->mNext;
+	if ( cache->mNext )
+		cache->mNext->mPrev = cache->mPrev;
+	pthread_mutex_unlock(&pool->mMutex);
+	pool->mCallbacks.memFree(pool->mCallbacks.memArg, cache);
+}
+
+ExprsErrs_t libExprsCtxPoolCreate(const ExprsCallbacks_t *callbacks, int termIncs, int stringIncs, int numWarm, ExprsCtxPool_t **poolP)
+{
+	ExprsCtxPool_t *pool;
+	ExprsCallbacks_t tCallbacks;
+	ExprsDef_t *exprs;
+
+	if ( !poolP || numWarm < 0 )
+		return EXPR_TERM_BAD_PARAMETER;
+	*poolP = NULL;
+	if ( !checkCallbacks(&tCallbacks, callbacks, EXPRS_SEVERITY_ERROR) )
+		return EXPR_TERM_BAD_PARAMETER;
+	pool = (ExprsCtxPool_t *)tCallbacks.memAlloc(tCallbacks.memArg, sizeof(ExprsCtxPool_t));
+	if ( !pool )
+		return EXPR_TERM_BAD_OUT_OF_MEMORY;
+	memset(pool, 0, sizeof(ExprsCtxPool_t));
+	if ( pthread_key_create(&pool->mKey, ctxCacheExit) )
+	{
+		tCallbacks.memFree(tCallbacks.memArg, pool);
+		return EXPR_TERM_BAD_OUT_OF_MEMORY;
+	}
+	pthread_mutex_init(&pool->mMutex, NULL);
+	pool->mCallbacks = tCallbacks;
+	pool->mTermsPoolInc = termIncs;
+	pool->mStringPoolInc = stringIncs;
+	for ( ; numWarm > 0; --numWarm )
+	{
+		if ( !(exprs = libExprsInit(&pool->mCallbacks, termIncs, stringIncs)) )
+		{
+			libExprsCtxPoolFree(pool);
+			return EXPR_TERM_BAD_OUT_OF_MEMORY;
+		}
+		ctxPoolPush(pool, exprs);
+		++pool->mNumCtx;
+	}
+	*poolP = pool;
+	return EXPR_TERM_GOOD;
+}
+
+ExprsErrs_t libExprsCtxAcquire(ExprsCtxPool_t *pool, ExprsDef_t **exprsP)
+{
+	ExprsCtxCache_t *cache;
+	ExprsDef_t *exprs;
+
+	if ( !pool || !exprsP )
+		return EXPR_TERM_BAD_PARAMETER;
+	cache = (ExprsCtxCache_t *)pthread_getspecific(pool->mKey);
+	if ( cache && cache->mNumCtx )
+	{
+		*exprsP = cache->mCtx[--cache->mNumCtx];
+		return EXPR_TERM_GOOD;
+	}
+	if ( pthread_mutex_lock(&pool->mMutex) )
+		return EXPR_TERM_BAD_NOLOCK;
+	if ( (exprs = pool->mIdle) )
+	{
+		pool->mIdle = (ExprsDef_t *)exprs->userArg1;
+		exprs->userArg1 = NULL;
+	}
+	else if ( (exprs = libExprsInit(&pool->mCallbacks, pool->mTermsPoolInc, pool->mStringPoolInc)) )
+		++pool->mNumCtx;
+	pthread_mutex_unlock(&pool->mMutex);
+	*exprsP = exprs;
+	return exprs ? EXPR_TERM_GOOD : EXPR_TERM_BAD_OUT_OF_MEMORY;
+}
+
+ExprsErrs_t libExprsCtxRelease(ExprsCtxPool_t *pool, ExprsDef_t *exprs)
+{
+	ExprsCtxCache_t *cache;
+
+	if ( !pool || !exprs )
+		return EXPR_TERM_BAD_PARAMETER;
+	ctxPoolReset(pool, exprs);
+	cache = (ExprsCtxCache_t *)pthread_getspecific(pool->mKey);
+	if ( !cache )
+	{
+		/* First release by this thread. Failing to make a cache just means using the shared list. */
+		cache = (ExprsCtxCache_t *)pool->mCallbacks.memAlloc(pool->mCallbacks.memArg, sizeof(ExprsCtxCache_t));
+		if ( cache )
+		{
+			memset(cache, 0, sizeof(ExprsCtxCache_t));
+			cache->mPool = pool;
+			if ( pthread_setspecific(pool->mKey, cache) )
+			{
+				pool->mCallbacks.memFree(pool->mCallbacks.memArg, cache);
+				cache = NULL;
+			}
+		}
+		if ( cache )
+		{
+			pthread_mutex_lock(&pool->mMutex);
+			cache->mNext = pool->mCaches;
+			if ( pool->mCaches )
+				pool->mCaches->mPrev = cache;
+			pool->mCaches = cache;
+			pthread_mutex_unlock(&pool->mMutex);
+		}
+	}
+	if ( cache && cache->mNumCtx < CTX_POOL_CACHE )
+	{
+		cache->mCtx[cache->mNumCtx++] = exprs;
+		return EXPR_TERM_GOOD;
+	}
+	if ( pthread_mutex_lock(&pool->mMutex) )
+		return EXPR_TERM_BAD_NOLOCK;
+	ctxPoolPush(pool, exprs);
+	pthread_mutex_unlock(&pool->mMutex);
+	return EXPR_TERM_GOOD;
+}
+
+ExprsErrs_t libExprsCtxPoolFree(ExprsCtxPool_t *pool)
+{
+	void (*memFree)(void *memArg, void *memPtr);
+	void *memArg;
+	ExprsCtxCache_t *cache;
+	ExprsDef_t *exprs;
+	char eBuf[128];
+
+	if ( !pool )
+		return EXPR_TERM_GOOD;
+	memFree = pool->mCallbacks.memFree;
+	memArg = pool->mCallbacks.memArg;
+	/* Deleting the key first stops ctxCacheExit() running for threads that exit later */
+	pthread_key_delete(pool->mKey);
+	while ( (cache = pool->mCaches) )
+	{
+		while ( cache->mNumCtx )
+			ctxPoolPush(pool, cache->mCtx[--cache->mNumCtx]);
+		pool->mCaches = cache->mNext;
+		memFree(memArg, cache);
+	}
+	while ( (exprs = pool->mIdle) )
+	{
+		pool->mIdle = (ExprsDef_t *)exprs->userArg1;
+		libExprsDestroy(exprs);
+		--pool->mNumCtx;
+	}
+	if ( pool->mNumCtx )
+	{
+		snprintf(eBuf, sizeof(eBuf), "libExprsCtxPoolFree(): %d context%s still acquired\n",
+				 pool->mNumCtx, pool->mNumCtx == 1 ? " is" : "s are");
+		pool->mCallbacks.msgOut(pool->mCallbacks.msgArg, EXPRS_SEVERITY_WARN, eBuf);
+	}
+	pthread_mutex_destroy(&pool->mMutex);
+	memFree(memArg, pool);
+	return EXPR_TERM_GOOD;
+}
+
 ExprsErrs_t libExprsLock(ExprsDef_t *exprs)
 {
 	if ( pthread_mutex_lock(&exprs->mMutex) )
@@ -96,7 +96,7 @@ typedef struct
 	/* The actual term is one of the following: */
 	union
 	{
-		int link;		/* Index to a different stack */
+		int link;		/* Index to a different stack or number of terms a skip term skips */
 		size_t string;	/* Index into the string pool if type is string */
 		double f64;
 		int64_t s64;
@@ -215,6 +215,8 @@ typedef unsigned char ExprsPrecedence_t;
 #define EXPRS_FLG_NO_DOUBLE_PLAIN	0x00400000	/*! term cannot be double plain */
 #define EXPRS_FLG_OPEN_IS_END		0x00800000	/*! Open delimiter ends expression */
 #define EXPRS_FLG_CLOSE_IS_END		0x01000000	/*! Close delimiter ends expression */
+#define EXPRS_FLG_FOLD_CONSTANTS	0x02000000	/*! Compiling or parsing to RPN folds constant subexpressions */
+#define EXPRS_FLG_JIT				0x04000000	/*! Compile integer only statements to native code (x86-64 only) */
 
 /** ExprsDef_t - definition of expression stack internal
  *  variables. With the exception of userArg1 and userArg2
@@ -239,6 +241,9 @@ typedef struct
 	char mCloseDelimiter;			/*! Close expression delimiter */
 	const ExprsPrecedence_t *precedencePtr; /*! Pointer to our precedence table */
 	const uint16_t *chMaskPtr;		/*! Pointer to check mask */
+	struct ExprsProgCache_t *mProgCache; /*! Programs compiled by libExprsEval() (NULL if no cache. See libExprsSetCacheSize()) */
+	struct ExprsWorkers_t *mWorkers; /*! Threads used by libExprsRun() (NULL if none. See libExprsSetThreads()) */
+	const char *mEndPtr;			/*! End of the expression text being processed. Nothing at or past it is read */
 } ExprsDef_t;
 
 #ifndef EXPRS_MAX_NEST
@@ -421,6 +426,32 @@ extern const char *libExprsGetErrorStr(ExprsErrs_t errCode);
  **/
 extern ExprsErrs_t libExprsEval(ExprsDef_t *exprs, const char *text, ExprsTerm_t *returnTerm, int alreadyLocked);
 
+/** libExprsEvalN - Evaluate an expression that is not null
+ *  terminated.
+ *
+ *  At entry:
+ *  @param exprs - pointer to expression parser control as
+ *  			 returned from libExprsInit().
+ *  @param text - text of expression to evaluate. It need not be
+ *  			null terminated and may be in read only memory.
+ *  @param len - number of bytes at 'text'.
+ *  @param returnTerm - pointer to place into which to deposit
+ *  				  the result.
+ *  @param alreadyLocked - set to non-zero to indicate the mutex
+ *  					 lock on the ExprsDef_t has already been
+ *  					 performed by libExprsLock().
+ *
+ *  At exit:
+ *  @return same as libExprsEval(). mCurrPtr, mLineHead and the
+ *  		returnTerm's chrPtr point into 'text'.
+ *
+ *  @note No byte at or after text+len is ever read and the
+ *  	  text is lexed where it is, not copied. A null within
+ *  	  the span is a control character like any other so it
+ *  	  ends a statement, not the text.
+ **/
+extern ExprsErrs_t libExprsEvalN(ExprsDef_t *exprs, const char *text, size_t len, ExprsTerm_t *returnTerm, int alreadyLocked);
+
 /** libExprsParseToRPN - Parse an expression to RPN
  *
  *  At entry:
@@ -446,8 +477,669 @@ extern ExprsErrs_t libExprsEval(ExprsDef_t *exprs, const char *text, ExprsTerm_t
  **/
 extern ExprsErrs_t libExprsParseToRPN(ExprsDef_t *exprs, const char *text, int alreadyLocked);
 
+/** libExprsParseToRPNN - Parse an expression that is not null
+ *  terminated to RPN.
+ *
+ *  At entry:
+ *  @param exprs - pointer to expression parser control as
+ *  			 returned from libExprsInit().
+ *  @param text - text of expression to parse. It need not be
+ *  			null terminated and may be in read only memory.
+ *  @param len - number of bytes at 'text'.
+ *  @param alreadyLocked - set to non-zero to indicate the mutex
+ *  					 lock on the ExprsDef_t has already been
+ *  					 performed by libExprsLock().
+ *
+ *  At exit:
+ *  @return same as libExprsParseToRPN(). mCurrPtr and the
+ *  		chrPtr of each term point into 'text'.
+ *
+ *  @note No byte at or after text+len is ever read.
+ **/
+extern ExprsErrs_t libExprsParseToRPNN(ExprsDef_t *exprs, const char *text, size_t len, int alreadyLocked);
+
 extern ExprsErrs_t libExprsWalkParsedStack(ExprsDef_t *exprs, ExprsErrs_t (*walkCallback)(ExprsDef_t *exprs, const ExprsTerm_t *term), int alreadyLocked);
 
+/** ExprsProgram_t - an expression that has been parsed once by
+ *  libExprsCompile() and can then be evaluated any number of
+ *  times by libExprsRun() without parsing the text again. The
+ *  contents are private to lib_exprs.
+ **/
+typedef struct ExprsProgram_t ExprsProgram_t;
+
+/** libExprsCompile - Parse an expression into a reusable
+ *  program.
+ *
+ *  At entry:
+ *  @param exprs - pointer to expression parser control as
+ *  			 returned from libExprsInit().
+ *  @param text - null terminated text of expression to
+ *  			compile. It may hold several statements
+ *  			separated by ';' just like libExprsEval().
+ *  @param programP - pointer to place into which to deposit the
+ *  				pointer to the compiled program.
+ *  @param alreadyLocked - set to non-zero to indicate the mutex
+ *  					 lock on the ExprsDef_t has already been
+ *  					 performed by libExprsLock().
+ *
+ *  At exit:
+ *  @return 0 on success, else error. On success *programP will
+ *  		have been set to a program that must eventually be
+ *  		released with libExprsFreeProgram().
+ *
+ *  @note Every statement is parsed here, before any is run. A
+ *  	  parse error in any statement is reported here and
+ *  	  nothing is run, whereas libExprsEval() would have run
+ *  	  the statements before it, making their assignments, and
+ *  	  could have failed in one of them first (i.e. "x=1;.5").
+ *  	  The program holds a private copy of the RPN terms, of
+ *  	  any string literals and of the text itself, so 'text'
+ *  	  does not need to remain valid after this call. The
+ *  	  flags and radix in effect at compile time are the ones
+ *  	  that apply when the program is run.
+ **/
+extern ExprsErrs_t libExprsCompile(ExprsDef_t *exprs, const char *text, ExprsProgram_t **programP, int alreadyLocked);
+
+/** libExprsCompileN - Same as libExprsCompile() but for text
+ *  that is not null terminated.
+ *
+ *  At entry:
+ *  @param len - number of bytes at 'text'. No byte at or after
+ *  		   text+len is ever read.
+ *  (The other parameters are as for libExprsCompile().)
+ *
+ *  At exit:
+ *  @return same as libExprsCompile().
+ **/
+extern ExprsErrs_t libExprsCompileN(ExprsDef_t *exprs, const char *text, size_t len, ExprsProgram_t **programP, int alreadyLocked);
+
+/** libExprsRun - Evaluate a previously compiled program.
+ *
+ *  At entry:
+ *  @param exprs - pointer to expression parser control as
+ *  			 returned from libExprsInit(). It need not be
+ *  			 the same one used to compile the program.
+ *  @param program - pointer to program returned from
+ *  			   libExprsCompile().
+ *  @param returnTerm - pointer to place into which to deposit
+ *  				  the result.
+ *  @param alreadyLocked - set to non-zero to indicate the mutex
+ *  					 lock on the ExprsDef_t has already been
+ *  					 performed by libExprsLock().
+ *
+ *  At exit:
+ *  @return 0 on success, else error. Results and error codes
+ *  		are identical to what libExprsEval() would have
+ *  		produced given the same text. (A text with a parse
+ *  		error never gets this far. See libExprsCompile().)
+ *
+ *  @note Symbols are looked up (and assigned) via the
+ *  	  callbacks in 'exprs' each time the program is run. The
+ *  	  same rules about the lifetime of a returned string
+ *  	  apply as with libExprsEval(). If threads have been
+ *  	  given with libExprsSetThreads() the statements may be
+ *  	  run side by side (see there).
+ **/
+extern ExprsErrs_t libExprsRun(ExprsDef_t *exprs, const ExprsProgram_t *program, ExprsTerm_t *returnTerm, int alreadyLocked);
+
+/** libExprsSetThreads - set the number of threads libExprsRun()
+ *  may spread the statements of a program over.
+ *
+ *  At entry:
+ *  @param exprs - pointer to expression parser control as
+ *  			 returned from libExprsInit().
+ *  @param numThreads - number of threads including the one
+ *  				  calling libExprsRun(). 0 or 1 turns it
+ *  				  off (which is the default).
+ *  @param alreadyLocked - set to non-zero to indicate the mutex
+ *  					 lock on the ExprsDef_t has already been
+ *  					 performed by libExprsLock().
+ *
+ *  At exit:
+ *  @return 0 on success, else error. Any threads already
+ *  		started are stopped first. Each extra thread has its
+ *  		own stacks and pools and waits until needed.
+ *
+ *  @note The statements of a program are put in waves. A
+ *  	  statement goes in a later wave than any statement
+ *  	  before it that assigns a symbol it uses or uses a
+ *  	  symbol it assigns. The statements of a wave are run
+ *  	  side by side and a wave is not started until the one
+ *  	  before it is done, so results are the same as running
+ *  	  them in turn. Assignments are held back until every
+ *  	  statement before them has been run and are made in
+ *  	  statement order, so if a statement fails nothing after
+ *  	  it is assigned. The symGet and msgOut callbacks are
+ *  	  called from several threads at once so have to be
+ *  	  thread safe. symSet is only called from the thread
+ *  	  that called libExprsRun(). Programs run with
+ *  	  libExprsRunSlots() or in verbose mode are always run
+ *  	  in turn.
+ **/
+extern ExprsErrs_t libExprsSetThreads(ExprsDef_t *exprs, int numThreads, int alreadyLocked);
+
+/** libExprsProgramNumSymbols - get the number of distinct
+ *  symbol names referenced by a compiled program.
+ *
+ *  At entry:
+ *  @param program - pointer to program returned from
+ *  			   libExprsCompile().
+ *
+ *  At exit:
+ *  @return number of symbols. Symbols are numbered from 0 in
+ *  		the order they first appear in the text.
+ **/
+extern int libExprsProgramNumSymbols(const ExprsProgram_t *program);
+
+/** libExprsProgramSymbolName - get the name of one of the
+ *  symbols referenced by a compiled program.
+ *
+ *  At entry:
+ *  @param program - pointer to program returned from
+ *  			   libExprsCompile().
+ *  @param symIdx - symbol number (0 to
+ *  			  libExprsProgramNumSymbols()-1)
+ *
+ *  At exit:
+ *  @return pointer to null terminated name or NULL if symIdx
+ *  		is out of range. It remains valid until the program
+ *  		is freed.
+ **/
+extern const char *libExprsProgramSymbolName(const ExprsProgram_t *program, int symIdx);
+
+/** libExprsBindSymbols - bind each distinct symbol referenced
+ *  by a compiled program to a slot in an array of values.
+ *
+ *  At entry:
+ *  @param program - pointer to program returned from
+ *  			   libExprsCompile().
+ *  @param bindCallback - function called once per distinct
+ *  					symbol name. *slotP arrives holding the
+ *  					symbol's number; the callback may
+ *  					change it to whatever slot index it
+ *  					likes or to -1 to leave the symbol
+ *  					unbound. Returning non-zero aborts the
+ *  					binding with that error. If NULL, each
+ *  					symbol is bound to the slot matching its
+ *  					number.
+ *  @param bindArg - argument passed to bindCallback.
+ *
+ *  At exit:
+ *  @return 0 on success, else error.
+ *
+ *  @note Binding may be repeated at any time but modifies the
+ *  	  program, so it must not be done while the program is
+ *  	  being run by another thread. Several names may be bound
+ *  	  to the same slot. If the program was compiled with
+ *  	  EXPRS_FLG_JIT its native code is regenerated since the
+ *  	  slot numbers are built into it.
+ **/
+extern ExprsErrs_t libExprsBindSymbols(ExprsProgram_t *program, ExprsErrs_t (*bindCallback)(void *bindArg, const char *symName, int *slotP), void *bindArg);
+
+/** libExprsRunSlots - Evaluate a previously compiled program
+ *  getting and setting the values of bound symbols in an array
+ *  of slots instead of through the symGet/symSet callbacks.
+ *
+ *  At entry:
+ *  @param exprs - pointer to expression parser control as
+ *  			 returned from libExprsInit().
+ *  @param program - pointer to program returned from
+ *  			   libExprsCompile() and bound with
+ *  			   libExprsBindSymbols().
+ *  @param slots - pointer to array of values indexed by slot.
+ *  			 A slot with termType EXPRS_SYM_TERM_NULL is an
+ *  			 undefined symbol.
+ *  @param numSlots - number of entries in slots. Every bound
+ *  				symbol must have a slot less than this.
+ *  @param returnTerm - pointer to place into which to deposit
+ *  				  the result.
+ *  @param alreadyLocked - set to non-zero to indicate the mutex
+ *  					 lock on the ExprsDef_t has already been
+ *  					 performed by libExprsLock().
+ *
+ *  At exit:
+ *  @return 0 on success, else error. Results are the same as
+ *  		libExprsRun() would have produced with the slot values
+ *  		held in a symbol table.
+ *
+ *  @note Assignments to bound symbols are written into their
+ *  	  slots. A string assigned that way points into the
+ *  	  string pool of 'exprs' so it is only valid until the
+ *  	  next evaluation using 'exprs'. Symbols that are not
+ *  	  bound still go through the symGet/symSet callbacks.
+ **/
+extern ExprsErrs_t libExprsRunSlots(ExprsDef_t *exprs, const ExprsProgram_t *program, ExprsSymTerm_t *slots, int numSlots, ExprsTerm_t *returnTerm, int alreadyLocked);
+
+/** ExprsScratch_t - the working space (term stack and string
+ *  pool) needed to run a program. A compiled program is never
+ *  changed by running it, so any number of threads may run the
+ *  same program at once provided each uses its own scratch.
+ *  Contents are private to lib_exprs.c.
+ **/
+typedef struct ExprsScratch_t ExprsScratch_t;
+
+/** libExprsScratchCreate - create working space for one thread.
+ *
+ *  At entry:
+ *  @param exprs - pointer to expression parser control as
+ *  			 returned from libExprsInit(). Its callbacks and
+ *  			 pool increments are copied. It may be destroyed
+ *  			 before the scratch is freed.
+ *  @param scratchP - pointer to place to deposit the new
+ *  				scratch.
+ *  @param alreadyLocked - set to non-zero to indicate the mutex
+ *  					 lock on the ExprsDef_t has already been
+ *  					 performed by libExprsLock().
+ *
+ *  At exit:
+ *  @return 0 on success, else error.
+ **/
+extern ExprsErrs_t libExprsScratchCreate(ExprsDef_t *exprs, ExprsScratch_t **scratchP, int alreadyLocked);
+
+/** libExprsScratchFree - free working space.
+ *
+ *  At entry:
+ *  @param scratch - pointer returned by libExprsScratchCreate()
+ *  			   (NULL is ignored).
+ *
+ *  At exit:
+ *  @return nothing.
+ **/
+extern void libExprsScratchFree(ExprsScratch_t *scratch);
+
+/** libExprsScratchStringPoolTop - get the base of a scratch's
+ *  string pool.
+ *
+ *  At entry:
+ *  @param scratch - pointer returned by libExprsScratchCreate()
+ *
+ *  At exit:
+ *  @return pointer to the string pool. A string result from
+ *  		libExprsRunScratch() is at this plus its
+ *  		term.string.
+ **/
+extern char *libExprsScratchStringPoolTop(ExprsScratch_t *scratch);
+
+/** libExprsRunScratch - Evaluate a previously compiled program
+ *  using the given working space. No lock is taken.
+ *
+ *  At entry:
+ *  @param scratch - pointer returned by libExprsScratchCreate().
+ *  			   It must not be in use by any other thread.
+ *  @param program - pointer to program returned from
+ *  			   libExprsCompile().
+ *  @param returnTerm - pointer to place into which to deposit
+ *  				  the result.
+ *
+ *  At exit:
+ *  @return same as libExprsRun().
+ *
+ *  @note Symbols are got and set through the symGet/symSet
+ *  	  callbacks copied when the scratch was created, so
+ *  	  those must be safe to call from several threads if
+ *  	  the program uses symbols. Statements are always run in
+ *  	  turn on the calling thread (see libExprsSetThreads()).
+ **/
+extern ExprsErrs_t libExprsRunScratch(ExprsScratch_t *scratch, const ExprsProgram_t *program, ExprsTerm_t *returnTerm);
+
+/** libExprsRunSlotsScratch - Same as libExprsRunSlots() but
+ *  using the given working space. No lock is taken.
+ *
+ *  At entry:
+ *  @param scratch - pointer returned by libExprsScratchCreate().
+ *  			   It must not be in use by any other thread.
+ *  (The other parameters are as for libExprsRunSlots().)
+ *
+ *  At exit:
+ *  @return same as libExprsRunSlots(). Strings assigned to slots
+ *  		point into the scratch's string pool.
+ *
+ *  @note Bind the symbols before sharing the program between
+ *  	  threads. libExprsBindSymbols() changes the program.
+ **/
+extern ExprsErrs_t libExprsRunSlotsScratch(ExprsScratch_t *scratch, const ExprsProgram_t *program, ExprsSymTerm_t *slots, int numSlots, ExprsTerm_t *returnTerm);
+
+/** ExprsCtxPool_t - a thread-safe pool of parser contexts for
+ *  programs (servers, say) that want a context per request
+ *  without paying for libExprsInit() and the growth of its term
+ *  and string pools every time. Each thread keeps a few idle
+ *  contexts of its own so acquiring and releasing normally takes
+ *  no lock. Contents are private to lib_exprs.c.
+ **/
+typedef struct ExprsCtxPool_t ExprsCtxPool_t;
+
+/** libExprsCtxPoolCreate - create a pool of parser contexts.
+ *
+ *  At entry:
+ *  @param callbacks - callbacks given to every context (as for
+ *  				 libExprsInit()).
+ *  @param termIncs - term pool increment (as for libExprsInit()).
+ *  @param stringIncs - string pool increment (as for
+ *  				  libExprsInit()).
+ *  @param numWarm - number of contexts to create up front.
+ *  @param poolP - pointer to place to deposit the new pool.
+ *
+ *  At exit:
+ *  @return 0 on success, else error.
+ **/
+extern ExprsErrs_t libExprsCtxPoolCreate(const ExprsCallbacks_t *callbacks, int termIncs, int stringIncs, int numWarm, ExprsCtxPool_t **poolP);
+
+/** libExprsCtxPoolFree - free a pool and all its contexts.
+ *
+ *  At entry:
+ *  @param pool - pointer returned by libExprsCtxPoolCreate()
+ *  			(NULL is ignored). No other thread may be using
+ *  			it and every acquired context should have been
+ *  			released.
+ *
+ *  At exit:
+ *  @return 0.
+ **/
+extern ExprsErrs_t libExprsCtxPoolFree(ExprsCtxPool_t *pool);
+
+/** libExprsCtxAcquire - get a context from a pool.
+ *
+ *  At entry:
+ *  @param pool - pointer returned by libExprsCtxPoolCreate().
+ *  @param exprsP - pointer to place to deposit the context.
+ *
+ *  At exit:
+ *  @return 0 on success, else error.
+ *
+ *  @note The context is as libExprsInit() would return it
+ *  	  except its pools may already have grown. It belongs to
+ *  	  the caller until given to libExprsCtxRelease(), so it
+ *  	  can be used without being locked.
+ **/
+extern ExprsErrs_t libExprsCtxAcquire(ExprsCtxPool_t *pool, ExprsDef_t **exprsP);
+
+/** libExprsCtxRelease - return a context to its pool.
+ *
+ *  At entry:
+ *  @param pool - pointer returned by libExprsCtxPoolCreate().
+ *  @param exprs - pointer returned by libExprsCtxAcquire() on
+ *  			 any thread.
+ *
+ *  At exit:
+ *  @return 0 on success, else error.
+ *
+ *  @note Flags, radix, verbose, delimiters, callbacks and the
+ *  	  user args are put back as they were. Memory the context
+ *  	  has grown is kept, as is any cache or threads given to
+ *  	  it by libExprsSetCacheSize() or libExprsSetThreads().
+ *  	  Strings returned from the context become invalid.
+ **/
+extern ExprsErrs_t libExprsCtxRelease(ExprsCtxPool_t *pool, ExprsDef_t *exprs);
+
+/** ExprsColumn_t - an array of values of one type as used by
+ *  libExprsEvalBatch().
+ **/
+typedef struct
+{
+	ExprsSymTermTypes_t termType;	/* EXPRS_SYM_TERM_INTEGER or EXPRS_SYM_TERM_FLOAT */
+	union
+	{
+		long *s64;
+		double *f64;
+	} data;
+} ExprsColumn_t;
+
+/** libExprsEvalBatch - Evaluate a previously compiled program
+ *  over many rows of symbol values.
+ *
+ *  At entry:
+ *  @param exprs - pointer to expression parser control as
+ *  			 returned from libExprsInit().
+ *  @param program - pointer to program returned from
+ *  			   libExprsCompile() and bound with
+ *  			   libExprsBindSymbols().
+ *  @param nRows - number of rows to compute.
+ *  @param columns - pointer to array of input columns indexed
+ *  			   by slot. Each must hold nRows values.
+ *  @param numColumns - number of entries in columns.
+ *  @param out - pointer to column into which to deposit the
+ *  		   nRows results. data must point to room for nRows
+ *  		   values of 8 bytes each. termType is set to the type
+ *  		   of the results.
+ *  @param alreadyLocked - set to non-zero to indicate the mutex
+ *  					 lock on the ExprsDef_t has already been
+ *  					 performed by libExprsLock().
+ *
+ *  At exit:
+ *  @return 0 on success, else error of the first row that
+ *  		failed. Rows before that one will have been stored in
+ *  		out and the failing row number reported via msgOut.
+ *
+ *  @note Each row produces exactly what libExprsRunSlots()
+ *  	  would have with the slots holding that row's values.
+ *  	  A program holding a single statement of integer and
+ *  	  float operations on constants and bound symbols is
+ *  	  computed an operator at a time over blocks of rows.
+ *  	  Anything else (assignments, strings, unbound symbols,
+ *  	  several statements or verbose mode) is run a row at a
+ *  	  time. Results other than integer or float are an
+ *  	  error, as is a mix of the two.
+ **/
+extern ExprsErrs_t libExprsEvalBatch(ExprsDef_t *exprs, const ExprsProgram_t *program, int nRows, const ExprsColumn_t *columns, int numColumns, ExprsColumn_t *out, int alreadyLocked);
+
+#define EXPRS_BATCH_ISA_SCALAR	0	/*! Plain C */
+#define EXPRS_BATCH_ISA_SSE42	1	/*! SSE4.2 (2 rows at a time) */
+#define EXPRS_BATCH_ISA_AVX2	2	/*! AVX2 (4 rows at a time) */
+
+/** libExprsSetBatchIsa - limit which vector instructions
+ *  libExprsEvalBatch() may use.
+ *
+ *  At entry:
+ *  @param maxIsa - one of EXPRS_BATCH_ISA_xxx. By default the
+ *  			  best one the CPU supports is used.
+ *
+ *  At exit:
+ *  @return the EXPRS_BATCH_ISA_xxx now in use. It is the best
+ *  		one that is both supported by the CPU and not above
+ *  		maxIsa.
+ *
+ *  @note This is a process wide setting and is not thread
+ *  	  safe. Call it before any batches are started. Results
+ *  	  are identical whichever is used.
+ **/
+extern int libExprsSetBatchIsa(int maxIsa);
+
+#define EXPRS_LEX_ISA_SCALAR	0	/*! Plain C */
+#define EXPRS_LEX_ISA_SSSE3		1	/*! SSSE3 (16 characters at a time) */
+#define EXPRS_LEX_ISA_AVX2		2	/*! AVX2 (32 characters at a time) */
+
+/** libExprsSetLexIsa - limit which vector instructions the
+ *  parser may use to skip over symbol names, white space and
+ *  the insides of quoted strings.
+ *
+ *  At entry:
+ *  @param maxIsa - one of EXPRS_LEX_ISA_xxx. By default the
+ *  			  best one the CPU supports is used.
+ *
+ *  At exit:
+ *  @return the EXPRS_LEX_ISA_xxx now in use. It is the best
+ *  		one that is both supported by the CPU and not above
+ *  		maxIsa.
+ *
+ *  @note This is a process wide setting and is not thread
+ *  	  safe. Call it before any parsing is started. Results
+ *  	  are identical whichever is used.
+ **/
+extern int libExprsSetLexIsa(int maxIsa);
+
+/** libExprsFreeProgram - free a program returned from
+ *  libExprsCompile().
+ *
+ *  At entry:
+ *  @param program - pointer to program to free. May be NULL.
+ *
+ *  At exit:
+ *  @return nothing. The memory has been returned using the
+ *  		memFree callback in effect when it was compiled.
+ **/
+extern void libExprsFreeProgram(ExprsProgram_t *program);
+
+/** ExprsCacheStats_t - counters of the program cache used by
+ *  libExprsEval().
+ **/
+typedef struct
+{
+	unsigned long hits;				/*! Number of times a text was found already compiled */
+	unsigned long misses;			/*! Number of times a text had to be compiled */
+	unsigned long evictions;		/*! Number of programs dropped to make room for another */
+	int numEntries;					/*! Number of programs in the cache */
+	int maxEntries;					/*! Most programs the cache will hold */
+} ExprsCacheStats_t;
+
+/** libExprsSetCacheSize - set the number of compiled programs
+ *  libExprsEval() keeps around.
+ *
+ *  At entry:
+ *  @param exprs - pointer to expression parser control as
+ *  			 returned from libExprsInit().
+ *  @param maxEntries - most programs to keep. 0 turns the cache
+ *  				  off (which is the default).
+ *  @param alreadyLocked - set to non-zero to indicate the mutex
+ *  					 lock on the ExprsDef_t has already been
+ *  					 performed by libExprsLock().
+ *
+ *  At exit:
+ *  @return 0 on success, else error. Any programs already
+ *  		cached are freed and the counters are cleared.
+ *
+ *  @note With a cache libExprsEval() compiles each text it is
+ *  	  given and keeps the program, dropping the least
+ *  	  recently used one when full. A text given again with
+ *  	  the same flags, radix and delimiters is run without
+ *  	  being parsed. Differences in white space that can't
+ *  	  change the meaning (i.e. "a + b" vs. "a+b") are
+ *  	  ignored. Results, errors and the pointers into 'text'
+ *  	  are the same as without a cache. Texts with parse
+ *  	  errors are not cached and verbose mode bypasses the
+ *  	  cache.
+ **/
+extern ExprsErrs_t libExprsSetCacheSize(ExprsDef_t *exprs, int maxEntries, int alreadyLocked);
+
+/** libExprsGetCacheStats - get the counters of the program
+ *  cache.
+ *
+ *  At entry:
+ *  @param exprs - pointer to expression parser control as
+ *  			 returned from libExprsInit().
+ *  @param stats - pointer to place to deposit the counters.
+ *  @param alreadyLocked - set to non-zero to indicate the mutex
+ *  					 lock on the ExprsDef_t has already been
+ *  					 performed by libExprsLock().
+ *
+ *  At exit:
+ *  @return 0 on success, else error. All counters are 0 if
+ *  		there is no cache.
+ **/
+extern ExprsErrs_t libExprsGetCacheStats(ExprsDef_t *exprs, ExprsCacheStats_t *stats, int alreadyLocked);
+
+/** ExprsDeps_t - a set of compiled formulas along with which
+ *  symbols each one reads and assigns so that when a symbol
+ *  changes only the formulas downstream of it need be run
+ *  again. Contents are private to lib_exprs.c.
+ **/
+typedef struct ExprsDeps_t ExprsDeps_t;
+
+/** libExprsDepsCreate - create an empty set of formulas.
+ *
+ *  At entry:
+ *  @param exprs - pointer to expression parser control as
+ *  			 returned from libExprsInit(). It is used to
+ *  			 compile and run the formulas and must not be
+ *  			 destroyed before the set is freed.
+ *  @param depsP - pointer to place to deposit the new set.
+ *
+ *  At exit:
+ *  @return 0 on success, else error.
+ **/
+extern ExprsErrs_t libExprsDepsCreate(ExprsDef_t *exprs, ExprsDeps_t **depsP);
+
+/** libExprsDepsAdd - compile a formula and add it to the set.
+ *
+ *  At entry:
+ *  @param deps - pointer to set returned from
+ *  			libExprsDepsCreate().
+ *  @param text - formula (i.e. "c=a+b" or "t=a*2;d=t+1").
+ *  @param formulaP - pointer to place to deposit the formula's
+ *  				index in the set. May be NULL.
+ *  @param alreadyLocked - set to non-zero to indicate the mutex
+ *  					 lock on the ExprsDef_t has already been
+ *  					 performed by libExprsLock().
+ *
+ *  At exit:
+ *  @return 0 on success, else error. EXPR_TERM_BAD_CYCLE means
+ *  		one of the symbols the formula assigns is already
+ *  		used, through the other formulas, to compute one it
+ *  		reads. The formula is not added in that case.
+ *
+ *  @note The formula is not run here. It is marked as needing
+ *  	  to run at the next libExprsDepsUpdate(). A symbol a
+ *  	  formula reads before it assigns it (i.e. "n=n+1" or
+ *  	  "d=t+1;t=a*3") is one of its inputs as well, so a
+ *  	  change to it from outside runs the formula again. The
+ *  	  formula's own assignment to it does not.
+ **/
+extern ExprsErrs_t libExprsDepsAdd(ExprsDeps_t *deps, const char *text, int *formulaP, int alreadyLocked);
+
+/** libExprsDepsChanged - note that a symbol has been changed
+ *  from outside the set of formulas.
+ *
+ *  At entry:
+ *  @param deps - pointer to set returned from
+ *  			libExprsDepsCreate().
+ *  @param symName - name of symbol that has changed.
+ *  @param alreadyLocked - set to non-zero to indicate the mutex
+ *  					 lock on the ExprsDef_t has already been
+ *  					 performed by libExprsLock().
+ *
+ *  At exit:
+ *  @return 0 on success, else error. Every formula reading the
+ *  		symbol is marked as needing to run. It is not an
+ *  		error if no formula reads it.
+ **/
+extern ExprsErrs_t libExprsDepsChanged(ExprsDeps_t *deps, const char *symName, int alreadyLocked);
+
+/** libExprsDepsUpdate - run the formulas marked as needing to
+ *  run and all those downstream of them.
+ *
+ *  At entry:
+ *  @param deps - pointer to set returned from
+ *  			libExprsDepsCreate().
+ *  @param numRunP - pointer to place to deposit the number of
+ *  			   formulas run. May be NULL.
+ *  @param alreadyLocked - set to non-zero to indicate the mutex
+ *  					 lock on the ExprsDef_t has already been
+ *  					 performed by libExprsLock().
+ *
+ *  At exit:
+ *  @return 0 on success, else error from the first formula
+ *  		that failed. A formula that fails and everything
+ *  		downstream of it are not run and stay marked so a
+ *  		later update retries them. The other formulas are
+ *  		still brought up to date.
+ *
+ *  @note Formulas are run in dependency order so each is run
+ *  	  at most once per update with its inputs already up to
+ *  	  date. The new values are stored using the symSet
+ *  	  callback as usual.
+ **/
+extern ExprsErrs_t libExprsDepsUpdate(ExprsDeps_t *deps, int *numRunP, int alreadyLocked);
+
+/** libExprsDepsFree - free a set of formulas.
+ *
+ *  At entry:
+ *  @param deps - pointer to set returned from
+ *  			libExprsDepsCreate(). May be NULL.
+ *
+ *  At exit:
+ *  @return nothing.
+ **/
+extern void libExprsDepsFree(ExprsDeps_t *deps);
+
 /** libExprsXXXPoolTop - get the pointers to the tops of the
  *  various pools.
  *
@@ -20,8 +20,16 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <stdint.h>
 #include "lib_hashtbl.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HASH_FLAT_SSE2 (1)
+#else
+#define HASH_FLAT_SSE2 (0)
+#endif
+
 /* */
 typedef unsigned char Bool;
 typedef enum
@@ -68,13 +76,405 @@ static void lclFree(void *arg, void *ptr)
 	free(ptr);
 }
 
+/* Chain nodes are carved out of blocks of POOL_BLOCK_SIZE of them */
+typedef struct HashBlock_t
+{
+	struct HashBlock_t *next;
+	HashPrimitive_t nodes[POOL_BLOCK_SIZE];
+} HashBlock_t;
+
+#ifndef HASH_DEFAULT_GROW_LOAD
+#define HASH_DEFAULT_GROW_LOAD (100)	/* grow when there are more entries than this percentage of the table size */
+#endif
+#ifndef HASH_DEFAULT_SHRINK_LOAD
+#define HASH_DEFAULT_SHRINK_LOAD (25)	/* shrink when there are fewer entries than this percentage of the table size */
+#endif
+#ifndef HASH_MAX_TABLE_SIZE
+#define HASH_MAX_TABLE_SIZE (0x3FFFFFFF)	/* never grow past this */
+#endif
+#ifndef HASH_REHASH_STEP
+#define HASH_REHASH_STEP (4)			/* number of old buckets moved per operation while resizing */
+#endif
+
 static void lclMsg(void *msgArg, HashMsgSeverity_t severity, const char *msg)
 {
 	static const char *Severities[] = { "INFO", "WARN", "ERROR", "FATAL" };
 	fprintf(severity > HASH_SEVERITY_INFO ? stderr:stdout,"%s-libHash: %s",Severities[severity],msg);
 }
 
+#define HASH_FULL_RANGE (0x7FFFFFFF)	/* table size given to symHash() to get a full width hash */
+
+/* Every entry is hashed once per call and the full hash kept (in the node
+ * or, for the flat table, 7 bits of it in the control byte) so resizing
+ * never hashes again and most non-matching entries are passed over without
+ * calling symCmp(). symHash() need only spread entries over the size it is
+ * given so ask for the widest size it can do then mix the bits (murmur3's
+ * finalizer) so the low bits used to pick a chain or tag get a share of
+ * all of them. */
+static unsigned int entryHash(const HashRoot_t *pTable, const HashEntry_t entry)
+{
+	unsigned int hh = pTable->callbacks.symHash(pTable->callbacks.symArg, HASH_FULL_RANGE, entry);
+	hh ^= hh >> 16;
+	hh *= 0x85EBCA6Bu;
+	hh ^= hh >> 13;
+	hh *= 0xC2B2AE35u;
+	hh ^= hh >> 16;
+	return hh;
+}
+
+/*
+ * The flat (HASHTBL_FLG_FLAT) table. Entries live directly in an array of
+ * slots split into groups of HASH_FLAT_GROUP. Each slot has a control
+ * byte that is either FLAT_EMPTY, FLAT_DELETED or the low 7 bits of the
+ * entry's hash (its tag). A lookup picks a group from the rest of the hash
+ * and compares the tag against all the control bytes of the group at once,
+ * only calling symCmp() for slots whose tag matches. Groups are probed in
+ * triangular order until one with an empty slot is seen.
+ */
+#define HASH_FLAT_GROUP (16)
+#define FLAT_EMPTY (0x80)
+#define FLAT_DELETED (0xFE)
+
+/* bit n set if control byte n of the group equals cc */
+static unsigned int flatMatch(const unsigned char *ctrl, unsigned char cc)
+{
+#if HASH_FLAT_SSE2
+	__m128i grp = _mm_loadu_si128((const __m128i *)ctrl);
+	return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(grp, _mm_set1_epi8((char)cc)));
+#else
+	unsigned int ii, mask=0;
+	for (ii=0; ii < HASH_FLAT_GROUP; ++ii)
+	{
+		if ( ctrl[ii] == cc )
+			mask |= 1u << ii;
+	}
+	return mask;
+#endif
+}
+
+/* bit n set if slot n of the group is empty or deleted (the only control bytes with bit 7 set) */
+static unsigned int flatMatchFree(const unsigned char *ctrl)
+{
+#if HASH_FLAT_SSE2
+	return (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+#else
+	unsigned int ii, mask=0;
+	for (ii=0; ii < HASH_FLAT_GROUP; ++ii)
+	{
+		if ( (ctrl[ii] & 0x80) )
+			mask |= 1u << ii;
+	}
+	return mask;
+#endif
+}
+
+static int lowestBit(unsigned int mask)
+{
+#if defined(__GNUC__)
+	return __builtin_ctz(mask);
+#else
+	int ii=0;
+	while ( !(mask & 1) )
+	{
+		mask >>= 1;
+		++ii;
+	}
+	return ii;
+#endif
+}
+
+/** flatFind - find an entry in the flat table.
+ *  At Entry:
+ *  @param pTable - pointer to hash table
+ *  @param entry  - user's entry
+ *  @param hash   - entryHash() of entry
+ *  @param pFree  - optional pointer to place to deposit the
+ *  			  slot a new entry should go in
+ *
+ *  At exit:
+ *  @return index of slot holding entry or -1 if not found.
+ **/
+static int flatFind(const HashRoot_t *pTable, const HashEntry_t entry, unsigned int hash, int *pFree)
+{
+	unsigned int grpMask = pTable->hashTableSize/HASH_FLAT_GROUP - 1;
+	unsigned int grp = (hash >> 7) & grpMask, step, mask;
+	unsigned char tag = hash & 0x7F;
+	const unsigned char *ctrl;
+	int idx, freeIdx=-1;
+
+	for (step=1; step <= grpMask+1; ++step)
+	{
+		ctrl = pTable->ctrl + grp*HASH_FLAT_GROUP;
+		for (mask = flatMatch(ctrl, tag); mask; mask &= mask-1)
+		{
+			idx = grp*HASH_FLAT_GROUP + lowestBit(mask);
+			if ( !pTable->callbacks.symCmp(pTable->callbacks.symArg, pTable->slots[idx], entry) )
+				return idx;
+		}
+		if ( freeIdx < 0 && (mask = flatMatchFree(ctrl)) )
+			freeIdx = grp*HASH_FLAT_GROUP + lowestBit(mask);
+		if ( flatMatch(ctrl, FLAT_EMPTY) )
+			break;
+		grp = (grp + step) & grpMask;
+	}
+	if ( pFree )
+		*pFree = freeIdx;
+	return -1;
+}
+
+/* Allocate empty control bytes and slots for numSlots entries. Returns 0 on success. */
+static int flatAlloc(const HashRoot_t *pTable, int numSlots, unsigned char **pCtrl, HashEntry_t **pSlots)
+{
+	*pCtrl = (unsigned char *)pTable->callbacks.memAlloc(pTable->callbacks.memArg, numSlots);
+	*pSlots = (HashEntry_t *)pTable->callbacks.memAlloc(pTable->callbacks.memArg, sizeof(HashEntry_t)*numSlots);
+	if ( !*pCtrl || !*pSlots )
+	{
+		if ( *pCtrl )
+			pTable->callbacks.memFree(pTable->callbacks.memArg, *pCtrl);
+		if ( *pSlots )
+			pTable->callbacks.memFree(pTable->callbacks.memArg, *pSlots);
+		return 1;
+	}
+	memset(*pCtrl, FLAT_EMPTY, numSlots);
+	return 0;
+}
+
+/** flatResize - move every entry to a new set of slots.
+ *  At Entry:
+ *  @param pTable - pointer to hash table (locked)
+ *  @param numSlots - new number of slots (power of 2 multiple
+ *  				of HASH_FLAT_GROUP)
+ *
+ *  At exit:
+ *  @return 0 on success else HashOutOfMemory, in which case the
+ *  		table is unchanged.
+ **/
+static HashErrors_t flatResize(HashRoot_t *pTable, int numSlots)
+{
+	unsigned char *oldCtrl = pTable->ctrl;
+	HashEntry_t *oldSlots = pTable->slots;
+	unsigned int hash, grpMask, grp, step, mask;
+	int ii, idx, oldSize = pTable->hashTableSize;
+
+	if ( flatAlloc(pTable, numSlots, &pTable->ctrl, &pTable->slots) )
+	{
+		pTable->ctrl = oldCtrl;
+		pTable->slots = oldSlots;
+		return HashOutOfMemory;
+	}
+	pTable->hashTableSize = numSlots;
+	pTable->numDeleted = 0;
+	for (ii=0; ii < oldSize; ++ii)
+	{
+		if ( (oldCtrl[ii] & 0x80) )
+			continue;
+		/* No entry can match so this just finds the first free slot */
+		hash = entryHash(pTable, oldSlots[ii]);
+		grpMask = numSlots/HASH_FLAT_GROUP - 1;
+		grp = (hash >> 7) & grpMask;
+		for (step=1; !(mask = flatMatchFree(pTable->ctrl + grp*HASH_FLAT_GROUP)); ++step)
+			grp = (grp + step) & grpMask;
+		idx = grp*HASH_FLAT_GROUP + lowestBit(mask);
+		pTable->ctrl[idx] = hash & 0x7F;
+		pTable->slots[idx] = oldSlots[ii];
+	}
+	pTable->callbacks.memFree(pTable->callbacks.memArg, oldCtrl);
+	pTable->callbacks.memFree(pTable->callbacks.memArg, oldSlots);
+	return HashSuccess;
+}
+
+/** flatInsert - put an entry in the slot flatFind() said to.
+ *  At Entry:
+ *  @param pTable - pointer to hash table (locked)
+ *  @param entry  - user's entry
+ *  @param hash   - entryHash() of entry
+ *  @param idx    - free slot returned by flatFind()
+ *
+ *  At exit:
+ *  @return 0 on success else error code.
+ *
+ *  @note Full and deleted slots are kept to no more than 7/8
+ *  	  of the table so a probe always reaches an empty slot.
+ *  	  If adding this entry would break that, the table is
+ *  	  rebuilt first. It only grows if it is mostly entries
+ *  	  rather than deleted markers.
+ **/
+static HashErrors_t flatInsert(HashRoot_t *pTable, const HashEntry_t entry, unsigned int hash, int idx)
+{
+	if ( (long)(pTable->numEntries + pTable->numDeleted + 1)*8 > (long)pTable->hashTableSize*7 )
+	{
+		int newSize = pTable->hashTableSize;
+		if ( (long)(pTable->numEntries + 1)*16 > (long)newSize*7 && newSize < HASH_MAX_TABLE_SIZE/2 )
+			newSize *= 2;
+		if ( flatResize(pTable, newSize) )
+			return HashOutOfMemory;
+		flatFind(pTable, entry, hash, &idx);
+	}
+	if ( pTable->ctrl[idx] == FLAT_DELETED )
+		--pTable->numDeleted;
+	pTable->ctrl[idx] = hash & 0x7F;
+	pTable->slots[idx] = entry;
+	++pTable->numEntries;
+	return HashSuccess;
+}
+
+/* Insert an entry in the flat table or, if replace is set, replace the matching one */
+static HashErrors_t flatPut(HashRoot_t *pTable, const HashEntry_t entry, HashEntry_t *pExisting, int replace)
+{
+	unsigned int hash = entryHash(pTable, entry);
+	int idx, freeIdx;
+
+	if ( (idx = flatFind(pTable, entry, hash, &freeIdx)) < 0 )
+		return flatInsert(pTable, entry, hash, freeIdx);
+	if ( !replace )
+		return HashDuplicateSymbol;
+	if ( pExisting )
+		*pExisting = pTable->slots[idx];
+	pTable->slots[idx] = entry;
+	return HashSuccess;
+}
+
+/* Empty slot idx and shrink the table if it has got too sparse */
+static void flatDelete(HashRoot_t *pTable, int idx)
+{
+	const unsigned char *grp = pTable->ctrl + (idx & ~(HASH_FLAT_GROUP-1));
+
+	/* If the group already has an empty slot no probe ever went past it, so this one can be empty too */
+	if ( flatMatch(grp, FLAT_EMPTY) )
+		pTable->ctrl[idx] = FLAT_EMPTY;
+	else
+	{
+		pTable->ctrl[idx] = FLAT_DELETED;
+		++pTable->numDeleted;
+	}
+	pTable->slots[idx] = NULL;
+	--pTable->numEntries;
+	if (    pTable->shrinkLoad && pTable->hashTableSize > pTable->minTableSize
+		 && (long)pTable->numEntries*100 < (long)pTable->hashTableSize*pTable->shrinkLoad )
+		flatResize(pTable, pTable->hashTableSize/2);
+}
+
+/*
+ * Built-in callbacks for entries keyed by a null terminated string that is
+ * the first member of the entry. The hash is wyhash (final version 4): the
+ * key is read 8 bytes at a time (4 or fewer for short keys) and each pair of
+ * words is folded with one 64x64->128 bit multiply.
+ */
+static const uint64_t WyPrimes[4] = { 0x2D358DCCAA6C78A5ull, 0x8BB84B93962EACC9ull, 0x4B33A62ED433D4A3ull, 0x4D5A2DA51DE1AA47ull };
+
+static void wyMum(uint64_t *aa, uint64_t *bb)
+{
+#if defined(__SIZEOF_INT128__)
+	__extension__ unsigned __int128 rr = *aa;
+	rr *= *bb;
+	*aa = (uint64_t)rr;
+	*bb = (uint64_t)(rr >> 64);
+#else
+	uint64_t ha = *aa >> 32, hb = *bb >> 32, la = (uint32_t)*aa, lb = (uint32_t)*bb;
+	uint64_t rh = ha*hb, rm0 = ha*lb, rm1 = hb*la, rl = la*lb, tt = rl + (rm0 << 32), lo, hi;
+	hi = rh + (rm0 >> 32) + (rm1 >> 32) + (tt < rl);
+	lo = tt + (rm1 << 32);
+	hi += lo < tt;
+	*aa = lo;
+	*bb = hi;
+#endif
+}
+
+static uint64_t wyMix(uint64_t aa, uint64_t bb)
+{
+	wyMum(&aa, &bb);
+	return aa ^ bb;
+}
+
+static uint64_t wyRead8(const unsigned char *ptr)
+{
+	uint64_t vv;
+	memcpy(&vv, ptr, sizeof(vv));
+	return vv;
+}
+
+static uint64_t wyRead4(const unsigned char *ptr)
+{
+	uint32_t vv;
+	memcpy(&vv, ptr, sizeof(vv));
+	return vv;
+}
+
+uint64_t libHashBytes(const void *key, size_t len, uint64_t seed)
+{
+	const unsigned char *ptr = (const unsigned char *)key;
+	uint64_t aa, bb;
+	size_t ii;
+
+	seed ^= wyMix(seed ^ WyPrimes[0], WyPrimes[1]);
+	if ( len <= 16 )
+	{
+		if ( len >= 4 )
+		{
+			aa = (wyRead4(ptr) << 32) | wyRead4(ptr + ((len >> 3) << 2));
+			bb = (wyRead4(ptr + len - 4) << 32) | wyRead4(ptr + len - 4 - ((len >> 3) << 2));
+		}
+		else if ( len )
+		{
+			aa = ((uint64_t)ptr[0] << 16) | ((uint64_t)ptr[len >> 1] << 8) | ptr[len - 1];
+			bb = 0;
+		}
+		else
+			aa = bb = 0;
+	}
+	else
+	{
+		ii = len;
+		if ( ii > 48 )
+		{
+			uint64_t see1 = seed, see2 = seed;
+			do
+			{
+				seed = wyMix(wyRead8(ptr) ^ WyPrimes[1], wyRead8(ptr + 8) ^ seed);
+				see1 = wyMix(wyRead8(ptr + 16) ^ WyPrimes[2], wyRead8(ptr + 24) ^ see1);
+				see2 = wyMix(wyRead8(ptr + 32) ^ WyPrimes[3], wyRead8(ptr + 40) ^ see2);
+				ptr += 48;
+				ii -= 48;
+			} while ( ii > 48 );
+			seed ^= see1 ^ see2;
+		}
+		while ( ii > 16 )
+		{
+			seed = wyMix(wyRead8(ptr) ^ WyPrimes[1], wyRead8(ptr + 8) ^ seed);
+			ptr += 16;
+			ii -= 16;
+		}
+		aa = wyRead8(ptr + ii - 16);
+		bb = wyRead8(ptr + ii - 8);
+	}
+	aa ^= WyPrimes[1];
+	bb ^= seed;
+	wyMum(&aa, &bb);
+	return wyMix(aa ^ WyPrimes[0] ^ len, bb ^ WyPrimes[1]);
+}
+
+unsigned int libHashStrHash(void *symArg, int hashTableSize, const HashEntry_t entry)
+{
+	const char *key = *(const char * const *)entry;
+	uint64_t hh = libHashBytes(key, strlen(key), symArg ? *(const uint64_t *)symArg : 0);
+
+	return (unsigned int)(hh % (unsigned int)hashTableSize);
+}
+
+int libHashStrCmp(void *symArg, const HashEntry_t aa, const HashEntry_t bb)
+{
+	const char *keyA = *(const char * const *)aa, *keyB = *(const char * const *)bb;
+
+	/* Entries are only compared after their full hashes matched, so nearly every call here is between equal keys. */
+	return strcmp(keyA, keyB);
+}
+
 HashRoot_t* libHashInit(int tableSize, const HashCallbacks_t *callbacks)
+{
+	return libHashInitEx(tableSize, callbacks, 0);
+}
+
+HashRoot_t* libHashInitEx(int tableSize, const HashCallbacks_t *callbacks, int flags)
 {
 	HashRoot_t *tbl;
 	HashCallbacks_t tCallbacks;
@@ -123,16 +523,38 @@ HashRoot_t* libHashInit(int tableSize, const HashCallbacks_t *callbacks)
 	if ( tableSize <= 0 )
 		tableSize = 997;
 	tbl->callbacks = tCallbacks;
-	tbl->hashTable = (HashPrimitive_t **)tCallbacks.memAlloc(tCallbacks.memArg, sizeof(HashPrimitive_t *)*tableSize);
-	if ( !tbl->hashTable )
+	tbl->flags = flags;
+	if ( (flags & HASHTBL_FLG_FLAT) )
 	{
-		snprintf(emsg,sizeof(emsg),"Not enough memory to allocate %ld bytes for %d hash table slots\n", sizeof(HashPrimitive_t *)*tableSize, tableSize);
-		tCallbacks.msgOut(tCallbacks.msgArg,HASH_SEVERITY_FATAL,emsg);
-		tCallbacks.memFree(tCallbacks.memArg, tbl);
-		return NULL;
+		int numSlots = HASH_FLAT_GROUP;
+		/* Round up to a power of 2 so the group index is just masked off the hash */
+		while ( numSlots < tableSize && numSlots < HASH_MAX_TABLE_SIZE/2 )
+			numSlots *= 2;
+		if ( flatAlloc(tbl, numSlots, &tbl->ctrl, &tbl->slots) )
+		{
+			snprintf(emsg,sizeof(emsg),"Not enough memory to allocate %d flat hash table slots\n", numSlots);
+			tCallbacks.msgOut(tCallbacks.msgArg,HASH_SEVERITY_FATAL,emsg);
+			tCallbacks.memFree(tCallbacks.memArg, tbl);
+			return NULL;
+		}
+		tableSize = numSlots;
+	}
+	else
+	{
+		tbl->hashTable = (HashPrimitive_t **)tCallbacks.memAlloc(tCallbacks.memArg, sizeof(HashPrimitive_t *)*tableSize);
+		if ( !tbl->hashTable )
+		{
+			snprintf(emsg,sizeof(emsg),"Not enough memory to allocate %ld bytes for %d hash table slots\n", sizeof(HashPrimitive_t *)*tableSize, tableSize);
+			tCallbacks.msgOut(tCallbacks.msgArg,HASH_SEVERITY_FATAL,emsg);
+			tCallbacks.memFree(tCallbacks.memArg, tbl);
+			return NULL;
+		}
+		memset(tbl->hashTable, 0, sizeof(HashPrimitive_t *)*tableSize);
 	}
-	memset(tbl->hashTable, 0, sizeof(HashPrimitive_t *)*tableSize);
 	tbl->hashTableSize = tableSize;
+	tbl->minTableSize = tableSize;
+	tbl->growLoad = HASH_DEFAULT_GROW_LOAD;
+	tbl->shrinkLoad = HASH_DEFAULT_SHRINK_LOAD;
 	pthread_mutex_init(&tbl->lock,NULL);
 	tbl->numEntries = 0;
 	return tbl;
@@ -140,6 +562,7 @@ HashRoot_t* libHashInit(int tableSize, const HashCallbacks_t *callbacks)
 
 HashErrors_t libHashDestroy(HashRoot_t *pTable, void (*entry_free_fn)(void *freeArg, HashEntry_t entry), void *freeArg)
 {
+	HashBlock_t *pBlock;
 	int ii;
 	HashErrors_t err;
 	void (*memFree)(void *memArg, void *ptr) = pTable->callbacks.memFree;
@@ -148,22 +571,34 @@ HashErrors_t libHashDestroy(HashRoot_t *pTable, void (*entry_free_fn)(void *free
 	pTable->verbose |= HASHTBL_VERBOSE_ERROR;
 	if ( !(err=libHashLock(pTable)) )
 	{
-		for (ii = 0; ii < pTable->hashTableSize; ++ii)
+		for (ii=0; pTable->ctrl && ii < pTable->hashTableSize; ++ii)
 		{
-			HashPrimitive_t *pHash, *pNext;
-			pNext = pTable->hashTable[ii];
-			while ( (pHash=pNext) )
-			{
-				if ( entry_free_fn )
-					entry_free_fn(freeArg, pHash->entry);
-				pNext = pHash->next;
-				pHash->entry = NULL;
-				pHash->next = NULL;
-				pHash->prev = NULL;
-				memFree(memArg,pHash);
-			}
+			if ( entry_free_fn && !(pTable->ctrl[ii] & 0x80) )
+				entry_free_fn(freeArg, pTable->slots[ii]);
+		}
+		/* The chain nodes go with their blocks so the chains only need walking if the entries are to be freed */
+		for (ii = pTable->oldTable ? -pTable->oldTableSize : 0; entry_free_fn && pTable->hashTable && ii < pTable->hashTableSize; ++ii)
+		{
+			HashPrimitive_t *pHash;
+			/* Negative indices are the old table (while resizing) */
+			pHash = ii < 0 ? pTable->oldTable[pTable->oldTableSize + ii] : pTable->hashTable[ii];
+			for ( ; pHash; pHash = pHash->next )
+				entry_free_fn(freeArg, pHash->entry);
+		}
+		while ( (pBlock = pTable->blocks) )
+		{
+			pTable->blocks = pBlock->next;
+			memFree(memArg,pBlock);
+		}
+		if ( pTable->oldTable )
+			memFree(memArg,pTable->oldTable);
+		if ( pTable->hashTable )
+			memFree(memArg,pTable->hashTable);
+		if ( pTable->ctrl )
+		{
+			memFree(memArg,pTable->ctrl);
+			memFree(memArg,pTable->slots);
 		}
-		memFree(memArg,pTable->hashTable);
 		pthread_mutex_unlock(&pTable->lock);
 		pthread_mutex_destroy(&pTable->lock);
 		memFree(memArg,pTable);
@@ -177,31 +612,36 @@ typedef struct
 	HashPrimitive_t **ppHash;	/* Pointer to previous pointer (or to hash table entry if appropriate) */
 	HashPrimitive_t *pCurr;		/* Pointer to place where entry is found or place where new is to be inserted */
 	int diff;					/* result of compare */
+	unsigned int hash;			/* entryHash() of the entry */
 	unsigned int hashIdx;		/* index into hash table */
 } FindTbl_t;
 
-/** findPlace - find the place in the hash tree where an
+/** findInTable - find the place in the given table where an
  *  entry either is or would be placed if it isn't there.
  *  At Entry:
  *  @param pTable - pointer to hash table
+ *  @param table  - pointer to array of chains (hashTable or
+ *  			  oldTable)
+ *  @param tableSize - number of chains in table
  *  @param entry  - user's entry
- *  @param param  - pointer to FindTbl_t struct
+ *  @param param  - pointer to FindTbl_t struct with hash set
  *
  *  At exit:
  *  @return pointer to found entry or NULL if none found.
+ *
+ *  @note Chains are sorted by hash then, for equal hashes, by
+ *  	  symCmp() so symCmp() is only called on entries whose
+ *  	  hash is the same as the one being looked for.
  **/
-static HashPrimitive_t* findPlace(const HashRoot_t *pTable, const HashEntry_t entry, FindTbl_t *param)
+static HashPrimitive_t* findInTable(const HashRoot_t *pTable, HashPrimitive_t **table, int tableSize, const HashEntry_t entry, FindTbl_t *param)
 {
 	HashPrimitive_t **ppPrev, *pHashEntry;
 
 	param->diff = -1;
 	/* Find the index into the hash table */
-	param->hashIdx = pTable->callbacks.symHash(pTable->callbacks.symArg, pTable->hashTableSize, entry);
-	/* make sure the result is valid */
-	if ( param->hashIdx >= pTable->hashTableSize )
-		param->hashIdx = 0;
+	param->hashIdx = param->hash % tableSize;
 	/* get a pointer to the position in the hash table */
-	ppPrev = &pTable->hashTable[param->hashIdx];
+	ppPrev = &table[param->hashIdx];
 	/* return it to caller */
 	param->ppHash = ppPrev;
 	/* Start at the head of the list */
@@ -211,7 +651,10 @@ static HashPrimitive_t* findPlace(const HashRoot_t *pTable, const HashEntry_t en
 	/* loop through the list */
 	while ( pHashEntry )
 	{
-		param->diff = pTable->callbacks.symCmp(pTable->callbacks.symArg, pHashEntry->entry, entry);
+		if ( pHashEntry->hash != param->hash )
+			param->diff = pHashEntry->hash < param->hash ? -1 : 1;
+		else
+			param->diff = pTable->callbacks.symCmp(pTable->callbacks.symArg, pHashEntry->entry, entry);
 		if ( param->diff < 0 )
 		{
 			/* the list is stored sorted, low to high. The insert is to be later in the list */
@@ -232,6 +675,33 @@ static HashPrimitive_t* findPlace(const HashRoot_t *pTable, const HashEntry_t en
 	return pHashEntry;
 }
 
+/** findPlace - find the place in the hash tree where an
+ *  entry either is or would be placed if it isn't there.
+ *  At Entry:
+ *  @param pTable - pointer to hash table
+ *  @param entry  - user's entry
+ *  @param param  - pointer to FindTbl_t struct
+ *
+ *  At exit:
+ *  @return pointer to found entry or NULL if none found.
+ *  		param->hash is the entry's hash.
+ *
+ *  @note While resizing, whole chains are moved from oldTable
+ *  	  to hashTable in index order. So an entry whose chain
+ *  	  in oldTable has not been moved yet is there and
+ *  	  nowhere else.
+ **/
+static HashPrimitive_t* findPlace(const HashRoot_t *pTable, const HashEntry_t entry, FindTbl_t *param)
+{
+	param->hash = entryHash(pTable, entry);
+	if ( pTable->oldTable )
+	{
+		if ( param->hash % pTable->oldTableSize >= pTable->rehashIdx )
+			return findInTable(pTable, pTable->oldTable, pTable->oldTableSize, entry, param);
+	}
+	return findInTable(pTable, pTable->hashTable, pTable->hashTableSize, entry, param);
+}
+
 /*
  * Get the next available HashPrimitive_t either from the
  * pool or from the list of those previously deleted.
@@ -239,8 +709,23 @@ static HashPrimitive_t* findPlace(const HashRoot_t *pTable, const HashEntry_t en
 static HashPrimitive_t *getNewEntry(HashRoot_t *pTable )
 {
 	HashPrimitive_t *pNewEntry;
+	HashBlock_t *pBlock;
 	
-	pNewEntry = (HashPrimitive_t *)pTable->callbacks.memAlloc(pTable->callbacks.memArg, sizeof(HashPrimitive_t));
+	if ( (pNewEntry = pTable->freeList) )
+		pTable->freeList = pNewEntry->next;
+	else
+	{
+		if ( !pTable->blocks || pTable->blockUsed >= POOL_BLOCK_SIZE )
+		{
+			pBlock = (HashBlock_t *)pTable->callbacks.memAlloc(pTable->callbacks.memArg, sizeof(HashBlock_t));
+			if ( !pBlock )
+				return NULL;
+			pBlock->next = pTable->blocks;
+			pTable->blocks = pBlock;
+			pTable->blockUsed = 0;
+		}
+		pNewEntry = pTable->blocks->nodes + pTable->blockUsed++;
+	}
 	pNewEntry->entry = NULL;
 	pNewEntry->next = NULL;
 	pNewEntry->prev = NULL;
@@ -276,6 +761,102 @@ static HashErrors_t internalInsert(HashRoot_t *pTable, FindTbl_t *pFtbl, HashPri
 	return HashSuccess;
 }
 
+/** rehashStep - move a few chains from oldTable to hashTable
+ *  if a resize is in progress.
+ *  At Entry:
+ *  @param pTable - pointer to hash table (locked)
+ *
+ *  At exit:
+ *  @return nothing. oldTable is freed once it is empty.
+ **/
+static void rehashStep(HashRoot_t *pTable)
+{
+	HashPrimitive_t *pHash, *pNext;
+	FindTbl_t fTbl;
+	int moved=0, empties=HASH_REHASH_STEP*10;
+
+	while ( pTable->oldTable && moved < HASH_REHASH_STEP && empties > 0 )
+	{
+		pNext = pTable->oldTable[pTable->rehashIdx];
+		if ( !pNext )
+			--empties;
+		else
+			++moved;
+		while ( (pHash = pNext) )
+		{
+			pNext = pHash->next;
+			pHash->next = NULL;
+			pHash->prev = NULL;
+			fTbl.hash = pHash->hash;
+			findInTable(pTable, pTable->hashTable, pTable->hashTableSize, pHash->entry, &fTbl);
+			internalInsert(pTable, &fTbl, pHash);
+		}
+		pTable->oldTable[pTable->rehashIdx] = NULL;
+		if ( ++pTable->rehashIdx >= pTable->oldTableSize )
+		{
+			pTable->callbacks.memFree(pTable->callbacks.memArg, pTable->oldTable);
+			pTable->oldTable = NULL;
+			pTable->oldTableSize = 0;
+			pTable->rehashIdx = 0;
+		}
+	}
+}
+
+/** checkResize - start a resize if numEntries has moved past
+ *  either load factor and one isn't already under way.
+ *  At Entry:
+ *  @param pTable - pointer to hash table (locked)
+ *
+ *  At exit:
+ *  @return nothing. If there isn't memory for a new table the
+ *  		current one is kept and the next change tries again.
+ **/
+static void checkResize(HashRoot_t *pTable)
+{
+	HashPrimitive_t **newTable;
+	long load;
+	int newSize;
+
+	if ( pTable->oldTable )
+		return;
+	load = (long)pTable->numEntries*100;
+	if ( pTable->growLoad && load > (long)pTable->hashTableSize*pTable->growLoad && pTable->hashTableSize < HASH_MAX_TABLE_SIZE )
+		newSize = pTable->hashTableSize*2+1;
+	else if ( pTable->shrinkLoad && pTable->hashTableSize > pTable->minTableSize && load < (long)pTable->hashTableSize*pTable->shrinkLoad )
+	{
+		newSize = (pTable->hashTableSize-1)/2;
+		if ( newSize < pTable->minTableSize )
+			newSize = pTable->minTableSize;
+	}
+	else
+		return;
+	newTable = (HashPrimitive_t **)pTable->callbacks.memAlloc(pTable->callbacks.memArg, sizeof(HashPrimitive_t *)*newSize);
+	if ( !newTable )
+		return;
+	memset(newTable, 0, sizeof(HashPrimitive_t *)*newSize);
+	pTable->oldTable = pTable->hashTable;
+	pTable->oldTableSize = pTable->hashTableSize;
+	pTable->rehashIdx = 0;
+	pTable->hashTable = newTable;
+	pTable->hashTableSize = newSize;
+}
+
+HashErrors_t libHashSetLoadFactors(HashRoot_t *pTable, int growLoad, int shrinkLoad)
+{
+	HashErrors_t err1, err2=HashSuccess;
+
+	/* Shrinking halves the table, so the shrink load must be well under half the grow load or it would thrash */
+	if ( !pTable || growLoad < 0 || shrinkLoad < 0 || (growLoad && shrinkLoad*2 >= growLoad) )
+		return HashInvalidParam;
+	if ( !(err1 = libHashLock(pTable)) )
+	{
+		pTable->growLoad = growLoad;
+		pTable->shrinkLoad = shrinkLoad;
+		err2 = libHashUnlock(pTable);
+	}
+	return err1 ? err1 : err2;
+}
+
 HashErrors_t libHashReplace(HashRoot_t *pTable, const HashEntry_t entry, HashEntry_t *pExisting)
 {
 	HashPrimitive_t *pHashEntry;
@@ -290,6 +871,13 @@ HashErrors_t libHashReplace(HashRoot_t *pTable, const HashEntry_t entry, HashEnt
 	/* Lock the hash table for the search */ 
 	if ( !(err1 = libHashLock(pTable)) )
 	{
+		if ( pTable->ctrl )
+		{
+			err1 = flatPut(pTable, entry, pExisting, 1);
+			err2 = libHashUnlock(pTable);
+			return err1 ? err1 : err2;
+		}
+		rehashStep(pTable);
 		/* Look for the current entry */
 		pHashEntry = findPlace(pTable,entry,&fTbl);
 		if ( !pHashEntry )
@@ -300,7 +888,9 @@ HashErrors_t libHashReplace(HashRoot_t *pTable, const HashEntry_t entry, HashEnt
 				return HashOutOfMemory;
 			}
 			pHashEntry->entry = entry;
+			pHashEntry->hash = fTbl.hash;
 			internalInsert(pTable, &fTbl, pHashEntry);
+			checkResize(pTable);
 		}
 		else
 		{
@@ -325,6 +915,13 @@ HashErrors_t libHashInsert(HashRoot_t *pTable, const HashEntry_t entry)
 		return HashInvalidParam; 
 	if ( !(err1=libHashLock(pTable)) )
 	{
+		if ( pTable->ctrl )
+		{
+			err1 = flatPut(pTable, entry, NULL, 0);
+			err2 = libHashUnlock(pTable);
+			return err1 ? err1 : err2;
+		}
+		rehashStep(pTable);
 		pHashEntry = findPlace(pTable, entry, &fTbl);
 		if ( pHashEntry )
 		{
@@ -337,7 +934,9 @@ HashErrors_t libHashInsert(HashRoot_t *pTable, const HashEntry_t entry)
 			return HashOutOfMemory;
 		}
 		pHashEntry->entry = entry;
+		pHashEntry->hash = fTbl.hash;
 		internalInsert(pTable,&fTbl,pHashEntry);
+		checkResize(pTable);
 		err2 = libHashUnlock(pTable);
 	}
 	return err1 ? err1 : err2;
@@ -347,12 +946,27 @@ HashErrors_t libHashDelete(HashRoot_t *pTable, HashEntry_t entry, HashEntry_t *p
 {
 	HashPrimitive_t *pHashEntry;
 	FindTbl_t fTbl;
+	int idx;
 	
 	if ( pExisting )
 		*pExisting = NULL;
 	if ( !pTable || !entry )
 		return HashInvalidParam;
 	pthread_mutex_lock(&pTable->lock);
+	if ( pTable->ctrl )
+	{
+		if ( (idx = flatFind(pTable, entry, entryHash(pTable, entry), NULL)) < 0 )
+		{
+			pthread_mutex_unlock(&pTable->lock);
+			return HashNoSuchSymbol;
+		}
+		if ( pExisting )
+			*pExisting = pTable->slots[idx];
+		flatDelete(pTable, idx);
+		pthread_mutex_unlock(&pTable->lock);
+		return HashSuccess;
+	}
+	rehashStep(pTable);
 	pHashEntry = findPlace(pTable,entry,&fTbl);
 	if ( !pHashEntry )
 	{
@@ -368,10 +982,11 @@ HashErrors_t libHashDelete(HashRoot_t *pTable, HashEntry_t entry, HashEntry_t *p
 	if ( pExisting )
 		*pExisting = pHashEntry->entry;
 	pHashEntry->entry = NULL;
-	pHashEntry->next = NULL;
 	pHashEntry->prev = NULL;
-	pTable->callbacks.memFree(pTable->callbacks.memArg,pHashEntry);
+	pHashEntry->next = pTable->freeList;
+	pTable->freeList = pHashEntry;
 	--pTable->numEntries;
+	checkResize(pTable);
 	pthread_mutex_unlock(&pTable->lock);
 	return HashSuccess;
 }
@@ -380,6 +995,7 @@ HashErrors_t libHashFind(HashRoot_t *pTable, HashEntry_t entry, HashEntry_t *pEx
 {
 	HashPrimitive_t *pHashEntry;
 	FindTbl_t fTbl;
+	int idx;
 	
 	if ( pExisting )
 		*pExisting = NULL;
@@ -387,6 +1003,16 @@ HashErrors_t libHashFind(HashRoot_t *pTable, HashEntry_t entry, HashEntry_t *pEx
 		return HashInvalidParam;
 	if ( !alreadyLocked )
 		pthread_mutex_lock(&pTable->lock);
+	if ( pTable->ctrl )
+	{
+		idx = flatFind(pTable, entry, entryHash(pTable, entry), NULL);
+		if ( idx >= 0 && pExisting )
+			*pExisting = pTable->slots[idx];
+		if ( !alreadyLocked )
+			pthread_mutex_unlock(&pTable->lock);
+		return idx >= 0 ? HashSuccess : HashNoSuchSymbol;
+	}
+	rehashStep(pTable);
 	pHashEntry = findPlace(pTable,entry,&fTbl);
 	if ( !pHashEntry )
 	{
@@ -410,9 +1036,15 @@ int libHashWalk(HashRoot_t *pTable, HashWalkCallback_t callback_fn, void *pUserD
 		return HashInvalidParam;
 	if ( !alreadyLocked )
 		pthread_mutex_lock(&pTable->lock);
-	for (ii=0; ii < pTable->hashTableSize; ++ii)
+	for (ii=0; pTable->ctrl && ii < pTable->hashTableSize && !err; ++ii)
 	{
-		pHashEntry = pTable->hashTable[ii];
+		if ( !(pTable->ctrl[ii] & 0x80) && (err = callback_fn(pTable->slots[ii], pUserData)) )
+			err += HashMaxError;
+	}
+	for (ii = pTable->oldTable ? -pTable->oldTableSize : 0; pTable->hashTable && ii < pTable->hashTableSize && !err; ++ii)
+	{
+		/* Negative indices are the old table (while resizing) */
+		pHashEntry = ii < 0 ? pTable->oldTable[pTable->oldTableSize + ii] : pTable->hashTable[ii];
 		while ( pHashEntry )
 		{
 			err = callback_fn(pHashEntry->entry, pUserData);
@@ -436,12 +1068,29 @@ void libHashDump(HashRoot_t *pTable, HashDumpCallback_t callback_fn, void *pUser
 		int ii;
 
 		pthread_mutex_lock(&pTable->lock);
-		for (ii=0; ii < pTable->hashTableSize; ++ii)
+		for (ii=pTable->rehashIdx; pTable->oldTable && ii < pTable->oldTableSize; ++ii)
+		{
+			HashPrimitive_t *pHashEntry;
+			if ( (pHashEntry = pTable->oldTable[ii]) )
+				callback_fn(pUserData, ii, pHashEntry);
+		}
+		for (ii=0; pTable->hashTable && ii < pTable->hashTableSize; ++ii)
 		{
 			HashPrimitive_t *pHashEntry;
 			if ( (pHashEntry = pTable->hashTable[ii]) )
 				callback_fn(pUserData, ii, pHashEntry);
 		}
+		for (ii=0; pTable->ctrl && ii < pTable->hashTableSize; ++ii)
+		{
+			/* Flat slots hold one entry each so hand them over as a chain of one */
+			HashPrimitive_t prim;
+			if ( !(pTable->ctrl[ii] & 0x80) )
+			{
+				prim.next = prim.prev = NULL;
+				prim.entry = pTable->slots[ii];
+				callback_fn(pUserData, ii, &prim);
+			}
+		}
 		pthread_mutex_unlock(&pTable->lock);
 	}
 }
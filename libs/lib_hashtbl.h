@@ -19,9 +19,11 @@
 #define _LIB_HASHTBL_H_ (1)
 
 #include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #ifndef POOL_BLOCK_SIZE
-#define POOL_BLOCK_SIZE (128)
+#define POOL_BLOCK_SIZE (128)	/*! number of HashPrimitive_t's allocated at a time */
 #endif
 #ifndef n_elts
 #define n_elts(x) (int)(sizeof(x)/sizeof((x)[0]))
@@ -41,6 +43,7 @@ typedef struct HashPrimitive_t
 	struct HashPrimitive_t *next;
 	struct HashPrimitive_t *prev;
 	HashEntry_t entry;
+	unsigned int hash;			/*! hash of entry (chains are sorted by this) */
 } HashPrimitive_t;
 
 typedef enum
@@ -92,7 +95,12 @@ typedef enum
  *  	  to return an unsigned int with the result of the hash
  *  	  of the supplied 'entry'. The result must be >= 0 and <
  *  	  hashTableSize. The pointer symArg will be delivered to
- *  	  the symHash function when called.
+ *  	  the symHash function when called. The hash lib wants
+ *  	  all the bits it can get so it always passes a
+ *  	  hashTableSize of 0x7FFFFFFF (not the size of the
+ *  	  table) and picks the chain itself. It hashes each
+ *  	  entry once per call and keeps the result so symCmp is
+ *  	  only called on entries with the same hash.
  **/
 typedef struct
 {
@@ -106,8 +114,40 @@ typedef struct
 	void *symArg;									/*! Argument that will be passed to symHash() and symCmp() */
 } HashCallbacks_t;
 
+/** libHashStrHash, libHashStrCmp - ready made symHash and
+ *  symCmp callbacks for entries whose first member is a
+ *  pointer to a null terminated string key. I.e.:
+ *
+ *  	typedef struct { const char *name; ... } MyEntry_t;
+ *
+ *  Set both of them in HashCallbacks_t and set symArg to NULL
+ *  or to point to a uint64_t seed for the hash. A seed picked at
+ *  random keeps anyone who can choose the keys from making them
+ *  all land in the same place.
+ *
+ *  @note libHashStrHash uses libHashBytes(). libHashStrCmp
+ *  	  is strcmp() on the two keys.
+ **/
+extern unsigned int libHashStrHash(void *symArg, int hashTableSize, const HashEntry_t entry);
+extern int libHashStrCmp(void *symArg, const HashEntry_t aa, const HashEntry_t bb);
+
+/** libHashBytes - hash an array of bytes.
+ *
+ *  At entry:
+ *  @param key - pointer to bytes to hash
+ *  @param len - number of bytes
+ *  @param seed - any value. Different seeds give unrelated
+ *  			hashes.
+ *
+ *  At exit:
+ *  @return 64 bit hash (wyhash).
+ **/
+extern uint64_t libHashBytes(const void *key, size_t len, uint64_t seed);
+
 #define HASHTBL_VERBOSE_ERROR (0x01)	/*! set this flag in verbose to emit error messages directly */
 
+#define HASHTBL_FLG_FLAT (0x01)			/*! libHashInitEx(): keep entries in a flat, open addressed table instead of chains */
+
 /** HashRoot_t - the principal structure containing all the
  *  details of the hash table. With the exception of pUser1 and
  *  pUser2, user code ought not alter any of the entries in this
@@ -123,6 +163,19 @@ typedef struct HashRoot_t
 	int hashTableSize;			/*! The size of the hash table */
 	int numEntries;				/*! number of active entries in the hash table (table itself + any chains) */
 	HashPrimitive_t **hashTable;	/*! pointer to hash table which is array of pointers */
+	int minTableSize;			/*! never shrink below this (the size given to libHashInit()) */
+	int growLoad;				/*! grow when numEntries is more than this percentage of hashTableSize (0=never) */
+	int shrinkLoad;				/*! shrink when numEntries is less than this percentage of hashTableSize (0=never) */
+	int oldTableSize;			/*! size of oldTable */
+	int rehashIdx;				/*! next chain in oldTable to move to hashTable */
+	HashPrimitive_t **oldTable;	/*! table being emptied into hashTable while resizing (NULL if not resizing) */
+	int flags;					/*! HASHTBL_FLG_xxx bits given to libHashInitEx() */
+	int numDeleted;				/*! flat table: slots marked deleted */
+	unsigned char *ctrl;		/*! flat table: a control byte per slot (NULL if chained) */
+	HashEntry_t *slots;			/*! flat table: the entries (hashTableSize of them) */
+	struct HashBlock_t *blocks;	/*! blocks of POOL_BLOCK_SIZE chain nodes, newest first */
+	int blockUsed;				/*! nodes handed out from the newest block */
+	HashPrimitive_t *freeList;	/*! deleted nodes ready for reuse (linked through next) */
 } HashRoot_t;
 
 /** libHashErrorString - Get error string.
@@ -138,9 +191,12 @@ extern const char *libHashErrorString(HashErrors_t error);
 /** libHashInit - Inialize the hash functions.
  *
  *  At entry:
- *  @param tableSize - size of hash table. Probably for best
- *  			results, this should be a prime number. If this
- *  			is 0, defaults to 997.
+ *  @param tableSize - initial size of hash table. Probably for
+ *  			best results, this should be a prime number. If
+ *  			this is 0, defaults to 997. The table grows and
+ *  			shrinks with the number of entries (see
+ *  			libHashSetLoadFactors()) but never gets smaller
+ *  			than this.
  *  @param callbacks - pointer to list of various callback
  *  				 functions.
  *
@@ -152,6 +208,54 @@ extern const char *libHashErrorString(HashErrors_t error);
  **/
 extern HashRoot_t* libHashInit(int tableSize, const HashCallbacks_t *callbacks );
 
+/** libHashInitEx - Same as libHashInit() but with a choice of
+ *  how the table is laid out.
+ *
+ *  At entry:
+ *  @param tableSize - as for libHashInit(). A flat table rounds
+ *  			it up to a power of 2 number of slots.
+ *  @param callbacks - as for libHashInit().
+ *  @param flags - 0 or HASHTBL_FLG_FLAT.
+ *
+ *  At exit:
+ *  @return same as libHashInit().
+ *
+ *  @note With HASHTBL_FLG_FLAT the entries are kept in one array
+ *  	  with a byte per entry holding 7 bits of its hash, and
+ *  	  16 of those bytes are checked at once (with SSE2 where
+ *  	  available) before symCmp is called. When 7/8 of
+ *  	  the slots are used (entries and deleted markers) the
+ *  	  table is rebuilt in one go, doubling in size unless
+ *  	  most of those were deleted markers, so growLoad does
+ *  	  not apply to it. libHashDump() hands the callback each
+ *  	  entry as a chain of one.
+ **/
+extern HashRoot_t* libHashInitEx(int tableSize, const HashCallbacks_t *callbacks, int flags);
+
+/** libHashSetLoadFactors - set when the hash table resizes.
+ *
+ *  At entry:
+ *  @param pTable - pointer to hash table root.
+ *  @param growLoad - the table grows to about twice its size
+ *  				when the number of entries goes over this
+ *  				percentage of its size. 0 means never grow.
+ *  				Defaults to 100.
+ *  @param shrinkLoad - the table shrinks to about half its size
+ *  				  when the number of entries drops under this
+ *  				  percentage of its size. 0 means never
+ *  				  shrink. Must be less than half of growLoad.
+ *  				  Defaults to 25.
+ *
+ *  At exit:
+ *  @return 0 on success else error code.
+ *
+ *  @note The entries are moved to the resized table a few
+ *  	  chains at a time by each following insert, replace,
+ *  	  delete and find so no one call pays for the whole
+ *  	  move.
+ **/
+extern HashErrors_t libHashSetLoadFactors(HashRoot_t *pTable, int growLoad, int shrinkLoad);
+
 /** libHashDestroy - Free all the memory in the hash table.
  *
  *  At Entry:
@@ -292,6 +396,8 @@ extern int libHashWalk(HashRoot_t *pTable, HashWalkCallback_t callback_fn, void
  *  	  entry returned is of type HashPrimitive_t so the
  *  	  callback function will have to follow the next links
  *  	  itself to get each of the members in the hash table.
+ *  	  While a resize is in progress the chains still in the
+ *  	  old table are given first, with their old indices.
  *
  *  @note If alreadyLocked==0, the hashtable will be locked for
  *  	  the entire transaction. To preserve the continuity of
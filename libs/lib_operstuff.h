@@ -0,0 +1,261 @@
+/*
+    lib_operstuff.h - Part of the lib_exprs samples.
+    Copyright (C) 2025 David Shepperd
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**************************************************************************
+ * @note This file is produced by a separate program called mk_operstuff. *
+ * Any manual edits made to this file will likely be lost during the next *
+ * build. Edit mk_operstuff.c and/or lib_operstuff.dat to make any        *
+ * necessary changes to these lists.                                      *
+ **************************************************************************/
+
+
+
+/* numLines=36, __SIZEOF_SIZE_T__=8, __SIZEOF_INT__=4, __SIZEOF_LONG__=8 */
+/* sizeof(char)=1, sizeof(int)=4, sizeof(long)=8, sizeof(void *)=8 */
+/* sizeof(int8_t)=1, sizeof(int16_t)=2, sizeof(int32_t)=4 */
+/* sizeof(sizeof)=8, sizeof(size_t)=8, sizeof(time_t)=8 */
+
+#if OPERSTUFF_GET_ENUM
+typedef enum
+{
+    EXPRS_TERM_NULL	/* (NULL) */
+   ,EXPRS_TERM_SYMBOL	/* (Symbol) */
+   ,EXPRS_TERM_SYMBOL_COMPLEX	/* (Complex symbol) */
+   ,EXPRS_TERM_FUNCTION	/* (function call; not supported yet) */
+   ,EXPRS_TERM_STRING	/* (string) */
+   ,EXPRS_TERM_FLOAT	/* (float) */
+   ,EXPRS_TERM_INTEGER	/* (integer) */
+   ,EXPRS_TERM_NEG	/* - (neg) */
+   ,EXPRS_TERM_POS	/* + (pos) */
+   ,EXPRS_TERM_COM	/* ~ (comp) */
+   ,EXPRS_TERM_NOT	/* ! (not) */
+   ,EXPRS_TERM_LOW_BYTE	/* ^v (low byte) */
+   ,EXPRS_TERM_HIGH_BYTE	/* ^^ (high byte) */
+   ,EXPRS_TERM_SWAP	/* ^~ (swap) */
+   ,EXPRS_TERM_POW	/* ** (power) */
+   ,EXPRS_TERM_MUL	/* * (mul) */
+   ,EXPRS_TERM_DIV	/* / (div) */
+   ,EXPRS_TERM_MOD	/* % (mod) */
+   ,EXPRS_TERM_ADD	/* + (add) */
+   ,EXPRS_TERM_SUB	/* - (sub) */
+   ,EXPRS_TERM_SHL	/* << (shl) */
+   ,EXPRS_TERM_SHR	/* >> (shr) */
+   ,EXPRS_TERM_GT	/* > (gt) */
+   ,EXPRS_TERM_GE	/* >= (ge) */
+   ,EXPRS_TERM_LT	/* < (lt) */
+   ,EXPRS_TERM_LE	/* <= (le) */
+   ,EXPRS_TERM_EQ	/* == (eq) */
+   ,EXPRS_TERM_NE	/* != (ne) */
+   ,EXPRS_TERM_AND	/* & (and) */
+   ,EXPRS_TERM_XOR	/* ^ (xor) */
+   ,EXPRS_TERM_OR	/* | (or) */
+   ,EXPRS_TERM_LAND	/* && (land) */
+   ,EXPRS_TERM_LOR	/* || (lor) */
+   ,EXPRS_TERM_ASSIGN	/* = (assign) */
+   ,EXPRS_TERM_SKIP_FALSE	/* ?&& (skip if false) */
+   ,EXPRS_TERM_SKIP_TRUE	/* ?|| (skip if true) */
+} ExprsTermTypes_t;
+
+typedef enum
+{
+    EXPR_TERM_GOOD	/* "Success" */
+   ,EXPR_TERM_END	/* "End of expression" */
+   ,EXPR_TERM_BAD_NO_STRING_TERM	/* "Not a string term" */
+   ,EXPR_TERM_BAD_STRING_TOO_LONG	/* "String too long" */
+   ,EXPR_TERM_BAD_STRINGS_NOT_SUPPORTED	/* "Function not supported" */
+   ,EXPR_TERM_BAD_SYMBOL_SYNTAX	/* "Bad symbol syntax" */
+   ,EXPR_TERM_BAD_SYMBOL_TOO_LONG	/* "Symbol name too long" */
+   ,EXPR_TERM_BAD_NUMBER	/* "Bad number syntax" */
+   ,EXPR_TERM_BAD_UNARY	/* "Bad unary" */
+   ,EXPR_TERM_BAD_OPER	/* "Undefined operator" */
+   ,EXPR_TERM_BAD_SYNTAX	/* "Unrecognized syntax" */
+   ,EXPR_TERM_BAD_TOO_MANY_TERMS	/* "Too many terms" */
+   ,EXPR_TERM_BAD_TOO_FEW_TERMS	/* "Too few terms" */
+   ,EXPR_TERM_BAD_NO_TERMS	/* "No terms found" */
+   ,EXPR_TERM_BAD_NO_CLOSE	/* "No expression close" */
+   ,EXPR_TERM_BAD_UNSUPPORTED	/* "Unsupported function" */
+   ,EXPR_TERM_BAD_DIV_BY_0	/* "Divide by 0" */
+   ,EXPR_TERM_BAD_PARAMETER	/* "Invalid parameter value" */
+   ,EXPR_TERM_BAD_UNDEFINED	/* "Undefined expression context" */
+   ,EXPR_TERM_BAD_OUT_OF_MEMORY	/* "Ran out of memory" */
+   ,EXPR_TERM_BAD_UNDEFINED_SYMBOL	/* "Undefined symbol" */
+   ,EXPR_TERM_BAD_NO_SYMBOLS	/* "No symbol handler" */
+   ,EXPR_TERM_BAD_SYMBOL_TABLE_FULL	/* "Symbol table is full" */
+   ,EXPR_TERM_BAD_LVALUE	/* "lvalue is not a symbol" */
+   ,EXPR_TERM_BAD_RVALUE	/* "result of expression is not an integer or float or string" */
+   ,EXPR_TERM_BAD_NOLOCK	/* "Failed to lock pthread mutex" */
+   ,EXPR_TERM_BAD_NOUNLOCK	/* "Failed to unlock pthread mutex" */
+   ,EXPR_TERM_BAD_CYCLE	/* "Symbol depends on itself" */
+} ExprsErrs_t;
+#undef OPERSTUFF_GET_ENUM
+#endif
+
+#if OPERSTUFF_GET_OTHERS
+static const char *OperDescriptions[] =
+{
+    "(NULL)"	/* EXPRS_TERM_NULL: (NULL) */
+   ,"(Symbol)"	/* EXPRS_TERM_SYMBOL: (Symbol) */
+   ,"(Complex symbol)"	/* EXPRS_TERM_SYMBOL_COMPLEX: (Complex symbol) */
+   ,"(function call; not supported yet)"	/* EXPRS_TERM_FUNCTION: (function call; not supported yet) */
+   ,"(string)"	/* EXPRS_TERM_STRING: (string) */
+   ,"(float)"	/* EXPRS_TERM_FLOAT: (float) */
+   ,"(integer)"	/* EXPRS_TERM_INTEGER: (integer) */
+   ,"- (neg)"	/* EXPRS_TERM_NEG: - (neg) */
+   ,"+ (pos)"	/* EXPRS_TERM_POS: + (pos) */
+   ,"~ (comp)"	/* EXPRS_TERM_COM: ~ (comp) */
+   ,"! (not)"	/* EXPRS_TERM_NOT: ! (not) */
+   ,"^v (low byte)"	/* EXPRS_TERM_LOW_BYTE: ^v (low byte) */
+   ,"^^ (high byte)"	/* EXPRS_TERM_HIGH_BYTE: ^^ (high byte) */
+   ,"^~ (swap)"	/* EXPRS_TERM_SWAP: ^~ (swap) */
+   ,"** (power)"	/* EXPRS_TERM_POW: ** (power) */
+   ,"* (mul)"	/* EXPRS_TERM_MUL: * (mul) */
+   ,"/ (div)"	/* EXPRS_TERM_DIV: / (div) */
+   ,"% (mod)"	/* EXPRS_TERM_MOD: % (mod) */
+   ,"+ (add)"	/* EXPRS_TERM_ADD: + (add) */
+   ,"- (sub)"	/* EXPRS_TERM_SUB: - (sub) */
+   ,"<< (shl)"	/* EXPRS_TERM_SHL: << (shl) */
+   ,">> (shr)"	/* EXPRS_TERM_SHR: >> (shr) */
+   ,"> (gt)"	/* EXPRS_TERM_GT: > (gt) */
+   ,">= (ge)"	/* EXPRS_TERM_GE: >= (ge) */
+   ,"< (lt)"	/* EXPRS_TERM_LT: < (lt) */
+   ,"<= (le)"	/* EXPRS_TERM_LE: <= (le) */
+   ,"== (eq)"	/* EXPRS_TERM_EQ: == (eq) */
+   ,"!= (ne)"	/* EXPRS_TERM_NE: != (ne) */
+   ,"& (and)"	/* EXPRS_TERM_AND: & (and) */
+   ,"^ (xor)"	/* EXPRS_TERM_XOR: ^ (xor) */
+   ,"| (or)"	/* EXPRS_TERM_OR: | (or) */
+   ,"&& (land)"	/* EXPRS_TERM_LAND: && (land) */
+   ,"|| (lor)"	/* EXPRS_TERM_LOR: || (lor) */
+   ,"= (assign)"	/* EXPRS_TERM_ASSIGN: = (assign) */
+   ,"?&& (skip if false)"	/* EXPRS_TERM_SKIP_FALSE: ?&& (skip if false) */
+   ,"?|| (skip if true)"	/* EXPRS_TERM_SKIP_TRUE: ?|| (skip if true) */
+};
+
+static const ExprsPrecedence_t PrecedenceNormal[] =
+{
+    20	/* EXPRS_TERM_NULL: (NULL) */
+   ,20	/* EXPRS_TERM_SYMBOL: (Symbol) */
+   ,20	/* EXPRS_TERM_SYMBOL_COMPLEX: (Complex symbol) */
+   ,20	/* EXPRS_TERM_FUNCTION: (function call; not supported yet) */
+   ,20	/* EXPRS_TERM_STRING: (string) */
+   ,20	/* EXPRS_TERM_FLOAT: (float) */
+   ,20	/* EXPRS_TERM_INTEGER: (integer) */
+   ,18	/* EXPRS_TERM_NEG: - (neg) */
+   ,18	/* EXPRS_TERM_POS: + (pos) */
+   ,18	/* EXPRS_TERM_COM: ~ (comp) */
+   ,18	/* EXPRS_TERM_NOT: ! (not) */
+   ,16	/* EXPRS_TERM_LOW_BYTE: ^v (low byte) */
+   ,16	/* EXPRS_TERM_HIGH_BYTE: ^^ (high byte) */
+   ,16	/* EXPRS_TERM_SWAP: ^~ (swap) */
+   ,16	/* EXPRS_TERM_POW: ** (power) */
+   ,14	/* EXPRS_TERM_MUL: * (mul) */
+   ,14	/* EXPRS_TERM_DIV: / (div) */
+   ,14	/* EXPRS_TERM_MOD: % (mod) */
+   ,12	/* EXPRS_TERM_ADD: + (add) */
+   ,12	/* EXPRS_TERM_SUB: - (sub) */
+   ,10	/* EXPRS_TERM_SHL: << (shl) */
+   ,10	/* EXPRS_TERM_SHR: >> (shr) */
+   , 8	/* EXPRS_TERM_GT: > (gt) */
+   , 8	/* EXPRS_TERM_GE: >= (ge) */
+   , 8	/* EXPRS_TERM_LT: < (lt) */
+   , 8	/* EXPRS_TERM_LE: <= (le) */
+   , 8	/* EXPRS_TERM_EQ: == (eq) */
+   , 8	/* EXPRS_TERM_NE: != (ne) */
+   , 6	/* EXPRS_TERM_AND: & (and) */
+   , 5	/* EXPRS_TERM_XOR: ^ (xor) */
+   , 4	/* EXPRS_TERM_OR: | (or) */
+   , 3	/* EXPRS_TERM_LAND: && (land) */
+   , 2	/* EXPRS_TERM_LOR: || (lor) */
+   , 0	/* EXPRS_TERM_ASSIGN: = (assign) */
+   , 0	/* EXPRS_TERM_SKIP_FALSE: ?&& (skip if false) */
+   , 0	/* EXPRS_TERM_SKIP_TRUE: ?|| (skip if true) */
+};
+
+static const ExprsPrecedence_t PrecedenceNone[] =
+{
+    20	/* EXPRS_TERM_NULL: (NULL) */
+   ,20	/* EXPRS_TERM_SYMBOL: (Symbol) */
+   ,20	/* EXPRS_TERM_SYMBOL_COMPLEX: (Complex symbol) */
+   ,20	/* EXPRS_TERM_FUNCTION: (function call; not supported yet) */
+   ,20	/* EXPRS_TERM_STRING: (string) */
+   ,20	/* EXPRS_TERM_FLOAT: (float) */
+   ,20	/* EXPRS_TERM_INTEGER: (integer) */
+   ,18	/* EXPRS_TERM_NEG: - (neg) */
+   ,18	/* EXPRS_TERM_POS: + (pos) */
+   ,18	/* EXPRS_TERM_COM: ~ (comp) */
+   ,18	/* EXPRS_TERM_NOT: ! (not) */
+   ,18	/* EXPRS_TERM_LOW_BYTE: ^v (low byte) */
+   ,18	/* EXPRS_TERM_HIGH_BYTE: ^^ (high byte) */
+   ,18	/* EXPRS_TERM_SWAP: ^~ (swap) */
+   ,18	/* EXPRS_TERM_POW: ** (power) */
+   , 7	/* EXPRS_TERM_MUL: * (mul) */
+   , 7	/* EXPRS_TERM_DIV: / (div) */
+   , 7	/* EXPRS_TERM_MOD: % (mod) */
+   , 7	/* EXPRS_TERM_ADD: + (add) */
+   , 7	/* EXPRS_TERM_SUB: - (sub) */
+   , 7	/* EXPRS_TERM_SHL: << (shl) */
+   , 7	/* EXPRS_TERM_SHR: >> (shr) */
+   , 7	/* EXPRS_TERM_GT: > (gt) */
+   , 7	/* EXPRS_TERM_GE: >= (ge) */
+   , 7	/* EXPRS_TERM_LT: < (lt) */
+   , 7	/* EXPRS_TERM_LE: <= (le) */
+   , 7	/* EXPRS_TERM_EQ: == (eq) */
+   , 7	/* EXPRS_TERM_NE: != (ne) */
+   , 7	/* EXPRS_TERM_AND: & (and) */
+   , 7	/* EXPRS_TERM_XOR: ^ (xor) */
+   , 7	/* EXPRS_TERM_OR: | (or) */
+   , 7	/* EXPRS_TERM_LAND: && (land) */
+   , 7	/* EXPRS_TERM_LOR: || (lor) */
+   , 0	/* EXPRS_TERM_ASSIGN: = (assign) */
+   , 0	/* EXPRS_TERM_SKIP_FALSE: ?&& (skip if false) */
+   , 0	/* EXPRS_TERM_SKIP_TRUE: ?|| (skip if true) */
+};
+
+static const char *ErrorDescriptions[] =
+{
+    "Success"	/* EXPR_TERM_GOOD */
+   ,"End of expression"	/* EXPR_TERM_END */
+   ,"Not a string term"	/* EXPR_TERM_BAD_NO_STRING_TERM */
+   ,"String too long"	/* EXPR_TERM_BAD_STRING_TOO_LONG */
+   ,"Function not supported"	/* EXPR_TERM_BAD_STRINGS_NOT_SUPPORTED */
+   ,"Bad symbol syntax"	/* EXPR_TERM_BAD_SYMBOL_SYNTAX */
+   ,"Symbol name too long"	/* EXPR_TERM_BAD_SYMBOL_TOO_LONG */
+   ,"Bad number syntax"	/* EXPR_TERM_BAD_NUMBER */
+   ,"Bad unary"	/* EXPR_TERM_BAD_UNARY */
+   ,"Undefined operator"	/* EXPR_TERM_BAD_OPER */
+   ,"Unrecognized syntax"	/* EXPR_TERM_BAD_SYNTAX */
+   ,"Too many terms"	/* EXPR_TERM_BAD_TOO_MANY_TERMS */
+   ,"Too few terms"	/* EXPR_TERM_BAD_TOO_FEW_TERMS */
+   ,"No terms found"	/* EXPR_TERM_BAD_NO_TERMS */
+   ,"No expression close"	/* EXPR_TERM_BAD_NO_CLOSE */
+   ,"Unsupported function"	/* EXPR_TERM_BAD_UNSUPPORTED */
+   ,"Divide by 0"	/* EXPR_TERM_BAD_DIV_BY_0 */
+   ,"Invalid parameter value"	/* EXPR_TERM_BAD_PARAMETER */
+   ,"Undefined expression context"	/* EXPR_TERM_BAD_UNDEFINED */
+   ,"Ran out of memory"	/* EXPR_TERM_BAD_OUT_OF_MEMORY */
+   ,"Undefined symbol"	/* EXPR_TERM_BAD_UNDEFINED_SYMBOL */
+   ,"No symbol handler"	/* EXPR_TERM_BAD_NO_SYMBOLS */
+   ,"Symbol table is full"	/* EXPR_TERM_BAD_SYMBOL_TABLE_FULL */
+   ,"lvalue is not a symbol"	/* EXPR_TERM_BAD_LVALUE */
+   ,"result of expression is not an integer or float or string"	/* EXPR_TERM_BAD_RVALUE */
+   ,"Failed to lock pthread mutex"	/* EXPR_TERM_BAD_NOLOCK */
+   ,"Failed to unlock pthread mutex"	/* EXPR_TERM_BAD_NOUNLOCK */
+   ,"Symbol depends on itself"	/* EXPR_TERM_BAD_CYCLE */
+};
+#undef OPERSTUFF_GET_OTHERS
+#endif
@@ -14,6 +14,7 @@
 #include "exprs_test_ht.h"
 #include "exprs_test_nos.h"
 #include "exprs_test_walk.h"
+#include "exprs_test_file.h"
 
 enum
 {
@@ -26,6 +27,9 @@ enum
 	OPT_FLAGS,
 	OPT_RADIX,
 	OPT_WALK,
+	OPT_FILE,
+	OPT_THREADS,
+	OPT_FLAT,
 	OPT_HELP,
 	OPT_MAX
 };
@@ -42,6 +46,9 @@ static struct option long_options[] =
 				   {"test",		  no_argument,		 0, OPT_TEST },
 				   {"verbose",    no_argument,       0, OPT_VERBOSE },
 				   {"walk",       no_argument,       0, OPT_WALK },
+				   {"file",       required_argument, 0, OPT_FILE },
+				   {"threads",    required_argument, 0, OPT_THREADS },
+				   {"flat",       no_argument,       0, OPT_FLAT },
 				   {0,         0,                 0,  0 }
                };
 
@@ -72,12 +79,15 @@ static const char FlagsDescription[] =
 "0x00400000	= Term cannot be double plain\n"
 "0x00800000	= Open delimiter ends expression\n"
 "0x01000000	= Close delimiter ends expression\n"
+"0x02000000	= Fold constant subexpressions when compiling or parsing to RPN (-w)\n"
+"0x04000000	= Compile integer only statements to native code (x86-64 only)\n"
 ;
 
 static int helpEm(const char *ourName)
 {
-	fprintf(stderr, "Usage: %s [-b num][-e exp][-i incs][-f flags][-r radix][-s hashSize][-htvw] expression\n",
-		   ourName);
+	fprintf(stderr, "Usage: %s [-b num][-e exp][-i incs][-f flags][-r radix][-s hashSize][-htvw][--flat] expression\n"
+			"   or: %s [-b num][-i incs][-f flags][-r radix][-s hashSize][-v][--flat][--threads=num] --file=name\n",
+		   ourName, ourName);
 	fprintf(stderr,"Where:\n"
 			"-b num   [or --btree=num]    test using btree symbols. num=maxSize.\n"
 			"-e expr  [or --expr=expr]    pass expression (use if expression has leading -)\n"
@@ -89,6 +99,11 @@ static int helpEm(const char *ourName)
 			"-t       [or --test]         execute the full expressin parser tester\n"
 			"-v       [or --verbose]      increment verbose mode\n"
 			"-w       [or --walk]         use the walk feature\n"
+			"--file=name                  evaluate each line of file 'name' against one symbol table\n"
+			"                             (btree if -b, else hash) and report lines/sec\n"
+			"--threads=num                with --file, evaluate independent lines (no assignments)\n"
+			"                             over num threads. Output stays in input order\n"
+			"--flat                       use the flat (open addressed) hash table instead of chains\n"
 			"\n"
 			);
 	fputs(FlagsDescription, stderr);
@@ -108,6 +123,9 @@ int main(int argc, char *argv[])
 	unsigned long flags=0;
 	char *endp;
 	const char *exprs=NULL;
+	const char *fileName=NULL;
+	int threads=0;
+	int hashFlags=0;
 	
 	opt_index = 0;
 	while ((opt = getopt_long_only(argc, argv, "b:e:hi:f:r:s:tvw", long_options, &opt_index)) != -1)
@@ -163,6 +181,21 @@ int main(int argc, char *argv[])
 		case OPT_WALK:
 			walk = 1;
 			break;
+		case OPT_FILE:
+			fileName = optarg;
+			break;
+		case OPT_THREADS:
+			endp = NULL;
+			threads = strtoul(optarg,&endp,0);
+			if ( !endp || *endp || threads < 1 || threads > 256 )
+			{
+				fprintf(stderr,"Invalid argument to --threads: '%s' (can only be 1 to 256)\n", optarg);
+				return 1;
+			}
+			break;
+		case OPT_FLAT:
+			hashFlags |= HASHTBL_FLG_FLAT;
+			break;
 		case '?':
 			printf("Error: getopt(): returned ?. argc=%d, optind=%d (%s)\n", argc, optind, argv[optind] );
 		case 'h':
@@ -189,14 +222,16 @@ int main(int argc, char *argv[])
 	{
 		return exprsTest(verbose);
 	}
+	if ( fileName )
+		return exprsTestFile(incs, btree_size, tblSize, hashFlags, threads, fileName, flags, radix, verbose);
 	if ( exprs || optind < argc )
 	{
 		if ( !exprs )
 			exprs = argv[optind];
 		if ( btree_size )
 			return exprsTestBtree(incs, btree_size, exprs, flags, radix, verbose);
-		if ( tblSize )
-			return exprsTestHashTbl(incs, tblSize, exprs, flags, radix, verbose);
+		if ( tblSize || hashFlags )
+			return exprsTestHashTbl(incs, tblSize, hashFlags, exprs, flags, radix, verbose);
 		if ( walk )
 			return exprsTestWalk(incs,exprs,flags,radix,verbose);
 		return exprsTestNoSym(incs, exprs, flags, radix, verbose);